@@ -8,11 +8,20 @@
  * @example
  *   auto cpu = au::sys::getCpuInfo();
  *   printf("cores: %d, model: %s\n", cpu.coreCount, cpu.modelName.c_str());
+ *   for (const auto& core : cpu.cores)
+ *       printf("cpu%d cluster %d %llu kHz\n", core.id, core.clusterId, (unsigned long long)core.maxFreqKHz);
+ *
+ *   au::sys::setThreadAffinity(au::sys::getPerformanceCores(cpu.cores));
+ *   au::sys::setThreadName("decoder");
+ *
+ *   for (const auto& node : au::sys::getNumaTopology())
+ *       printf("node%d: %zu cpus, %llu MB\n", node.id, node.cpus.size(), (unsigned long long)(node.totalBytes >> 20));
  *
  *   au::sys::setEnv("MY_VAR", "hello");
  *   auto val = au::sys::getEnv("MY_VAR"); // "hello"
  */
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -132,16 +141,155 @@ const char* archName(Arch a);
 
 // ── CPU ──
 
+struct CpuCoreInfo
+{
+    int      id               = 0;     ///< logical CPU number
+    int      clusterId        = 0;     ///< cores sharing a frequency domain (a big.LITTLE cluster)
+    uint64_t maxFreqKHz       = 0;     ///< cpufreq cpuinfo_max_freq; 0 if unknown
+    int      capacity         = 0;     ///< scheduler cpu_capacity (max 1024); 0 if unknown
+    int      sharedCacheLevel = 0;     ///< highest cache level shared with another core; 0 if none
+    bool     online           = true;
+};
+
 struct CpuInfo
 {
-    int         coreCount       = 0;
-    int         onlineCoreCount = 0;
-    std::string modelName;
-    Arch        arch = Arch::Unknown;
+    int                      coreCount       = 0;
+    int                      onlineCoreCount = 0;
+    std::string              modelName;
+    Arch                     arch = Arch::Unknown;
+    std::vector<CpuCoreInfo> cores;  ///< per logical CPU; empty where no topology is exposed
 };
 
 CpuInfo getCpuInfo();
 
+/**
+ * @brief Read the per-core topology from a Linux sysfs cpu directory.
+ *
+ * Cluster ids come from the cpufreq policy (related_cpus) when cores share
+ * policies, else from topology/cluster_id. They are renumbered 0..n-1 in
+ * order of first appearance. Pass another root to read a captured or fake tree.
+ * @return One entry per cpuN directory, sorted by id; empty if unreadable.
+ */
+std::vector<CpuCoreInfo> getCpuTopology(const std::string& sysfsRoot = "/sys/devices/system/cpu");
+
+/**
+ * @brief Ids of the online cores with the highest max frequency (capacity if
+ *        the frequency is unknown): the big cores on big.LITTLE. All online
+ *        cores when nothing distinguishes them.
+ */
+std::vector<int> getPerformanceCores(const std::vector<CpuCoreInfo>& cores);
+
+/** @brief Parse a kernel cpu list such as "0-3,6,8-9". Malformed parts are skipped. */
+std::vector<int> parseCpuList(const std::string& list);
+
+// ── Threads (all act on the calling thread) ──
+
+enum class SchedPolicy
+{
+    Default,     ///< SCHED_OTHER
+    Batch,       ///< SCHED_BATCH: throughput work, fewer preemptions
+    Idle,        ///< SCHED_IDLE: runs only when nothing else wants the CPU
+    Fifo,        ///< SCHED_FIFO (real-time; usually needs privileges)
+    RoundRobin,  ///< SCHED_RR (real-time; usually needs privileges)
+};
+
+/**
+ * @brief Restrict the calling thread to @p cpus.
+ * @return false if unsupported on this platform or rejected by the OS.
+ */
+bool setThreadAffinity(const std::vector<int>& cpus);
+
+/** @brief CPUs the calling thread may run on; empty if unsupported. */
+std::vector<int> getThreadAffinity();
+
+/** @brief Name the calling thread for debuggers and profilers (Linux truncates to 15 chars). */
+bool setThreadName(const std::string& name);
+
+/**
+ * @brief Set the calling thread's scheduling policy.
+ * @param priority Nice value (-20..19) for Default and Batch; real-time
+ *                 priority (1..99) for Fifo and RoundRobin; ignored for Idle.
+ */
+bool setThreadScheduling(SchedPolicy policy, int priority);
+
+// ── NUMA ──
+
+struct NumaNodeInfo
+{
+    int              id         = 0;
+    std::vector<int> cpus;            ///< cpulist of the node
+    uint64_t         totalBytes = 0;  ///< MemTotal of the node; 0 if unknown
+    std::vector<int> distances;       ///< SLIT distance to every node in id order; empty if unknown
+};
+
+/**
+ * @brief Read the NUMA nodes from a Linux sysfs node directory.
+ *
+ * Single-socket machines report one node; non-Linux platforms and kernels
+ * without NUMA support report none. Pass another root to read a captured
+ * or fake tree, as with getCpuTopology().
+ * @return One entry per nodeN directory, sorted by id; empty if unreadable.
+ */
+std::vector<NumaNodeInfo> getNumaTopology(const std::string& sysfsRoot = "/sys/devices/system/node");
+
+/** @brief Logical CPU the calling thread runs on right now; -1 if unsupported. */
+int getCurrentCpu();
+
+/**
+ * @brief Allocate @p bytes of zeroed, page-aligned memory preferring node @p node.
+ *
+ * Uses mmap with an MPOL_PREFERRED mbind on Linux (no libnuma). The binding
+ * is a hint: if the kernel refuses it, or @p node < 0, pages are placed by
+ * first touch as usual. Elsewhere this falls back to calloc.
+ * @return nullptr on failure. Release with freeOnNode() and the same size.
+ */
+void* allocOnNode(size_t bytes, int node);
+
+/** @brief Release memory from allocOnNode(). */
+void freeOnNode(void* ptr, size_t bytes);
+
+// ── Pages ──
+
+enum class HugePages
+{
+    None,         ///< base pages
+    Transparent,  ///< huge-page-aligned mapping with MADV_HUGEPAGE (THP)
+    Explicit,     ///< MAP_HUGETLB from the reserved pool (vm.nr_hugepages); Transparent if none are free
+};
+
+struct PageAllocOptions
+{
+    HugePages hugePages = HugePages::None;
+    bool      populate  = false;  ///< fault every page in at allocation instead of on first touch
+};
+
+/** @brief Base page size in bytes. */
+size_t getPageSize();
+
+/** @brief Default huge page size (Hugepagesize in /proc/meminfo); 0 if unknown. */
+size_t getHugePageSize();
+
+/**
+ * @brief Allocate @p bytes of zeroed anonymous memory straight from mmap.
+ *
+ * Mappings are page aligned, or huge-page aligned when huge pages are asked
+ * for. populate uses MAP_POPULATE (MADV_POPULATE_WRITE or a touch loop for
+ * THP), moving the page-fault cost out of the first pass over the buffer.
+ * Elsewhere this falls back to calloc.
+ * @return nullptr on failure. Release with freePages() and the same size and options.
+ */
+void* allocPages(size_t bytes, const PageAllocOptions& options = PageAllocOptions());
+
+/** @brief Release memory from allocPages(). */
+void freePages(void* ptr, size_t bytes, const PageAllocOptions& options = PageAllocOptions());
+
+/**
+ * @brief Hand the whole pages inside [ptr, ptr + bytes) back to the OS
+ *        (madvise(MADV_DONTNEED)); they read as zero when touched again.
+ * @return false if no whole page lies in the range or the platform lacks it.
+ */
+bool discardPages(void* ptr, size_t bytes);
+
 // ── Memory ──
 
 struct MemoryInfo
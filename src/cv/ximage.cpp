@@ -6,6 +6,7 @@
 #include "log/xerror.h"
 #include "log/xlogger.h"
 #include "math/xmath.h"
+#include "memory/xmemory_resource.h"
 
 namespace au {
 namespace cv {
@@ -24,7 +25,26 @@ static std::map<int, std::string> MapImageFormat{{kXFormatInvalid, "kXFormatInva
                                                  {kXFormatRawU16, "kXFormatRawU16"},
                                                  {kXFormatRawPackedU10, "kXFormatRawPackedU10"}};
 
-Image imageAlloc(void* mempool, uint32_t width, uint32_t height, int format)
+namespace {
+
+/// Plane sizes in bytes as laid out by imageAlloc().
+void planeBytes(const Image& image, size_t bytes[4])
+{
+    for (int i = 0; i < 4; ++i) bytes[i] = 0;
+    bytes[0] = static_cast<size_t>(image.height) * image.stride[0];
+    if (image.format == kXFormatNV12 || image.format == kXFormatNV21) {
+        bytes[1] = static_cast<size_t>(image.height / 2) * image.stride[1];
+    }
+}
+
+/// Planes are cache-line aligned when they come from a resource.
+constexpr size_t kPlaneAlignment = 64;
+
+}  // namespace
+
+void imageFree(au::memory::XMemoryResource* resource, Image& image);
+
+Image imageAlloc(au::memory::XMemoryResource* resource, uint32_t width, uint32_t height, int format)
 {
     XCHECK_WITH_RET(width > 0 && height > 0, Image{0});
     XCHECK_WITH_RET(format > kXFormatInvalid, Image{0});
@@ -39,31 +59,54 @@ Image imageAlloc(void* mempool, uint32_t width, uint32_t height, int format)
 
     if (format == kXFormatGrayU8) {
         image.stride[0] = au::math::ceilTo8(width);
-        image.data[0]   = (uint8_t*)malloc(image.height * image.stride[0]);
     } else if (format == kXFormatGrayU16 || format == kXFormatUV) {
         image.stride[0] = au::math::ceilTo8(width * 2);
-        image.data[0]   = (uint8_t*)malloc(image.height * image.stride[0]);
     } else if (format == kXFormatNV12 || format == kXFormatNV21) {
         image.stride[0] = au::math::ceilTo8(width);
         image.stride[1] = image.stride[0];
-        image.data[0]   = (uint8_t*)malloc(image.height * image.stride[0]);
-        image.data[1]   = (uint8_t*)malloc((image.height / 2) * image.stride[1]);
     } else if (format == kXFormatRGBU8 || format == kXFormatBGRU8) {
         image.stride[0] = au::math::ceilTo8(width * 3);
-        image.data[0]   = (uint8_t*)malloc(image.height * image.stride[0]);
     } else if (format == kXFormatGrayU32 || format == kXFormatRGBAU8 || format == kXFormatBGRAU8) {
         image.stride[0] = au::math::ceilTo8(width * 4);
-        image.data[0]   = (uint8_t*)malloc(image.height * image.stride[0]);
+    } else if (format == kXFormatRawU16) {
+        image.stride[0] = au::math::ceilTo8(width * 2);
+    } else if (format == kXFormatRawPackedU10) {
+        image.stride[0] = au::math::ceilTo8((width * 5 + 3) / 4);  // MIPI RAW10: 4 pixels in 5 bytes
+    }
+
+    size_t bytes[4];
+    planeBytes(image, bytes);
+    for (int i = 0; i < 4; ++i) {
+        if (bytes[i] == 0) continue;
+        image.data[i] = resource ? static_cast<uint8_t*>(resource->allocate(bytes[i], kPlaneAlignment))
+                                 : (uint8_t*)malloc(bytes[i]);
+        if (!image.data[i]) {
+            XLOG_E("imageAlloc: plane %d (%zu bytes) allocation failed\n", i, bytes[i]);
+            imageFree(resource, image);  // release the planes already allocated
+            return Image{0};
+        }
     }
 
     return image;
 }
 
-void imageFree(void* mempool, Image& image)
+/// @p mempool must point at the XMemoryResource base (see ximage.h).
+Image imageAlloc(void* mempool, uint32_t width, uint32_t height, int format)
 {
+    return imageAlloc(static_cast<au::memory::XMemoryResource*>(mempool), width, height, format);
+}
+
+void imageFree(au::memory::XMemoryResource* resource, Image& image)
+{
+    size_t bytes[4];
+    planeBytes(image, bytes);
     for (int i = 0; i < 4; ++i) {
         if (image.data[i]) {
-            free(image.data[i]);
+            if (resource) {
+                resource->deallocate(image.data[i], bytes[i], kPlaneAlignment);
+            } else {
+                free(image.data[i]);
+            }
             image.data[i] = nullptr;
         }
     }
@@ -71,6 +114,11 @@ void imageFree(void* mempool, Image& image)
     memset(&image, 0, sizeof(Image));
 }
 
+void imageFree(void* mempool, Image& image)
+{
+    imageFree(static_cast<au::memory::XMemoryResource*>(mempool), image);
+}
+
 bool isValid(const Image& image)
 {
     bool validFormat = image.format > 0;
@@ -131,12 +179,12 @@ XImage::~XImage() { deleteImage(); }
 
 XImage::XImage(void* mempool, uint32_t width, uint32_t height, int format) : mMempool(nullptr), mIsRaw(false)
 {
-    createImage(mempool, width, height, format);
+    createImage(static_cast<au::memory::XMemoryResource*>(mempool), width, height, format);
 }
 
 XImage::XImage(void* mempool, uint32_t width, uint32_t height, XImageFormat format) : mMempool(nullptr), mIsRaw(false)
 {
-    createImage(mempool, width, height, format);
+    createImage(static_cast<au::memory::XMemoryResource*>(mempool), width, height, format);
 }
 
 XImage::XImage(uint32_t width, uint32_t height, uint32_t stride, int format, uint8_t* data0, uint8_t* data1)
@@ -196,14 +244,14 @@ XImage& XImage::operator=(XImage&& image) noexcept
     return *this;
 }
 
-void XImage::createImage(void* mempool, uint32_t width, uint32_t height, int format)
+void XImage::createImage(au::memory::XMemoryResource* resource, uint32_t width, uint32_t height, int format)
 {
-    Image image = imageAlloc(mempool, width, height, format);
+    Image image = imageAlloc(resource, width, height, format);
 
     if (image.data[0] != nullptr) {
         copyImage(image);
 
-        mMempool     = mempool;
+        mMempool     = resource;
         mNeedDestroy = true;
     }
 }
@@ -5,6 +5,14 @@
  * @file ximage.h
  * @brief Image container with multi-plane support and format utilities.
  *
+ * The mempool argument of the allocating constructors is an
+ * au::memory::XMemoryResource (or derived) pointer that must outlive the image
+ * (nullptr = malloc). Pass it typed: the void* overloads are kept for old
+ * callers and assume the pointer is already the XMemoryResource base;
+ * an XPoolResource recycles the planes of same-sized frames, an XArena hands
+ * out per-frame scratch planes, an XNodeResource places them on one NUMA node
+ * and an XPageResource maps large planes directly, optionally on huge pages.
+ *
  * @example
  *   au::cv::XImage img(mempool, 1920, 1080, au::cv::kXFormatNV21);
  *   auto* ptr = img.dataptr<uint8_t>(au::cv::Plane0, row, col);
@@ -15,6 +23,8 @@
 #include <type_traits>
 #include <cstdint>
 
+namespace au { namespace memory { class XMemoryResource; }}
+
 namespace au { namespace cv {
 
 enum XImageFormat : int {
@@ -69,6 +79,16 @@ public:
 
     XImage(void* mempool, uint32_t width, uint32_t height, int format);
     XImage(void* mempool, uint32_t width, uint32_t height, XImageFormat format);
+
+    /// Typed resource: converts to the XMemoryResource base correctly for any derived class.
+    template <class R, class = std::enable_if_t<std::is_base_of_v<au::memory::XMemoryResource, R>>>
+    XImage(R* resource, uint32_t width, uint32_t height, int format) {
+        createImage(static_cast<au::memory::XMemoryResource*>(resource), width, height, format);
+    }
+    template <class R, class = std::enable_if_t<std::is_base_of_v<au::memory::XMemoryResource, R>>>
+    XImage(R* resource, uint32_t width, uint32_t height, XImageFormat format) {
+        createImage(static_cast<au::memory::XMemoryResource*>(resource), width, height, format);
+    }
     XImage(uint32_t width, uint32_t height, uint32_t stride, int format,
            uint8_t* data0, uint8_t* data1 = nullptr);
     XImage(uint32_t width, uint32_t height, uint32_t stride, XImageFormat format,
@@ -106,7 +126,7 @@ public:
     bool isSameSizeAndFormatWith(const Image& image) const;
 
 private:
-    void createImage(void* mempool, uint32_t width, uint32_t height, int format);
+    void createImage(au::memory::XMemoryResource* resource, uint32_t width, uint32_t height, int format);
     void createImage(uint32_t width, uint32_t height, uint32_t stride, int format,
                      uint8_t* data0, uint8_t* data1 = nullptr);
     void deleteImage();
@@ -114,9 +134,9 @@ private:
     void copyImage(const XImage& image);
     void resetImage();
 
-    void*  mMempool     = nullptr;
-    bool   mNeedDestroy = false;
-    bool   mIsRaw       = false;
+    au::memory::XMemoryResource* mMempool = nullptr;
+    bool                         mNeedDestroy = false;
+    bool                         mIsRaw       = false;
 };
 
 }}  // namespace au::cv
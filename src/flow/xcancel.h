@@ -0,0 +1,62 @@
+#ifndef AURA_FLOW_XCANCEL_H_
+#define AURA_FLOW_XCANCEL_H_
+
+/**
+ * @file xcancel.h
+ * @brief Cooperative cancellation: XCancelSource requests, XCancelToken observes.
+ *
+ * A token is a cheap, copyable handle on the source's flag. Work submitted
+ * with a token is discarded if the token is cancelled before it starts
+ * (futures then resolve with err::kErrorAborted); work already running may
+ * poll isCancelled(), a single relaxed atomic load, and return early.
+ *
+ * A default-constructed token is never cancelled and costs nothing to copy.
+ *
+ * @example
+ *   au::flow::XCancelSource frame;
+ *   auto fut = pool.enqueue(frame.token(), [](size_t tile) { denoise(tile); }, 3);
+ *   if (frameDropped) frame.cancel();
+ *   if (fut.get() == err::kErrorAborted) { ... }
+ */
+
+#include <atomic>
+#include <memory>
+
+namespace au { namespace flow {
+
+class XCancelToken {
+public:
+    /** @brief A token that is never cancelled. */
+    XCancelToken() = default;
+
+    bool isCancelled() const { return mFlag && mFlag->load(std::memory_order_relaxed); }
+
+    /** @brief False for a default-constructed token. */
+    bool canBeCancelled() const { return mFlag != nullptr; }
+
+private:
+    friend class XCancelSource;
+
+    explicit XCancelToken(std::shared_ptr<const std::atomic<bool>> flag) : mFlag(std::move(flag)) {}
+
+    std::shared_ptr<const std::atomic<bool>> mFlag;
+};
+
+class XCancelSource {
+public:
+    XCancelSource() : mFlag(std::make_shared<std::atomic<bool>>(false)) {}
+
+    /** @brief Request cancellation; every token of this source observes it. Idempotent. */
+    void cancel() { mFlag->store(true, std::memory_order_relaxed); }
+
+    bool isCancelled() const { return mFlag->load(std::memory_order_relaxed); }
+
+    XCancelToken token() const { return XCancelToken(mFlag); }
+
+private:
+    std::shared_ptr<std::atomic<bool>> mFlag;
+};
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XCANCEL_H_
@@ -0,0 +1,465 @@
+#ifndef AURA_FLOW_XCORO_H_
+#define AURA_FLOW_XCORO_H_
+
+/**
+ * @file xcoro.h
+ * @brief C++20 coroutines on XThreadpool: XCoTask<T>, whenAll / whenAny, async file loads.
+ *
+ * Optional layer: this header needs C++20, the aura library itself stays
+ * C++17 and never includes it. Configure with -DENABLE_COROUTINES=ON to
+ * build its tests.
+ *
+ *  - XCoTask<T> is lazy: the body starts when the task is co_awaited (or
+ *    passed to syncWait / whenAll / whenAny) and resumes its awaiter by
+ *    symmetric transfer when it finishes.
+ *  - co_await pool.schedule() (or flow.schedule()) moves the coroutine onto
+ *    a pool worker. A coroutine runs on whichever thread resumed it last.
+ *  - A suspended coroutine holds no thread: a few I/O threads can keep
+ *    hundreds of loadAsync() calls queued without parking compute workers
+ *    on std::future::get.
+ *  - Exceptions propagate to the awaiter.
+ *
+ * @example
+ *   au::flow::XThreadpool compute(4), io(2);
+ *
+ *   au::flow::XCoTask<size_t> ingest(std::vector<std::string> paths) {
+ *       std::vector<au::flow::XCoTask<au::flow::XFileLoad>> loads;
+ *       for (auto& p : paths) loads.push_back(au::flow::loadAsync(io, p));
+ *       auto files = co_await au::flow::whenAll(std::move(loads));
+ *       co_await compute.schedule();  // back on a compute worker
+ *       size_t bytes = 0;
+ *       for (auto& f : files) bytes += f.data.size();
+ *       co_return bytes;
+ *   }
+ *   size_t total = au::flow::syncWait(ingest(paths));
+ */
+
+#if !defined(__cpp_impl_coroutine)
+#error "flow/xcoro.h requires C++20 coroutines"
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "file/xfile.h"
+#include "log/xerror.h"
+#include "memory/xbuffer.h"
+#include "xthreadpool.h"
+
+namespace au { namespace flow {
+
+template <class T = void>
+class XCoTask;
+
+namespace detail {
+
+class XCoPromiseBase {
+public:
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+
+        template <class Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> h) const noexcept
+        {
+            std::coroutine_handle<> next = h.promise().mContinuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter        final_suspend() const noexcept { return {}; }
+    void                unhandled_exception() noexcept { mError = std::current_exception(); }
+
+    void rethrowIfFailed() const
+    {
+        if (mError) std::rethrow_exception(mError);
+    }
+
+    std::coroutine_handle<> mContinuation;
+    std::exception_ptr      mError;
+};
+
+template <class T>
+class XCoPromise : public XCoPromiseBase {
+public:
+    XCoTask<T> get_return_object() noexcept;
+
+    template <class U>
+    void return_value(U&& value)
+    {
+        mValue.emplace(std::forward<U>(value));
+    }
+
+    T take()
+    {
+        rethrowIfFailed();
+        return std::move(*mValue);
+    }
+
+private:
+    std::optional<T> mValue;
+};
+
+template <>
+class XCoPromise<void> : public XCoPromiseBase {
+public:
+    XCoTask<void> get_return_object() noexcept;
+
+    void return_void() noexcept {}
+    void take() const { rethrowIfFailed(); }
+};
+
+/// Fire-and-forget coroutine: starts at once and frees its frame when done.
+struct XCoDetached {
+    struct promise_type {
+        XCoDetached         get_return_object() const noexcept { return {}; }
+        std::suspend_never  initial_suspend() const noexcept { return {}; }
+        std::suspend_never  final_suspend() const noexcept { return {}; }
+        void                return_void() const noexcept {}
+        void                unhandled_exception() const noexcept { std::terminate(); }
+    };
+};
+
+}  // namespace detail
+
+/**
+ * @brief Lazily started coroutine producing a T; move-only, owns its frame.
+ */
+template <class T>
+class [[nodiscard]] XCoTask {
+public:
+    using promise_type = detail::XCoPromise<T>;
+    using value_type   = T;
+
+    XCoTask() = default;
+    explicit XCoTask(std::coroutine_handle<promise_type> h) noexcept : mHandle(h) {}
+    XCoTask(XCoTask&& other) noexcept : mHandle(std::exchange(other.mHandle, {})) {}
+    XCoTask& operator=(XCoTask&& other) noexcept
+    {
+        if (this != &other) {
+            if (mHandle) mHandle.destroy();
+            mHandle = std::exchange(other.mHandle, {});
+        }
+        return *this;
+    }
+    XCoTask(const XCoTask&) = delete;
+    XCoTask& operator=(const XCoTask&) = delete;
+    ~XCoTask()
+    {
+        if (mHandle) mHandle.destroy();
+    }
+
+    bool valid() const { return static_cast<bool>(mHandle); }
+    bool done() const { return mHandle && mHandle.done(); }
+
+    /** @brief Start the task; the awaiter resumes on the thread that finishes it. */
+    auto operator co_await() noexcept
+    {
+        struct Awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() const noexcept { return !handle || handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+            {
+                handle.promise().mContinuation = awaiting;
+                return handle;
+            }
+
+            T await_resume()
+            {
+                if (!handle) throw std::logic_error("co_await on an empty XCoTask");
+                return handle.promise().take();
+            }
+        };
+        return Awaiter{mHandle};
+    }
+
+private:
+    std::coroutine_handle<promise_type> mHandle;
+};
+
+namespace detail {
+
+template <class T>
+XCoTask<T> XCoPromise<T>::get_return_object() noexcept
+{
+    return XCoTask<T>(std::coroutine_handle<XCoPromise<T>>::from_promise(*this));
+}
+
+inline XCoTask<void> XCoPromise<void>::get_return_object() noexcept
+{
+    return XCoTask<void>(std::coroutine_handle<XCoPromise<void>>::from_promise(*this));
+}
+
+// ----------------------------------------------------------------------------
+// syncWait
+// ----------------------------------------------------------------------------
+
+template <class T>
+struct XSyncWaitState {
+    std::mutex                                                  mutex;
+    std::condition_variable                                     cv;
+    bool                                                        done = false;
+    std::exception_ptr                                          error;
+    std::optional<std::conditional_t<std::is_void_v<T>, int, T>> value;
+};
+
+template <class T>
+XCoDetached syncWaitRunner(XCoTask<T> task, XSyncWaitState<T>* state)
+{
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+        } else {
+            state->value.emplace(co_await task);
+        }
+    } catch (...) {
+        state->error = std::current_exception();
+    }
+    // Notify under the lock: the waiter may destroy the state as soon as it
+    // can observe done.
+    std::lock_guard<std::mutex> lock(state->mutex);
+    state->done = true;
+    state->cv.notify_all();
+}
+
+// ----------------------------------------------------------------------------
+// whenAll
+// ----------------------------------------------------------------------------
+
+template <class T>
+struct XWhenAllState {
+    explicit XWhenAllState(size_t n) : results(std::is_void_v<T> ? 0 : n) {}
+
+    std::atomic<size_t>     remaining{0};
+    std::coroutine_handle<> parent;
+    std::atomic<bool>       failed{false};
+    std::exception_ptr      error;  // first failure, written once
+    std::vector<std::optional<std::conditional_t<std::is_void_v<T>, int, T>>> results;
+
+    void arrive()
+    {
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) parent.resume();
+    }
+};
+
+template <class T>
+XCoDetached whenAllRunner(XCoTask<T> task, XWhenAllState<T>* state, size_t index)
+{
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+        } else {
+            state->results[index].emplace(co_await task);
+        }
+    } catch (...) {
+        if (!state->failed.exchange(true, std::memory_order_acq_rel)) state->error = std::current_exception();
+    }
+    state->arrive();
+}
+
+template <class T>
+struct XWhenAllAwaiter {
+    XWhenAllState<T>*        state;
+    std::vector<XCoTask<T>>* tasks;
+
+    bool await_ready() const noexcept { return tasks->empty(); }
+
+    bool await_suspend(std::coroutine_handle<> parent)
+    {
+        // One extra count for this launcher, so children finishing while we
+        // are still starting the others cannot resume the parent early.
+        state->parent = parent;
+        state->remaining.store(tasks->size() + 1, std::memory_order_relaxed);
+        for (size_t i = 0; i < tasks->size(); ++i) whenAllRunner(std::move((*tasks)[i]), state, i);
+        return state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+// ----------------------------------------------------------------------------
+// whenAny
+// ----------------------------------------------------------------------------
+
+// Shared by the whenAny frame and every runner; the last one out deletes it.
+// Reference counted by hand rather than through a shared_ptr parameter so
+// the lifetime does not depend on how the compiler copies coroutine params.
+template <class T>
+struct XWhenAnyState {
+    explicit XWhenAnyState(size_t owners) : refs(owners) {}
+
+    std::atomic<size_t>     refs;
+    std::atomic<bool>       claimed{false};
+    std::atomic<int>        arrivals{2};  // the winner and the launcher
+    std::coroutine_handle<> parent;
+    size_t                  index = 0;
+    std::exception_ptr      error;
+    std::optional<std::conditional_t<std::is_void_v<T>, int, T>> value;
+
+    void arrive()
+    {
+        if (arrivals.fetch_sub(1, std::memory_order_acq_rel) == 1) parent.resume();
+    }
+
+    void release()
+    {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+};
+
+template <class T>
+XCoDetached whenAnyRunner(XCoTask<T> task, XWhenAnyState<T>* state, size_t index)
+{
+    std::exception_ptr error;
+    std::optional<std::conditional_t<std::is_void_v<T>, int, T>> value;
+    try {
+        if constexpr (std::is_void_v<T>) {
+            co_await task;
+            value.emplace(0);
+        } else {
+            value.emplace(co_await task);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    if (!state->claimed.exchange(true, std::memory_order_acq_rel)) {
+        state->index = index;
+        state->error = std::move(error);
+        state->value = std::move(value);
+        state->arrive();
+    }
+    state->release();
+}
+
+template <class T>
+struct XWhenAnyAwaiter {
+    XWhenAnyState<T>*        state;
+    std::vector<XCoTask<T>>* tasks;
+
+    bool await_ready() const noexcept { return false; }
+
+    bool await_suspend(std::coroutine_handle<> parent)
+    {
+        state->parent = parent;
+        for (size_t i = 0; i < tasks->size(); ++i) whenAnyRunner(std::move((*tasks)[i]), state, i);
+        return state->arrivals.fetch_sub(1, std::memory_order_acq_rel) != 1;
+    }
+
+    void await_resume() const noexcept {}
+};
+
+}  // namespace detail
+
+/**
+ * @brief Block the calling thread until @p task finishes; returns its result.
+ *
+ * For the thread that bridges into coroutine code (main, a test). A pool
+ * worker blocked here cannot run the tasks it waits for.
+ */
+template <class T>
+T syncWait(XCoTask<T> task)
+{
+    detail::XSyncWaitState<T> state;
+    detail::syncWaitRunner(std::move(task), &state);
+    {
+        std::unique_lock<std::mutex> lock(state.mutex);
+        state.cv.wait(lock, [&state] { return state.done; });
+    }
+    if (state.error) std::rethrow_exception(state.error);
+    if constexpr (!std::is_void_v<T>) return std::move(*state.value);
+}
+
+/**
+ * @brief Run all tasks concurrently; completes when the last one does.
+ *
+ * Results keep the order of @p tasks. If any task throws, the first
+ * exception is rethrown after every task has finished.
+ */
+template <class T>
+XCoTask<std::conditional_t<std::is_void_v<T>, void, std::vector<T>>> whenAll(std::vector<XCoTask<T>> tasks)
+{
+    detail::XWhenAllState<T> state(tasks.size());
+    co_await detail::XWhenAllAwaiter<T>{&state, &tasks};
+    if (state.error) std::rethrow_exception(state.error);
+    if constexpr (!std::is_void_v<T>) {
+        std::vector<T> out;
+        out.reserve(state.results.size());
+        for (auto& r : state.results) out.push_back(std::move(*r));
+        co_return out;
+    }
+}
+
+/// Result of whenAny(): which task finished first and its value.
+template <class T>
+struct XWhenAnyResult {
+    size_t index = 0;
+    T      value;
+};
+
+/**
+ * @brief Run all tasks concurrently; completes with the first one to finish.
+ *
+ * The others keep running to completion in the background and their
+ * results are dropped; pass them an XCancelToken to stop them early. A
+ * void task yields just the index. Throws std::invalid_argument for an
+ * empty list, or rethrows if the first task to finish threw.
+ */
+template <class T>
+XCoTask<std::conditional_t<std::is_void_v<T>, size_t, XWhenAnyResult<T>>> whenAny(std::vector<XCoTask<T>> tasks)
+{
+    if (tasks.empty()) throw std::invalid_argument("whenAny of no tasks");
+
+    auto* state = new detail::XWhenAnyState<T>(tasks.size() + 1);
+    co_await detail::XWhenAnyAwaiter<T>{state, &tasks};
+
+    // The winner filled the state before resuming us; stragglers only
+    // touch claimed and refs from here on.
+    size_t             index = state->index;
+    std::exception_ptr error = std::move(state->error);
+    auto               value = std::move(state->value);
+    state->release();
+
+    if (error) std::rethrow_exception(error);
+    if constexpr (std::is_void_v<T>) {
+        co_return index;
+    } else {
+        co_return XWhenAnyResult<T>{index, std::move(*value)};
+    }
+}
+
+/// A whole file read by loadAsync().
+struct XFileLoad {
+    int                        status = err::kSuccess;  ///< as XFile::loadToBuffer
+    au::memory::XBuffer<char>  data;                    ///< contents plus a trailing '\0'
+};
+
+/**
+ * @brief Read @p filename on a thread of @p io without blocking the awaiter's thread.
+ *
+ * The awaiting coroutine resumes on the @p io thread that did the read;
+ * co_await a compute pool's schedule() afterwards to move back. Use a small
+ * dedicated pool for @p io so slow storage never occupies compute workers.
+ */
+inline XCoTask<XFileLoad> loadAsync(XThreadpool& io, std::string filename)
+{
+    co_await io.schedule();
+    XFileLoad load;
+    load.status = au::file::XFile::loadToBuffer(filename, load.data);
+    co_return load;
+}
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XCORO_H_
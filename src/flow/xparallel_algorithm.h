@@ -0,0 +1,323 @@
+#ifndef AURA_FLOW_XPARALLEL_ALGORITHM_H_
+#define AURA_FLOW_XPARALLEL_ALGORITHM_H_
+
+/**
+ * @file xparallel_algorithm.h
+ * @brief Parallel reduce, transform-reduce, scan and sort on an XThreadpool.
+ *
+ * The range is cut into a fixed number of contiguous chunks (a few per
+ * thread, none smaller than minGrain). The calling thread and up to size()
+ * pool workers claim chunks from a shared counter, so a slow chunk does not
+ * stall the rest. Each chunk writes its partial result into its own
+ * cache-line-sized slot, so threads never share a line while folding.
+ * Partials are combined in chunk order: results are deterministic and the
+ * operators only need to be associative, not commutative.
+ *
+ *  - parallelReduce / parallelTransformReduce: chunk partials, then a short
+ *    serial combine.
+ *  - parallelInclusiveScan / parallelExclusiveScan: chunk totals, a serial
+ *    scan over the totals, then every chunk rescans with its carry-in.
+ *    The output may alias the input.
+ *  - parallelSort: chunks are sorted concurrently, then merged pairwise;
+ *    large merges split recursively at a binary-searched pivot. Not stable,
+ *    like std::sort.
+ *
+ * Chunk functions and operators must not throw: exceptions escaping a pool
+ * task are logged and swallowed, leaving that chunk's result unspecified.
+ *
+ * @example
+ *   au::flow::XThreadpool pool(4);
+ *   int64_t sum = au::flow::parallelReduce(pool, v.begin(), v.end(), int64_t(0), std::plus<>());
+ *
+ *   using Hist = std::array<uint32_t, 256>;
+ *   Hist hist = au::flow::parallelReduce(pool, 0, size, Hist{},
+ *       [&](size_t start, size_t count) { Hist h{}; for (size_t i = start; i < start + count; ++i) h[px[i]]++; return h; },
+ *       [](Hist a, const Hist& b) { for (int i = 0; i < 256; ++i) a[i] += b[i]; return a; });
+ *
+ *   au::flow::parallelExclusiveScan(pool, counts.begin(), counts.end(), offsets.begin(), 0);
+ *   au::flow::parallelSort(pool, keys.begin(), keys.end());
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <vector>
+
+#include "xthreadpool.h"
+
+namespace au { namespace flow {
+
+struct XParallelAlgorithmOptions {
+    /// Smallest chunk in elements; small ranges run on fewer threads.
+    size_t minGrain = 4096;
+
+    /// Chunks per participating thread, for load balancing.
+    size_t chunksPerThread = 4;
+};
+
+namespace detail {
+
+/// One partial result on its own cache line.
+template <class T>
+struct alignas(64) XPadded {
+    T value;
+};
+
+/// Chunk count for @p n elements on @p pool (workers plus the caller).
+inline size_t chunkCount(const XThreadpool& pool, size_t n, const XParallelAlgorithmOptions& opt)
+{
+    const size_t grain   = std::max<size_t>(opt.minGrain, 1);
+    const size_t threads = pool.size() + 1;
+    const size_t byGrain = (n + grain - 1) / grain;
+    return std::max<size_t>(std::min(byGrain, threads * std::max<size_t>(opt.chunksPerThread, 1)), 1);
+}
+
+/// First element of chunk @p c when [0, n) is cut into @p chunks parts.
+inline size_t chunkBegin(size_t n, size_t chunks, size_t c)
+{
+    return static_cast<size_t>(static_cast<unsigned long long>(n) * c / chunks);
+}
+
+/** @brief Call fn(c) for c in [0, chunks) on the pool and the calling thread. */
+template <class Fn>
+void runChunks(XThreadpool& pool, size_t chunks, Fn&& fn)
+{
+    std::atomic<size_t> next{0};
+    auto                claim = [&next, &fn, chunks] {
+        for (size_t c; (c = next.fetch_add(1, std::memory_order_relaxed)) < chunks;) fn(c);
+    };
+    if (chunks <= 1 || pool.size() == 0) {
+        claim();
+        return;
+    }
+    XTaskGroup   group(pool);
+    const size_t helpers = std::min(pool.size(), chunks - 1);
+    for (size_t i = 0; i < helpers; ++i) group.run(claim);
+    claim();
+    group.wait();
+}
+
+/// Merge two sorted runs into @p out, moving elements; splits while larger than @p grain.
+template <class It1, class It2, class Out, class Comp>
+void parallelMerge(XThreadpool& pool, It1 a0, It1 a1, It2 b0, It2 b1, Out out, Comp& comp, size_t grain)
+{
+    const size_t na = static_cast<size_t>(a1 - a0);
+    const size_t nb = static_cast<size_t>(b1 - b0);
+    if (na + nb <= grain) {
+        std::merge(std::make_move_iterator(a0), std::make_move_iterator(a1), std::make_move_iterator(b0),
+                   std::make_move_iterator(b1), out, comp);
+        return;
+    }
+    // Split at the middle of the longer run; ties keep A before B. grain >= 2
+    // guarantees both halves shrink.
+    It1 am;
+    It2 bm;
+    if (na >= nb) {
+        am = a0 + na / 2;
+        bm = std::lower_bound(b0, b1, *am, comp);
+    } else {
+        bm = b0 + nb / 2;
+        am = std::upper_bound(a0, a1, *bm, comp);
+    }
+    const Out om = out + (am - a0) + (bm - b0);
+
+    XTaskGroup group(pool);
+    group.run([&pool, &comp, am, a1, bm, b1, om, grain] { parallelMerge(pool, am, a1, bm, b1, om, comp, grain); });
+    parallelMerge(pool, a0, am, b0, bm, out, comp, grain);
+    group.wait();
+}
+
+}  // namespace detail
+
+/**
+ * @brief Reduce [begin, end) through a chunk function.
+ *
+ * chunk(start, count) returns the partial result of [start, start+count);
+ * combine(T, T) joins two partials. Returns @p identity for an empty range.
+ */
+template <class T, class Chunk, class Combine>
+T parallelReduce(XThreadpool& pool, size_t begin, size_t end, T identity, Chunk&& chunk, Combine&& combine,
+                 const XParallelAlgorithmOptions& opt = {})
+{
+    if (begin >= end) return identity;
+    const size_t n      = end - begin;
+    const size_t chunks = detail::chunkCount(pool, n, opt);
+
+    std::vector<detail::XPadded<T>> partials(chunks, detail::XPadded<T>{identity});
+    detail::runChunks(pool, chunks, [&](size_t c) {
+        const size_t lo = detail::chunkBegin(n, chunks, c);
+        const size_t hi = detail::chunkBegin(n, chunks, c + 1);
+        partials[c].value = chunk(begin + lo, hi - lo);
+    });
+
+    T result = std::move(identity);
+    for (auto& p : partials) result = combine(std::move(result), std::move(p.value));
+    return result;
+}
+
+/** @brief Parallel std::transform_reduce: reduce(init, transform(x)...) over [first, last). */
+template <class It, class T, class Reduce, class Transform>
+T parallelTransformReduce(XThreadpool& pool, It first, It last, T init, Reduce reduce, Transform transform,
+                          const XParallelAlgorithmOptions& opt = {})
+{
+    const size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) return init;
+    const size_t chunks = detail::chunkCount(pool, n, opt);
+
+    // Seeded from each chunk's first element, so no identity is needed.
+    std::vector<detail::XPadded<std::optional<T>>> partials(chunks);
+    detail::runChunks(pool, chunks, [&](size_t c) {
+        It       it  = first + detail::chunkBegin(n, chunks, c);
+        const It end = first + detail::chunkBegin(n, chunks, c + 1);
+        T        acc = transform(*it);
+        for (++it; it != end; ++it) acc = reduce(std::move(acc), transform(*it));
+        partials[c].value.emplace(std::move(acc));
+    });
+
+    T result = std::move(init);
+    for (auto& p : partials) result = reduce(std::move(result), std::move(*p.value));
+    return result;
+}
+
+/** @brief Parallel std::reduce: @p op must be associative; @p init is folded in once. */
+template <class It, class T, class Op>
+T parallelReduce(XThreadpool& pool, It first, It last, T init, Op op, const XParallelAlgorithmOptions& opt = {})
+{
+    return parallelTransformReduce(pool, first, last, std::move(init), op,
+                                   [](const auto& v) -> const auto& { return v; }, opt);
+}
+
+/** @brief Parallel std::inclusive_scan; @p out may equal @p first. */
+template <class It, class Out, class Op = std::plus<>>
+Out parallelInclusiveScan(XThreadpool& pool, It first, It last, Out out, Op op = {},
+                          const XParallelAlgorithmOptions& opt = {})
+{
+    using T        = typename std::iterator_traits<It>::value_type;
+    const size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) return out;
+    const size_t chunks = detail::chunkCount(pool, n, opt);
+    if (chunks == 1) return std::inclusive_scan(first, last, out, op);
+
+    // Pass 1: per-chunk totals.
+    std::vector<detail::XPadded<std::optional<T>>> totals(chunks);
+    detail::runChunks(pool, chunks - 1, [&](size_t c) {
+        It       it  = first + detail::chunkBegin(n, chunks, c);
+        const It end = first + detail::chunkBegin(n, chunks, c + 1);
+        T        acc = *it;
+        for (++it; it != end; ++it) acc = op(std::move(acc), *it);
+        totals[c].value.emplace(std::move(acc));
+    });
+    // Carry into chunk c: totals[c] becomes the scan of chunks [0, c].
+    for (size_t c = 1; c + 1 < chunks; ++c) *totals[c].value = op(*totals[c - 1].value, *totals[c].value);
+
+    // Pass 2: rescan every chunk with its carry.
+    detail::runChunks(pool, chunks, [&](size_t c) {
+        const size_t lo  = detail::chunkBegin(n, chunks, c);
+        const size_t hi  = detail::chunkBegin(n, chunks, c + 1);
+        It           it  = first + lo;
+        Out          dst = out + lo;
+        T            acc = c == 0 ? T(*it) : op(*totals[c - 1].value, *it);
+        *dst             = acc;
+        for (size_t i = lo + 1; i < hi; ++i) {
+            acc    = op(std::move(acc), *++it);
+            *++dst = acc;
+        }
+    });
+    return out + n;
+}
+
+/** @brief Parallel std::exclusive_scan; @p out may equal @p first. */
+template <class It, class Out, class T, class Op = std::plus<>>
+Out parallelExclusiveScan(XThreadpool& pool, It first, It last, Out out, T init, Op op = {},
+                          const XParallelAlgorithmOptions& opt = {})
+{
+    const size_t n = static_cast<size_t>(std::distance(first, last));
+    if (n == 0) return out;
+    const size_t chunks = detail::chunkCount(pool, n, opt);
+
+    // Pass 1: per-chunk totals, the last chunk's is never needed.
+    std::vector<detail::XPadded<std::optional<T>>> totals(chunks);
+    detail::runChunks(pool, chunks - 1, [&](size_t c) {
+        It       it  = first + detail::chunkBegin(n, chunks, c);
+        const It end = first + detail::chunkBegin(n, chunks, c + 1);
+        T        acc = *it;
+        for (++it; it != end; ++it) acc = op(std::move(acc), *it);
+        totals[c].value.emplace(std::move(acc));
+    });
+    // Carry into chunk c, starting from init.
+    std::vector<detail::XPadded<T>> carry(chunks, detail::XPadded<T>{init});
+    for (size_t c = 1; c < chunks; ++c) carry[c].value = op(carry[c - 1].value, *totals[c - 1].value);
+
+    // Pass 2: read each element before overwriting it, so out may alias first.
+    detail::runChunks(pool, chunks, [&](size_t c) {
+        const size_t lo  = detail::chunkBegin(n, chunks, c);
+        const size_t hi  = detail::chunkBegin(n, chunks, c + 1);
+        It           it  = first + lo;
+        Out          dst = out + lo;
+        T            acc = carry[c].value;
+        for (size_t i = lo; i < hi; ++i, ++it, ++dst) {
+            T next = op(acc, *it);
+            *dst   = std::move(acc);
+            acc    = std::move(next);
+        }
+    });
+    return out + n;
+}
+
+/** @brief Parallel std::sort (not stable). Needs random-access iterators. */
+template <class It, class Comp = std::less<>>
+void parallelSort(XThreadpool& pool, It first, It last, Comp comp = {}, const XParallelAlgorithmOptions& opt = {})
+{
+    using T        = typename std::iterator_traits<It>::value_type;
+    const size_t n = static_cast<size_t>(last - first);
+
+    // A power of two of chunks keeps the merge tree balanced.
+    const size_t want   = detail::chunkCount(pool, n, opt);
+    size_t       chunks = 1;
+    while (chunks * 2 <= want && chunks < pool.size() + 1) chunks *= 2;
+    if (chunks == 1) {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    detail::runChunks(pool, chunks, [&](size_t c) {
+        std::sort(first + detail::chunkBegin(n, chunks, c), first + detail::chunkBegin(n, chunks, c + 1), comp);
+    });
+
+    // Merge levels ping-pong between the range and the buffer.
+    std::vector<T> buffer(std::make_move_iterator(first), std::make_move_iterator(last));
+    const size_t   grain = std::max<size_t>(n / ((pool.size() + 1) * std::max<size_t>(opt.chunksPerThread, 1)), 2);
+
+    bool inBuffer = true;
+    for (size_t width = 1; width < chunks; width *= 2) {
+        auto level = [&](auto src, auto dst) {
+            detail::runChunks(pool, chunks / (2 * width), [&](size_t pair) {
+                const size_t lo  = detail::chunkBegin(n, chunks, 2 * pair * width);
+                const size_t mid = detail::chunkBegin(n, chunks, (2 * pair + 1) * width);
+                const size_t hi  = detail::chunkBegin(n, chunks, (2 * pair + 2) * width);
+                detail::parallelMerge(pool, src + lo, src + mid, src + mid, src + hi, dst + lo, comp, grain);
+            });
+        };
+        if (inBuffer) {
+            level(buffer.begin(), first);
+        } else {
+            level(first, buffer.begin());
+        }
+        inBuffer = !inBuffer;
+    }
+    if (inBuffer) {
+        detail::runChunks(pool, chunks, [&](size_t c) {
+            const size_t lo = detail::chunkBegin(n, chunks, c);
+            const size_t hi = detail::chunkBegin(n, chunks, c + 1);
+            std::move(buffer.begin() + lo, buffer.begin() + hi, first + lo);
+        });
+    }
+}
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XPARALLEL_ALGORITHM_H_
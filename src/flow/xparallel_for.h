@@ -0,0 +1,171 @@
+#ifndef AURA_FLOW_XPARALLEL_FOR_H_
+#define AURA_FLOW_XPARALLEL_FOR_H_
+
+/**
+ * @file xparallel_for.h
+ * @brief Fork-join parallel loop with lazy binary splitting and adaptive grain.
+ *
+ * The calling thread starts on the whole range. Before each chunk it checks
+ * whether the pool has idle capacity (XThreadpool::hasIdleCapacity); if so
+ * it splits the remaining range in half and hands the upper half to the
+ * pool, where the same loop runs recursively. Otherwise it runs one grain
+ * itself. Splits therefore happen only when a thread is idle; a busy pool
+ * just runs chunks.
+ *
+ * The grain is not fixed: every chunk is timed and the grain is re-derived
+ * so a chunk costs about targetChunkNs. Cheap rows get large chunks and
+ * expensive rows small ones, even within a single call.
+ *
+ * With a cancel token in the options every thread checks it before each
+ * chunk; once it fires no new chunk starts and parallelFor returns
+ * err::kErrorAborted. A running chunk may poll the token itself.
+ *
+ * If f throws, no new chunk starts anywhere; once every running chunk has
+ * finished, the first exception is rethrown on the calling thread.
+ *
+ * @example
+ *   au::flow::XThreadpool pool(4);
+ *   au::flow::parallelFor(pool, 0, height, [&](size_t row, size_t count) {
+ *       for (size_t y = row; y < row + count; ++y) filterRow(y);
+ *   });
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+#include "log/xerror.h"
+#include "xcancel.h"
+#include "xthreadpool.h"
+
+namespace au { namespace flow {
+
+struct XParallelForOptions {
+    /// Wall time one chunk should take before the loop re-checks for idle threads.
+    uint64_t targetChunkNs = 50000;
+
+    /// Grain bounds in items. maxGrain = 0 caps the grain automatically so
+    /// the range keeps at least a few chunks per thread.
+    size_t minGrain = 1;
+    size_t maxGrain = 0;
+
+    /// Checked before each chunk; chunks not yet started are skipped once it fires.
+    XCancelToken cancel;
+};
+
+namespace detail {
+
+template <class F>
+class XParallelForLoop {
+public:
+    XParallelForLoop(XThreadpool& pool, F& f, const XParallelForOptions& opt, size_t range)
+        : mPool(pool), mFunc(f), mCancel(opt.cancel), mTargetNs(opt.targetChunkNs ? opt.targetChunkNs : 1),
+          mGroup(pool)
+    {
+        const size_t threads = pool.size() + 1;  // workers plus the caller
+        mMinGrain = std::max<size_t>(opt.minGrain, 1);
+        mMaxGrain = opt.maxGrain ? opt.maxGrain : std::max<size_t>(range / (4 * threads), 1);
+        mMaxGrain = std::max(mMaxGrain, mMinGrain);
+        mGrain.store(mMinGrain, std::memory_order_relaxed);
+    }
+
+    /** @brief Process [begin, end), splitting off halves while the pool has idle capacity. */
+    void run(size_t begin, size_t end)
+    {
+        try {
+            runRange(begin, end);
+        } catch (...) {
+            // Written once, read by join() after the group has drained.
+            if (!mFailed.exchange(true, std::memory_order_relaxed)) mError = std::current_exception();
+        }
+    }
+
+    /** @brief Help the pool until every split-off half has finished, then rethrow the first failure. */
+    void join()
+    {
+        mGroup.wait();
+        if (mError) std::rethrow_exception(mError);
+    }
+
+    /** @brief True if cancellation skipped part of the range; valid after join(). */
+    bool aborted() const { return mAborted.load(std::memory_order_relaxed); }
+
+private:
+    void runRange(size_t begin, size_t end)
+    {
+        while (begin < end) {
+            if (mFailed.load(std::memory_order_relaxed)) return;
+            if (mCancel.isCancelled()) {
+                mAborted.store(true, std::memory_order_relaxed);
+                return;
+            }
+            const size_t n     = end - begin;
+            const size_t grain = mGrain.load(std::memory_order_relaxed);
+
+            if (n >= 2 * grain && n >= 2 && mPool.hasIdleCapacity()) {
+                const size_t mid = begin + n / 2;
+                mGroup.run([this, mid, end] { run(mid, end); });
+                end = mid;
+                continue;
+            }
+
+            const size_t count = std::min(grain, n);
+            const auto   t0    = std::chrono::steady_clock::now();
+            mFunc(begin, count);
+            const auto dt = std::chrono::steady_clock::now() - t0;
+            adapt(count, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count()));
+            begin += count;
+        }
+    }
+
+    /// Re-derive the grain from the measured per-item cost of the last chunk.
+    void adapt(size_t count, uint64_t ns)
+    {
+        const uint64_t perItem = std::max<uint64_t>(ns / count, 1);
+        size_t         want    = static_cast<size_t>(mTargetNs / perItem);
+        want                   = std::min(std::max(want, mMinGrain), mMaxGrain);
+
+        // Move halfway towards the new estimate to damp one-off outliers.
+        const size_t cur = mGrain.load(std::memory_order_relaxed);
+        mGrain.store(std::max<size_t>((cur + want) / 2, mMinGrain), std::memory_order_relaxed);
+    }
+
+    XThreadpool&        mPool;
+    F&                  mFunc;
+    const XCancelToken  mCancel;
+    uint64_t            mTargetNs;
+    size_t              mMinGrain = 1;
+    size_t              mMaxGrain = 1;
+    std::atomic<size_t> mGrain{1};
+    std::atomic<bool>   mAborted{false};
+    std::atomic<bool>   mFailed{false};
+    std::exception_ptr  mError;
+    XTaskGroup          mGroup;  ///< last: destroyed (and waited on) before the state the halves read
+};
+
+}  // namespace detail
+
+/**
+ * @brief Run @p f(start, count) over [begin, end) on @p pool and the calling thread.
+ * @return err::kSuccess, err::kErrorAborted if opt.cancel skipped part of
+ *         the range, or err::kErrorInvalidParam if begin > end.
+ * @throws The first exception thrown by @p f, after every chunk has stopped.
+ */
+template <class F>
+int parallelFor(XThreadpool& pool, size_t begin, size_t end, F&& f, const XParallelForOptions& opt = {})
+{
+    if (begin > end) return err::kErrorInvalidParam;
+    if (begin == end) return err::kSuccess;
+
+    detail::XParallelForLoop<std::remove_reference_t<F>> loop(pool, f, opt, end - begin);
+    loop.run(begin, end);
+    loop.join();
+    return loop.aborted() ? err::kErrorAborted : err::kSuccess;
+}
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XPARALLEL_FOR_H_
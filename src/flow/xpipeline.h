@@ -0,0 +1,334 @@
+#ifndef AURA_FLOW_XPIPELINE_H_
+#define AURA_FLOW_XPIPELINE_H_
+
+/**
+ * @file xpipeline.h
+ * @brief Bounded streaming pipeline: typed stages, backpressure, per-stage counters.
+ *
+ * Frames pushed into the pipeline flow through a chain of stages. Each stage
+ * maps its input type to the next stage's input type; the last stage (the
+ * sink) returns void. Different frames occupy different stages at the same
+ * time, so stage N of frame k overlaps stage N+1 of frame k-1.
+ *
+ *  - Serial stages process one frame at a time, in push order, even after a
+ *    parallel stage reordered them.
+ *  - Parallel stages process any number of frames at once, in any order.
+ *  - At most maxInFlight frames are admitted and not yet through the sink.
+ *    push() blocks (running pool tasks meanwhile) when the limit is reached,
+ *    so a slow sink throttles the producer and memory stays bounded.
+ *
+ * Frames move between stages through bounded lock-free rings: an XSpscQueue
+ * between two serial stages, an XMpmcQueue in front of a parallel stage and
+ * a reorder ring (one slot per frame in flight) in front of a serial stage
+ * whose input may arrive out of order. All storage is allocated at build().
+ *
+ * A stage that throws drops its frame: the exception is logged, the stage
+ * counts it as failed and later stages skip the frame.
+ *
+ * push() accepts an XCancelToken per frame. Every stage checks it before
+ * running its function; once it fires the frame is dropped the same way
+ * (counted as cancelled, later stages skip it), so frames dropped upstream
+ * stop consuming stage time. A stage function may poll the token itself.
+ *
+ * @example
+ *   au::flow::XThreadpool pool(4);
+ *   auto pipe = au::flow::makePipeline<RawFrame>(pool, {4})
+ *                   .serial("decode",    [](RawFrame raw) { return decode(raw); })
+ *                   .parallel("denoise", [](Image img) { return denoise(std::move(img)); })
+ *                   .serial("encode",    [&](Image img) { writer.write(img); })
+ *                   .build();
+ *   while (camera.read(raw)) pipe.push(std::move(raw));
+ *   pipe.wait();
+ *   for (auto& s : pipe.stats().stages) printf("%s %.1f fps\n", s.name.c_str(), s.throughput);
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "xcancel.h"
+#include "xring_queue.h"
+#include "xthreadpool.h"
+
+namespace au { namespace flow {
+
+enum XStageMode : int {
+    kStageSerial   = 0,
+    kStageParallel = 1,
+};
+
+struct XPipelineOptions {
+    /// Frames admitted but not yet through the sink; push() blocks beyond this.
+    size_t maxInFlight = 4;
+};
+
+struct XPipelineStageStats {
+    std::string name;
+    XStageMode  mode           = kStageSerial;
+    uint64_t    processed      = 0;  ///< frames the stage function completed
+    uint64_t    failed         = 0;  ///< frames whose stage function threw
+    uint64_t    cancelled      = 0;  ///< frames skipped here because their token fired
+    uint64_t    busyNs         = 0;  ///< summed time inside the stage function
+    size_t      queueDepth     = 0;  ///< frames waiting at the stage input now
+    size_t      peakQueueDepth = 0;
+    double      throughput     = 0;  ///< processed frames per second since the first push
+};
+
+struct XPipelineStats {
+    uint64_t                         pushed    = 0;
+    uint64_t                         completed = 0;  ///< frames that left the sink
+    size_t                           inFlight  = 0;
+    double                           seconds   = 0;  ///< wall time since the first push
+    std::vector<XPipelineStageStats> stages;
+};
+
+namespace detail {
+
+class XPipelineCore;
+
+class XStageBase {
+public:
+    XStageBase(XPipelineCore& core, std::string name, XStageMode mode)
+        : mCore(core), mName(std::move(name)), mMode(mode) {}
+    virtual ~XStageBase() = default;
+
+    XPipelineStageStats snapshot(double seconds) const;
+
+protected:
+    /// Run one invocation of the stage function: timed, exceptions logged and counted.
+    template <class Call>
+    void execute(Call&& call);
+
+    void noteQueued();
+    void noteTaken() { mDepth.fetch_sub(1, std::memory_order_relaxed); }
+    void noteCancelled() { mCancelled.fetch_add(1, std::memory_order_relaxed); }
+
+    XPipelineCore&    mCore;
+    const std::string mName;
+    const XStageMode  mMode;
+
+    alignas(64) std::atomic<uint64_t> mProcessed{0};
+    std::atomic<uint64_t> mFailed{0};
+    std::atomic<uint64_t> mCancelled{0};
+    std::atomic<uint64_t> mBusyNs{0};
+    std::atomic<size_t>   mDepth{0};
+    std::atomic<size_t>   mPeakDepth{0};
+};
+
+/// Receiving end of a stage: frames of type T tagged with their push sequence.
+template <class T>
+class XStageInput : public XStageBase {
+public:
+    using XStageBase::XStageBase;
+
+    /** @brief Hand frame @p seq to this stage; an empty value marks a dropped frame. */
+    virtual void accept(uint64_t seq, std::optional<T>&& value, XCancelToken&& cancel) = 0;
+};
+
+/// Sending end of a stage producing T; wired to the next stage at build time.
+template <class T>
+struct XStageOutput {
+    XStageInput<T>* next = nullptr;
+};
+
+template <>
+struct XStageOutput<void> {};
+
+template <class T>
+struct XStageItem {
+    uint64_t         seq = 0;
+    std::optional<T> value;
+    XCancelToken     cancel;
+};
+
+template <class In, class Out, class F>
+class XStage final : public XStageInput<In>, public XStageOutput<Out> {
+public:
+    XStage(XPipelineCore& core, std::string name, XStageMode mode, bool orderedInput, F&& fn);
+
+    void accept(uint64_t seq, std::optional<In>&& value, XCancelToken&& cancel) override;
+
+private:
+    using Item = XStageItem<In>;
+
+    struct ReorderSlot {
+        std::atomic<bool> ready{false};
+        std::optional<In> value;
+        XCancelToken      cancel;
+    };
+
+    bool take(Item& item);
+    bool hasNext(uint64_t nextSeq) const;
+    void activate();
+    void drain();
+    void runOne();
+    void process(Item& item);
+
+    F mFunc;
+
+    // Exactly one of these is the stage input.
+    std::unique_ptr<XMpmcQueue<Item>>  mShared;   // parallel stage
+    std::unique_ptr<XSpscQueue<Item>>  mOrdered;  // serial stage fed in order
+    std::unique_ptr<ReorderSlot[]>     mReorder;  // serial stage fed out of order
+    size_t                             mReorderSize = 0;
+
+    // Serial stages: one drain task at a time owns the consumer side.
+    alignas(64) std::atomic<bool> mActive{false};
+    uint64_t mNextSeq = 0;  // reorder ring cursor, owned by the active drain
+};
+
+/// State shared by all stages of one pipeline: admission, sequencing, task tracking.
+class XPipelineCore {
+public:
+    XPipelineCore(XThreadpool& pool, const XPipelineOptions& opt);
+
+    XThreadpool& pool() { return mPool; }
+    size_t maxInFlight() const { return mMaxInFlight; }
+
+    /** @brief Run @p fn on the pool as a tracked pipeline task. */
+    template <class Fn>
+    void spawn(Fn&& fn) { mGroup.run(std::forward<Fn>(fn)); }
+
+    /** @brief Reserve a slot for one new frame. @return false if full and !blocking. */
+    bool admit(bool blocking);
+
+    /** @brief Sequence number for an admitted frame. */
+    uint64_t nextSeq() { return mNextSeq.fetch_add(1, std::memory_order_relaxed); }
+
+    /** @brief A frame left the sink (or was dropped); frees its slot. */
+    void retire();
+
+    /** @brief Help the pool until every admitted frame has retired. */
+    void wait() { mGroup.wait(); }
+
+    size_t inFlight() const { return mInFlight.load(std::memory_order_acquire); }
+
+    XPipelineStats stats() const;
+
+    void   addStage(XStageBase* stage) { mStages.emplace_back(stage); }
+    size_t numStages() const { return mStages.size(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    XThreadpool& mPool;
+    const size_t mMaxInFlight;
+    XTaskGroup   mGroup;
+
+    std::vector<std::unique_ptr<XStageBase>> mStages;
+
+    alignas(64) std::atomic<size_t> mInFlight{0};
+    std::atomic<uint64_t> mNextSeq{0};
+    std::atomic<uint64_t> mCompleted{0};
+    std::atomic<int64_t>  mStartNs{-1};  // steady_clock time of the first push
+
+    std::atomic<size_t>     mWaiters{0};
+    std::mutex              mMutex;
+    std::condition_variable mSlotFreed;
+};
+
+}  // namespace detail
+
+/**
+ * @brief A built pipeline accepting frames of type In.
+ *
+ * The destructor waits for every pushed frame to leave the sink.
+ */
+template <class In>
+class XPipeline {
+public:
+    XPipeline(XPipeline&&) noexcept = default;
+    XPipeline& operator=(XPipeline&&) = delete;
+    ~XPipeline()
+    {
+        if (mCore) mCore->wait();
+    }
+
+    /**
+     * @brief Admit one frame, blocking while maxInFlight frames are in flight.
+     *
+     * Thread-safe. Serial stages see frames in admission order; across
+     * concurrent producers that order is unspecified. Stages not yet reached
+     * when @p cancel fires skip the frame.
+     * @return err::kSuccess, or err::kErrorAborted if @p cancel had already fired.
+     */
+    int push(In value, const XCancelToken& cancel = {});
+
+    /** @brief Like push() but returns err::kErrorBusy instead of blocking; @p value is then untouched. */
+    int tryPush(In& value, const XCancelToken& cancel = {});
+
+    /** @brief Help the pool until every frame pushed so far has left the sink. */
+    void wait() { mCore->wait(); }
+
+    size_t inFlight() const { return mCore->inFlight(); }
+    size_t numStages() const { return mCore->numStages(); }
+
+    /** @brief Snapshot of the pipeline and per-stage counters; safe while running. */
+    XPipelineStats stats() const { return mCore->stats(); }
+
+private:
+    template <class, class>
+    friend class XPipelineBuilder;
+
+    XPipeline(std::unique_ptr<detail::XPipelineCore> core, detail::XStageInput<In>* head)
+        : mCore(std::move(core)), mHead(head) {}
+
+    std::unique_ptr<detail::XPipelineCore> mCore;
+    detail::XStageInput<In>*               mHead;
+};
+
+/**
+ * @brief Chains stages onto a pipeline whose frames enter as In and currently have type Cur.
+ *
+ * Each serial()/parallel() call consumes the builder and returns one typed
+ * on the stage's result; build() requires the last stage to return void.
+ */
+template <class In, class Cur>
+class XPipelineBuilder {
+public:
+    XPipelineBuilder(XThreadpool& pool, const XPipelineOptions& opt);
+
+    /** @brief Append an ordered stage running one frame at a time. */
+    template <class F>
+    auto serial(std::string name, F&& fn) &&;
+
+    /** @brief Append a stage running on any number of frames concurrently. */
+    template <class F>
+    auto parallel(std::string name, F&& fn) &&;
+
+    XPipeline<In> build() &&;
+
+private:
+    template <class, class>
+    friend class XPipelineBuilder;
+
+    XPipelineBuilder() = default;
+
+    template <class F>
+    auto addStage(std::string name, XStageMode mode, F&& fn);
+
+    std::unique_ptr<detail::XPipelineCore> mCore;
+    detail::XStageInput<In>*               mHead      = nullptr;
+    detail::XStageOutput<Cur>*             mTail      = nullptr;
+    bool                                   mTailSerial = false;
+};
+
+/** @brief Start building a pipeline for frames of type In on @p pool. */
+template <class In>
+XPipelineBuilder<In, In> makePipeline(XThreadpool& pool, const XPipelineOptions& opt = {})
+{
+    return XPipelineBuilder<In, In>(pool, opt);
+}
+
+}}  // namespace au::flow
+
+#include "xpipeline.impl.h"
+
+#endif // AURA_FLOW_XPIPELINE_H_
@@ -0,0 +1,351 @@
+#ifndef AURA_FLOW_XPIPELINE_IMPL_H_
+#define AURA_FLOW_XPIPELINE_IMPL_H_
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <thread>
+
+#include "log/xerror.h"
+#include "log/xlogger.h"
+#include "xpipeline.h"
+
+namespace au { namespace flow {
+
+namespace detail {
+
+// ============================================================================
+// XStageBase
+// ============================================================================
+
+template <class Call>
+void XStageBase::execute(Call&& call)
+{
+    const auto t0 = std::chrono::steady_clock::now();
+    try {
+        call();
+        mProcessed.fetch_add(1, std::memory_order_relaxed);
+    } catch (const std::exception& e) {
+        XLOG_E("pipeline stage '%s' threw: %s\n", mName.c_str(), e.what());
+        mFailed.fetch_add(1, std::memory_order_relaxed);
+    } catch (...) {
+        XLOG_E("pipeline stage '%s' threw\n", mName.c_str());
+        mFailed.fetch_add(1, std::memory_order_relaxed);
+    }
+    const auto dt = std::chrono::steady_clock::now() - t0;
+    mBusyNs.fetch_add(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count()),
+                      std::memory_order_relaxed);
+}
+
+inline void XStageBase::noteQueued()
+{
+    const size_t depth = mDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+    size_t       peak  = mPeakDepth.load(std::memory_order_relaxed);
+    while (depth > peak && !mPeakDepth.compare_exchange_weak(peak, depth, std::memory_order_relaxed)) {}
+}
+
+inline XPipelineStageStats XStageBase::snapshot(double seconds) const
+{
+    XPipelineStageStats s;
+    s.name           = mName;
+    s.mode           = mMode;
+    s.processed      = mProcessed.load(std::memory_order_relaxed);
+    s.failed         = mFailed.load(std::memory_order_relaxed);
+    s.cancelled      = mCancelled.load(std::memory_order_relaxed);
+    s.busyNs         = mBusyNs.load(std::memory_order_relaxed);
+    s.queueDepth     = mDepth.load(std::memory_order_relaxed);
+    s.peakQueueDepth = mPeakDepth.load(std::memory_order_relaxed);
+    s.throughput     = seconds > 0 ? static_cast<double>(s.processed) / seconds : 0;
+    return s;
+}
+
+// ============================================================================
+// XStage
+// ============================================================================
+
+template <class In, class Out, class F>
+XStage<In, Out, F>::XStage(XPipelineCore& core, std::string name, XStageMode mode, bool orderedInput, F&& fn)
+    : XStageInput<In>(core, std::move(name), mode), mFunc(std::move(fn))
+{
+    // Never more than maxInFlight frames sit in one input. The rings get
+    // twice that so a consumer still releasing a cell does not make them
+    // look full.
+    const size_t n = core.maxInFlight();
+    if (mode == kStageParallel) {
+        mShared = std::make_unique<XMpmcQueue<Item>>(2 * n);
+    } else if (orderedInput) {
+        mOrdered = std::make_unique<XSpscQueue<Item>>(2 * n);
+    } else {
+        mReorder.reset(new ReorderSlot[n]);
+        mReorderSize = n;
+    }
+}
+
+template <class In, class Out, class F>
+void XStage<In, Out, F>::accept(uint64_t seq, std::optional<In>&& value, XCancelToken&& cancel)
+{
+    this->noteQueued();
+
+    if (mShared) {
+        Item item{seq, std::move(value), std::move(cancel)};
+        while (!mShared->tryPush(std::move(item))) std::this_thread::yield();
+        this->mCore.spawn([this] { runOne(); });
+        return;
+    }
+
+    if (mOrdered) {
+        Item item{seq, std::move(value), std::move(cancel)};
+        while (!mOrdered->tryPush(std::move(item))) std::this_thread::yield();
+    } else {
+        // Slot seq % n is free: frame seq - n passed this stage before the
+        // admission that let frame seq in. The acquire pairs with the release
+        // in take() that freed it; admission alone (a relaxed counter) does
+        // not order our writes after the drain's read.
+        ReorderSlot& slot = mReorder[seq % mReorderSize];
+        while (slot.ready.load(std::memory_order_acquire)) std::this_thread::yield();
+        slot.value        = std::move(value);
+        slot.cancel       = std::move(cancel);
+        slot.ready.store(true, std::memory_order_release);
+    }
+    activate();
+}
+
+template <class In, class Out, class F>
+void XStage<In, Out, F>::activate()
+{
+    // Pairs with the fence in drain(): either the running drain sees the new
+    // frame, or this producer sees mActive == false and starts a new drain.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!mActive.exchange(true, std::memory_order_acq_rel)) {
+        this->mCore.spawn([this] { drain(); });
+    }
+}
+
+template <class In, class Out, class F>
+bool XStage<In, Out, F>::take(Item& item)
+{
+    if (mOrdered) {
+        if (!mOrdered->tryPop(item)) return false;
+    } else {
+        ReorderSlot& slot = mReorder[mNextSeq % mReorderSize];
+        if (!slot.ready.load(std::memory_order_acquire)) return false;
+        item.seq   = mNextSeq++;
+        item.value  = std::move(slot.value);
+        item.cancel = std::move(slot.cancel);
+        slot.value.reset();
+        slot.ready.store(false, std::memory_order_release);
+    }
+    this->noteTaken();
+    return true;
+}
+
+template <class In, class Out, class F>
+bool XStage<In, Out, F>::hasNext(uint64_t nextSeq) const
+{
+    if (mOrdered) return !mOrdered->emptyApprox();
+    return mReorder[nextSeq % mReorderSize].ready.load(std::memory_order_acquire);
+}
+
+template <class In, class Out, class F>
+void XStage<In, Out, F>::drain()
+{
+    Item item;
+    for (;;) {
+        while (take(item)) process(item);
+
+        // mNextSeq belongs to whichever drain is active, so read it first.
+        const uint64_t next = mNextSeq;
+        mActive.store(false, std::memory_order_release);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!hasNext(next)) return;
+        if (mActive.exchange(true, std::memory_order_acq_rel)) return;  // another drain took over
+    }
+}
+
+template <class In, class Out, class F>
+void XStage<In, Out, F>::runOne()
+{
+    // Each accepted frame spawns one runOne(); a frame pushed by a slower
+    // producer may still be in the middle of publication.
+    Item item;
+    while (!mShared->tryPop(item)) std::this_thread::yield();
+    this->noteTaken();
+    process(item);
+}
+
+template <class In, class Out, class F>
+void XStage<In, Out, F>::process(Item& item)
+{
+    if (item.value && item.cancel.isCancelled()) {
+        this->noteCancelled();
+        item.value.reset();
+    }
+
+    if constexpr (std::is_void_v<Out>) {
+        if (item.value) {
+            this->execute([&] { std::invoke(mFunc, std::move(*item.value)); });
+        }
+        item.value.reset();
+        item.cancel = {};
+        this->mCore.retire();
+    } else {
+        std::optional<Out> out;
+        if (item.value) {
+            this->execute([&] { out.emplace(std::invoke(mFunc, std::move(*item.value))); });
+        }
+        item.value.reset();
+        this->next->accept(item.seq, std::move(out), std::move(item.cancel));
+    }
+}
+
+// ============================================================================
+// XPipelineCore
+// ============================================================================
+
+inline XPipelineCore::XPipelineCore(XThreadpool& pool, const XPipelineOptions& opt)
+    : mPool(pool), mMaxInFlight(std::max<size_t>(opt.maxInFlight, 1)), mGroup(pool) {}
+
+inline bool XPipelineCore::admit(bool blocking)
+{
+    size_t n = mInFlight.load(std::memory_order_relaxed);
+    for (;;) {
+        if (n < mMaxInFlight) {
+            if (mInFlight.compare_exchange_weak(n, n + 1, std::memory_order_acq_rel)) break;
+            continue;
+        }
+        if (!blocking) return false;
+
+        // Backpressure: help the stages drain instead of just sleeping.
+        if (!mPool.tryRunPending()) {
+            mWaiters.fetch_add(1, std::memory_order_seq_cst);
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mSlotFreed.wait_for(lock, std::chrono::milliseconds(1),
+                                    [this] { return mInFlight.load(std::memory_order_seq_cst) < mMaxInFlight; });
+            }
+            mWaiters.fetch_sub(1, std::memory_order_relaxed);
+        }
+        n = mInFlight.load(std::memory_order_relaxed);
+    }
+
+    if (mStartNs.load(std::memory_order_relaxed) < 0) {
+        int64_t    expected = -1;
+        const auto now      = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch());
+        mStartNs.compare_exchange_strong(expected, now.count(), std::memory_order_relaxed);
+    }
+    return true;
+}
+
+inline void XPipelineCore::retire()
+{
+    mCompleted.fetch_add(1, std::memory_order_relaxed);
+    mInFlight.fetch_sub(1, std::memory_order_seq_cst);
+    if (mWaiters.load(std::memory_order_seq_cst) > 0) {
+        { std::lock_guard<std::mutex> lock(mMutex); }
+        mSlotFreed.notify_all();
+    }
+}
+
+inline XPipelineStats XPipelineCore::stats() const
+{
+    XPipelineStats s;
+    s.pushed    = mNextSeq.load(std::memory_order_relaxed);
+    s.completed = mCompleted.load(std::memory_order_relaxed);
+    s.inFlight  = mInFlight.load(std::memory_order_relaxed);
+
+    const int64_t start = mStartNs.load(std::memory_order_relaxed);
+    if (start >= 0) {
+        const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch());
+        s.seconds      = static_cast<double>(now.count() - start) * 1e-9;
+    }
+    s.stages.reserve(mStages.size());
+    for (const auto& stage : mStages) {
+        s.stages.push_back(stage->snapshot(s.seconds));
+    }
+    return s;
+}
+
+}  // namespace detail
+
+// ============================================================================
+// XPipeline
+// ============================================================================
+
+template <class In>
+int XPipeline<In>::push(In value, const XCancelToken& cancel)
+{
+    if (cancel.isCancelled()) return err::kErrorAborted;
+    mCore->admit(true);
+    mHead->accept(mCore->nextSeq(), std::optional<In>(std::move(value)), XCancelToken(cancel));
+    return err::kSuccess;
+}
+
+template <class In>
+int XPipeline<In>::tryPush(In& value, const XCancelToken& cancel)
+{
+    if (cancel.isCancelled()) return err::kErrorAborted;
+    if (!mCore->admit(false)) return err::kErrorBusy;
+    mHead->accept(mCore->nextSeq(), std::optional<In>(std::move(value)), XCancelToken(cancel));
+    return err::kSuccess;
+}
+
+// ============================================================================
+// XPipelineBuilder
+// ============================================================================
+
+template <class In, class Cur>
+XPipelineBuilder<In, Cur>::XPipelineBuilder(XThreadpool& pool, const XPipelineOptions& opt)
+    : mCore(std::make_unique<detail::XPipelineCore>(pool, opt)) {}
+
+template <class In, class Cur>
+template <class F>
+auto XPipelineBuilder<In, Cur>::serial(std::string name, F&& fn) &&
+{
+    return addStage(std::move(name), kStageSerial, std::forward<F>(fn));
+}
+
+template <class In, class Cur>
+template <class F>
+auto XPipelineBuilder<In, Cur>::parallel(std::string name, F&& fn) &&
+{
+    return addStage(std::move(name), kStageParallel, std::forward<F>(fn));
+}
+
+template <class In, class Cur>
+template <class F>
+auto XPipelineBuilder<In, Cur>::addStage(std::string name, XStageMode mode, F&& fn)
+{
+    static_assert(!std::is_void_v<Cur>, "the sink (a stage returning void) must be the last stage");
+    using Fn = std::decay_t<F>;
+    static_assert(std::is_invocable_v<Fn&, Cur&&>, "stage function must accept the previous stage's result");
+    using Out = std::invoke_result_t<Fn&, Cur&&>;
+
+    // Frames reach this stage in order only from a serial predecessor; the
+    // first stage is fed by push(), possibly from several threads.
+    const bool ordered = mTail != nullptr && mTailSerial;
+    auto*      stage   = new detail::XStage<Cur, Out, Fn>(*mCore, std::move(name), mode, ordered, Fn(std::forward<F>(fn)));
+    mCore->addStage(stage);
+    if (mTail) {
+        mTail->next = stage;
+    } else {
+        if constexpr (std::is_same_v<Cur, In>) mHead = stage;
+    }
+
+    XPipelineBuilder<In, Out> next;
+    next.mCore       = std::move(mCore);
+    next.mHead       = mHead;
+    next.mTail       = stage;
+    next.mTailSerial = mode == kStageSerial;
+    return next;
+}
+
+template <class In, class Cur>
+XPipeline<In> XPipelineBuilder<In, Cur>::build() &&
+{
+    static_assert(std::is_void_v<Cur>, "the last stage must be a sink returning void");
+    return XPipeline<In>(std::move(mCore), mHead);
+}
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XPIPELINE_IMPL_H_
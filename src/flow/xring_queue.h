@@ -0,0 +1,449 @@
+#ifndef AURA_FLOW_XRING_QUEUE_H_
+#define AURA_FLOW_XRING_QUEUE_H_
+
+/**
+ * @file xring_queue.h
+ * @brief Bounded lock-free ring queues.
+ *
+ *  - XSpscQueue: one producer, one consumer. Successive producers (or
+ *    consumers) may be different threads as long as they hand over through
+ *    a happens-before edge, e.g. a serial pipeline stage.
+ *  - XMpmcQueue: any number of producers and consumers (Dmitry Vyukov's
+ *    bounded MPMC queue: one sequence number per cell, no ABA).
+ *
+ * Capacity is rounded up to a power of two and fixed at construction; the
+ * storage is allocated once. Elements need not be default constructible,
+ * but their constructor must not throw once a cell is claimed.
+ *
+ * Every operation comes in three flavours:
+ *  - tryPush / tryPop return false at once when full / empty.
+ *  - spinPush / spinPop busy-wait with a CPU pause: lowest latency, for
+ *    threads that own a core.
+ *  - push / pop back off from spinning to yielding to 50 us sleeps, so an
+ *    idle consumer costs little CPU; popFor / pushFor give up after a timeout.
+ *
+ * tryPushBatch / tryPopBatch move up to n elements with one index update
+ * (one CAS for XMpmcQueue), amortising the shared-cache-line traffic that
+ * dominates single-element transfers.
+ *
+ * @example
+ *   au::flow::XMpmcQueue<Frame*> q(64);
+ *   if (!q.tryPush(frame)) dropFrame(frame);
+ *   Frame* f = nullptr;
+ *   while (q.tryPop(f)) process(f);
+ *
+ *   Frame* batch[16];
+ *   size_t n = q.tryPopBatch(batch, 16);
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace au { namespace flow {
+
+namespace detail {
+
+constexpr size_t kCacheLine = 64;
+
+inline size_t roundUpPow2(size_t n)
+{
+    size_t p = 2;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+/// Tell the core we are spinning (frees pipeline resources for the sibling hyperthread).
+inline void cpuRelax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield");
+#else
+    std::atomic_signal_fence(std::memory_order_seq_cst);
+#endif
+}
+
+/// Wait strategy of the blocking queue operations: pause, then yield, then sleep.
+class XBackoff {
+public:
+    void pause()
+    {
+        if (mRound < kSpinRounds) {
+            for (int i = 0; i < (1 << mRound); ++i) cpuRelax();
+        } else if (mRound < kSpinRounds + kYieldRounds) {
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+            return;
+        }
+        ++mRound;
+    }
+
+private:
+    static constexpr int kSpinRounds  = 7;  // 1 + 2 + ... + 64 pauses
+    static constexpr int kYieldRounds = 16;
+
+    int mRound = 0;
+};
+
+/// spin / blocking / timed push and pop, built on the queue's tryPush / tryPop.
+template <class Queue, class T>
+class XRingWaitOps {
+public:
+    /** @brief Push, busy-waiting while the queue is full. */
+    template <class U>
+    void spinPush(U&& value)
+    {
+        while (!self().tryPush(std::forward<U>(value))) cpuRelax();
+    }
+
+    /** @brief Pop, busy-waiting while the queue is empty. */
+    void spinPop(T& out)
+    {
+        while (!self().tryPop(out)) cpuRelax();
+    }
+
+    /** @brief Push, backing off to sleeps while the queue is full. */
+    template <class U>
+    void push(U&& value)
+    {
+        XBackoff backoff;
+        while (!self().tryPush(std::forward<U>(value))) backoff.pause();
+    }
+
+    /** @brief Pop, backing off to sleeps while the queue is empty. */
+    void pop(T& out)
+    {
+        XBackoff backoff;
+        while (!self().tryPop(out)) backoff.pause();
+    }
+
+    /** @brief push() giving up after @p timeout. @return false on timeout; @p value is then untouched. */
+    template <class U, class Rep, class Period>
+    bool pushFor(U&& value, std::chrono::duration<Rep, Period> timeout)
+    {
+        return waitFor(timeout, [&] { return self().tryPush(std::forward<U>(value)); });
+    }
+
+    /** @brief pop() giving up after @p timeout. @return false on timeout. */
+    template <class Rep, class Period>
+    bool popFor(T& out, std::chrono::duration<Rep, Period> timeout)
+    {
+        return waitFor(timeout, [&] { return self().tryPop(out); });
+    }
+
+private:
+    Queue& self() { return static_cast<Queue&>(*this); }
+
+    template <class Rep, class Period, class Attempt>
+    static bool waitFor(std::chrono::duration<Rep, Period> timeout, Attempt&& attempt)
+    {
+        const auto deadline = std::chrono::steady_clock::now() + timeout;
+        XBackoff   backoff;
+        while (!attempt()) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            backoff.pause();
+        }
+        return true;
+    }
+};
+
+}  // namespace detail
+
+template <typename T>
+class XSpscQueue : public detail::XRingWaitOps<XSpscQueue<T>, T> {
+public:
+    explicit XSpscQueue(size_t capacity)
+        : mMask(detail::roundUpPow2(capacity) - 1), mCells(new Cell[mMask + 1]) {}
+
+    ~XSpscQueue()
+    {
+        const size_t tail = mTail.load(std::memory_order_acquire);
+        for (size_t i = mHead.load(std::memory_order_relaxed); i != tail; ++i) {
+            mCells[i & mMask].ptr()->~T();
+        }
+    }
+
+    XSpscQueue(const XSpscQueue&) = delete;
+    XSpscQueue& operator=(const XSpscQueue&) = delete;
+
+    /** @brief Producer side. @return false if the queue is full. */
+    template <class U>
+    bool tryPush(U&& value)
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHeadCache > mMask) {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            if (tail - mHeadCache > mMask) return false;
+        }
+        ::new (mCells[tail & mMask].ptr()) T(std::forward<U>(value));
+        mTail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** @brief Consumer side. @return false if the queue is empty. */
+    bool tryPop(T& out)
+    {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (head == mTailCache) {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            if (head == mTailCache) return false;
+        }
+        T* p = mCells[head & mMask].ptr();
+        out  = std::move(*p);
+        p->~T();
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Producer side: construct up to @p count elements from @p first,
+     *        first..first+count-1 (pass std::make_move_iterator to move them).
+     * @return the number pushed, a prefix of the input; 0 if full.
+     */
+    template <class It>
+    size_t tryPushBatch(It first, size_t count)
+    {
+        const size_t tail = mTail.load(std::memory_order_relaxed);
+        if (tail - mHeadCache + count > mMask + 1) mHeadCache = mHead.load(std::memory_order_acquire);
+        const size_t n = std::min(count, mMask + 1 - (tail - mHeadCache));
+        for (size_t i = 0; i < n; ++i, ++first) {
+            ::new (mCells[(tail + i) & mMask].ptr()) T(*first);
+        }
+        mTail.store(tail + n, std::memory_order_release);
+        return n;
+    }
+
+    /**
+     * @brief Consumer side: move up to @p maxCount elements to @p out.
+     * @return the number popped; 0 if empty.
+     */
+    template <class OutIt>
+    size_t tryPopBatch(OutIt out, size_t maxCount)
+    {
+        const size_t head = mHead.load(std::memory_order_relaxed);
+        if (mTailCache - head < maxCount) mTailCache = mTail.load(std::memory_order_acquire);
+        const size_t n = std::min(maxCount, mTailCache - head);
+        for (size_t i = 0; i < n; ++i, ++out) {
+            T* p = mCells[(head + i) & mMask].ptr();
+            *out = std::move(*p);
+            p->~T();
+        }
+        mHead.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    size_t capacity() const { return mMask + 1; }
+
+    /** @brief Element count; exact only when neither side is active. */
+    size_t sizeApprox() const
+    {
+        return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire);
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+
+private:
+    struct Cell {
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    const size_t            mMask;
+    std::unique_ptr<Cell[]> mCells;
+
+    // Each side keeps a cached copy of the other's index so the common case
+    // touches only its own cache line.
+    alignas(detail::kCacheLine) std::atomic<size_t> mHead{0};
+    size_t mTailCache = 0;
+    alignas(detail::kCacheLine) std::atomic<size_t> mTail{0};
+    size_t mHeadCache = 0;
+};
+
+template <typename T>
+class XMpmcQueue : public detail::XRingWaitOps<XMpmcQueue<T>, T> {
+public:
+    explicit XMpmcQueue(size_t capacity)
+        : mMask(detail::roundUpPow2(capacity) - 1), mCells(new Cell[mMask + 1])
+    {
+        for (size_t i = 0; i <= mMask; ++i) {
+            mCells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~XMpmcQueue()
+    {
+        const size_t enq = mEnqueuePos.load(std::memory_order_acquire);
+        for (size_t i = mDequeuePos.load(std::memory_order_relaxed); i != enq; ++i) {
+            Cell& cell = mCells[i & mMask];
+            if (cell.seq.load(std::memory_order_acquire) == i + 1) cell.ptr()->~T();
+        }
+    }
+
+    XMpmcQueue(const XMpmcQueue&) = delete;
+    XMpmcQueue& operator=(const XMpmcQueue&) = delete;
+
+    /**
+     * @brief Push from any thread.
+     * @return false if the queue is full. A consumer that has claimed the
+     *         oldest cell but not yet released it also counts as full.
+     */
+    template <class U>
+    bool tryPush(U&& value)
+    {
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell&          cell = mCells[pos & mMask];
+            const size_t   seq  = cell.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (mEnqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    ::new (cell.ptr()) T(std::forward<U>(value));
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** @brief Pop from any thread. @return false if the queue is empty. */
+    bool tryPop(T& out)
+    {
+        size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell&          cell = mCells[pos & mMask];
+            const size_t   seq  = cell.seq.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (mDequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    T* p = cell.ptr();
+                    out  = std::move(*p);
+                    p->~T();
+                    cell.seq.store(pos + mMask + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mDequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief Push up to @p count elements from @p first, claiming the free
+     *        cells with a single CAS. Elements of one batch stay contiguous.
+     * @return the number pushed, a prefix of the input; 0 if full.
+     */
+    template <class It>
+    size_t tryPushBatch(It first, size_t count)
+    {
+        if (count == 0) return 0;
+        size_t pos = mEnqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            // A cell is free for position p when its sequence equals p.
+            const size_t n = readyRun(pos, count, 0);
+            if (n == 0) {
+                const size_t seq = mCells[pos & mMask].seq.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0) return 0;
+                pos = mEnqueuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (mEnqueuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < n; ++i, ++first) {
+                    Cell& cell = mCells[(pos + i) & mMask];
+                    ::new (cell.ptr()) T(*first);
+                    cell.seq.store(pos + i + 1, std::memory_order_release);
+                }
+                return n;
+            }
+        }
+    }
+
+    /**
+     * @brief Pop up to @p maxCount elements into @p out with a single CAS.
+     * @return the number popped; 0 if empty.
+     */
+    template <class OutIt>
+    size_t tryPopBatch(OutIt out, size_t maxCount)
+    {
+        if (maxCount == 0) return 0;
+        size_t pos = mDequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            // A cell holds the element of position p when its sequence equals p + 1.
+            const size_t n = readyRun(pos, maxCount, 1);
+            if (n == 0) {
+                const size_t seq = mCells[pos & mMask].seq.load(std::memory_order_acquire);
+                if (static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0) return 0;
+                pos = mDequeuePos.load(std::memory_order_relaxed);
+                continue;
+            }
+            if (mDequeuePos.compare_exchange_weak(pos, pos + n, std::memory_order_relaxed)) {
+                for (size_t i = 0; i < n; ++i, ++out) {
+                    Cell& cell = mCells[(pos + i) & mMask];
+                    T*    p    = cell.ptr();
+                    *out       = std::move(*p);
+                    p->~T();
+                    cell.seq.store(pos + i + mMask + 1, std::memory_order_release);
+                }
+                return n;
+            }
+        }
+    }
+
+    size_t capacity() const { return mMask + 1; }
+
+    /** @brief Element count; a snapshot that may be stale under concurrency. */
+    size_t sizeApprox() const
+    {
+        const size_t enq = mEnqueuePos.load(std::memory_order_acquire);
+        const size_t deq = mDequeuePos.load(std::memory_order_acquire);
+        return enq > deq ? enq - deq : 0;
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+
+private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        alignas(T) unsigned char storage[sizeof(T)];
+        T* ptr() { return std::launder(reinterpret_cast<T*>(storage)); }
+    };
+
+    /// Consecutive cells from @p pos (at most @p limit) whose sequence is position + @p offset.
+    size_t readyRun(size_t pos, size_t limit, size_t offset) const
+    {
+        size_t n = 0;
+        while (n < limit && mCells[(pos + n) & mMask].seq.load(std::memory_order_acquire) == pos + n + offset) ++n;
+        return n;
+    }
+
+    const size_t            mMask;
+    std::unique_ptr<Cell[]> mCells;
+
+    alignas(detail::kCacheLine) std::atomic<size_t> mEnqueuePos{0};
+    alignas(detail::kCacheLine) std::atomic<size_t> mDequeuePos{0};
+};
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XRING_QUEUE_H_
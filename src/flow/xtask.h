@@ -0,0 +1,338 @@
+#ifndef AURA_FLOW_XTASK_H_
+#define AURA_FLOW_XTASK_H_
+
+/**
+ * @file xtask.h
+ * @brief Move-only task type with small-buffer storage, plus the block pools
+ *        that keep task submission off the global heap.
+ *
+ * XTask stores callables of up to kInlineSize bytes in place. Larger ones go
+ * to a size-class block pool, and only callables above the largest class or
+ * aligned beyond max_align_t hit operator new.
+ *
+ * XBlockPool keeps a per-thread free list per size class and exchanges
+ * batches with a process-wide list under a mutex. Blocks freed on another
+ * thread (e.g. a worker) flow back to producers batch by batch, so a steady
+ * producer/consumer pattern stops allocating after warm-up.
+ *
+ * @example
+ *   au::flow::XTask t([buf, n] { process(buf, n); });
+ *   t();
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace au { namespace flow {
+
+namespace detail {
+
+/// Allocations the task pools could not serve and passed to operator new.
+/// Benchmarks read it to check that steady-state submission stays pooled.
+inline std::atomic<size_t>& poolHeapFallbacks() noexcept
+{
+    static std::atomic<size_t> count{0};
+    return count;
+}
+
+/**
+ * @brief Fixed-size block pool with thread-local caches.
+ * @tparam BlockSize Bytes per block (multiple of alignof(std::max_align_t)).
+ */
+template <size_t BlockSize>
+class XBlockPool {
+    static_assert(BlockSize % alignof(std::max_align_t) == 0, "block size must keep max alignment");
+
+public:
+    static void* allocate()
+    {
+        Cache& c = cache();
+        if (!c.head) refill(c);
+        if (!c.head) {
+            poolHeapFallbacks().fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(BlockSize);
+        }
+        Block* b = c.head;
+        c.head   = b->next;
+        --c.count;
+        return b;
+    }
+
+    static void deallocate(void* p) noexcept
+    {
+        Cache& c  = cache();
+        Block* b  = static_cast<Block*>(p);
+        b->next   = c.head;
+        c.head    = b;
+        if (++c.count >= 2 * kBatch) {
+            release(c, kBatch);
+        }
+    }
+
+private:
+    struct Block {
+        Block* next;
+    };
+
+    static constexpr size_t kBatch = 64;
+
+    struct Shared {
+        std::mutex mutex;
+        Block*     head  = nullptr;
+        size_t     count = 0;
+    };
+
+    struct Cache {
+        Block* head  = nullptr;
+        size_t count = 0;
+        ~Cache() { release(*this, count); }
+    };
+
+    /// Intentionally leaked: thread-local caches flush into it during exit.
+    static Shared& shared()
+    {
+        static Shared* s = new Shared();
+        return *s;
+    }
+
+    static Cache& cache()
+    {
+        static thread_local Cache c;
+        return c;
+    }
+
+    static void refill(Cache& c)
+    {
+        Shared&                     s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (size_t i = 0; i < kBatch && s.head; ++i) {
+            Block* b = s.head;
+            s.head   = b->next;
+            --s.count;
+            b->next = c.head;
+            c.head  = b;
+            ++c.count;
+        }
+    }
+
+    static void release(Cache& c, size_t n)
+    {
+        if (n == 0 || !c.head) return;
+        Block* first = c.head;
+        Block* last  = first;
+        size_t moved = 1;
+        while (moved < n && last->next) {
+            last = last->next;
+            ++moved;
+        }
+        c.head = last->next;
+        c.count -= moved;
+
+        Shared&                     s = shared();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        last->next = s.head;
+        s.head     = first;
+        s.count += moved;
+    }
+};
+
+/// Largest size served by the block pools; beyond it we fall back to operator new.
+constexpr size_t kMaxPooledBlock = 512;
+
+constexpr size_t blockClass(size_t bytes)
+{
+    return bytes <= 64 ? 64 : bytes <= 128 ? 128 : bytes <= 256 ? 256 : bytes <= 512 ? 512 : 0;
+}
+
+inline void* poolAllocate(size_t bytes)
+{
+    switch (blockClass(bytes)) {
+        case 64:  return XBlockPool<64>::allocate();
+        case 128: return XBlockPool<128>::allocate();
+        case 256: return XBlockPool<256>::allocate();
+        case 512: return XBlockPool<512>::allocate();
+        default:
+            poolHeapFallbacks().fetch_add(1, std::memory_order_relaxed);
+            return ::operator new(bytes);
+    }
+}
+
+inline void poolDeallocate(void* p, size_t bytes) noexcept
+{
+    switch (blockClass(bytes)) {
+        case 64:  XBlockPool<64>::deallocate(p); break;
+        case 128: XBlockPool<128>::deallocate(p); break;
+        case 256: XBlockPool<256>::deallocate(p); break;
+        case 512: XBlockPool<512>::deallocate(p); break;
+        default:  ::operator delete(p); break;
+    }
+}
+
+/**
+ * @brief std-compatible allocator on top of the block pools.
+ *
+ * Used for std::promise shared state so enqueue()'s completion state is
+ * recycled instead of allocated per task.
+ */
+template <typename T>
+struct XPoolAllocator {
+    using value_type = T;
+
+    XPoolAllocator() noexcept = default;
+    template <typename U>
+    XPoolAllocator(const XPoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+        static_assert(alignof(T) <= alignof(std::max_align_t), "over-aligned types are not pooled");
+        return static_cast<T*>(poolAllocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) noexcept { poolDeallocate(p, n * sizeof(T)); }
+
+    template <typename U>
+    bool operator==(const XPoolAllocator<U>&) const noexcept { return true; }
+    template <typename U>
+    bool operator!=(const XPoolAllocator<U>&) const noexcept { return false; }
+};
+
+}  // namespace detail
+
+/**
+ * @brief Move-only, type-erased `void()` callable with inline storage.
+ */
+class XTask {
+public:
+    /// Captures up to this many bytes are stored without any allocation.
+    static constexpr size_t kInlineSize = 64;
+
+    XTask() noexcept = default;
+
+    template <class F, class Fn = std::decay_t<F>, class = std::enable_if_t<!std::is_same_v<Fn, XTask>>>
+    XTask(F&& f)  // NOLINT: implicit by design, like std::function
+    {
+        static_assert(std::is_invocable_v<Fn&>, "XTask requires a callable with no arguments");
+        if constexpr (fitsInline<Fn>()) {
+            ::new (static_cast<void*>(mStorage)) Fn(std::forward<F>(f));
+            mOps = &kInlineOps<Fn>;
+        } else {
+            void* mem = allocateFn<Fn>();
+            try {
+                ::new (mem) Fn(std::forward<F>(f));
+            } catch (...) {
+                deallocateFn<Fn>(mem);
+                throw;
+            }
+            *reinterpret_cast<void**>(mStorage) = mem;
+            mOps = &kHeapOps<Fn>;
+        }
+    }
+
+    XTask(XTask&& other) noexcept { moveFrom(other); }
+
+    XTask& operator=(XTask&& other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    XTask(const XTask&) = delete;
+    XTask& operator=(const XTask&) = delete;
+
+    ~XTask() { reset(); }
+
+    void operator()() { mOps->invoke(mStorage); }
+
+    explicit operator bool() const noexcept { return mOps != nullptr; }
+
+    void reset() noexcept
+    {
+        if (mOps) {
+            mOps->destroy(mStorage);
+            mOps = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;  // move-construct dst, destroy src
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <class Fn>
+    static constexpr bool fitsInline()
+    {
+        return sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+               std::is_nothrow_move_constructible_v<Fn>;
+    }
+
+    /// The block pools only guarantee max_align_t; over-aligned callables
+    /// go to the aligned operator new instead.
+    template <class Fn>
+    static void* allocateFn()
+    {
+        if constexpr (alignof(Fn) > alignof(std::max_align_t)) {
+            return ::operator new(sizeof(Fn), std::align_val_t(alignof(Fn)));
+        } else {
+            return detail::poolAllocate(sizeof(Fn));
+        }
+    }
+
+    template <class Fn>
+    static void deallocateFn(void* p) noexcept
+    {
+        if constexpr (alignof(Fn) > alignof(std::max_align_t)) {
+            ::operator delete(p, std::align_val_t(alignof(Fn)));
+        } else {
+            detail::poolDeallocate(p, sizeof(Fn));
+        }
+    }
+
+    template <class Fn>
+    static inline const Ops kInlineOps = {
+        [](void* s) { (*std::launder(static_cast<Fn*>(s)))(); },
+        [](void* dst, void* src) noexcept {
+            Fn* from = std::launder(static_cast<Fn*>(src));
+            ::new (dst) Fn(std::move(*from));
+            from->~Fn();
+        },
+        [](void* s) noexcept { std::launder(static_cast<Fn*>(s))->~Fn(); },
+    };
+
+    template <class Fn>
+    static inline const Ops kHeapOps = {
+        [](void* s) { (**static_cast<Fn**>(s))(); },
+        [](void* dst, void* src) noexcept { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); },
+        [](void* s) noexcept {
+            Fn* fn = *static_cast<Fn**>(s);
+            fn->~Fn();
+            deallocateFn<Fn>(fn);
+        },
+    };
+
+    void moveFrom(XTask& other) noexcept
+    {
+        if (other.mOps) {
+            other.mOps->move(mStorage, other.mStorage);
+            mOps       = other.mOps;
+            other.mOps = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char mStorage[kInlineSize];
+    const Ops*                              mOps = nullptr;
+};
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XTASK_H_
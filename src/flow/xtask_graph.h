@@ -0,0 +1,140 @@
+#ifndef AURA_FLOW_XTASK_GRAPH_H_
+#define AURA_FLOW_XTASK_GRAPH_H_
+
+/**
+ * @file xtask_graph.h
+ * @brief Reusable task graph (DAG) executed on an XThreadpool.
+ *
+ * Build the graph once: named nodes plus precede()/succeed() edges. Each run
+ * resets a per-node dependency counter to its predecessor count. When a node
+ * finishes it decrements the counters of its successors and schedules every
+ * successor that reaches zero. No thread waits on a future.
+ *
+ * A run allocates nothing: node state is preallocated at build time and each
+ * scheduled node is a small pooled XTask. Only one run of a given graph can
+ * be in flight at a time.
+ *
+ * @example
+ *   au::flow::XTaskGraph graph("camera");
+ *   auto& decode  = graph.emplace("decode",  [&] { decodeFrame(); });
+ *   auto& denoise = graph.emplace("denoise", [&] { denoiseFrame(); });
+ *   auto& tonemap = graph.emplace("tonemap", [&] { toneMapFrame(); });
+ *   auto& encode  = graph.emplace("encode",  [&] { encodeFrame(); });
+ *   decode.precede(denoise);
+ *   denoise.precede(tonemap);
+ *   encode.succeed(tonemap);
+ *
+ *   for (;;) graph.run(pool);  // per frame
+ */
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "xthreadpool.h"
+
+namespace au { namespace flow {
+
+class XTaskGraph;
+
+class XGraphNode {
+public:
+    XGraphNode(const XGraphNode&) = delete;
+    XGraphNode& operator=(const XGraphNode&) = delete;
+
+    /** @brief Add edge this -> @p other: @p other runs after this node. */
+    XGraphNode& precede(XGraphNode& other);
+
+    /** @brief Add edge @p other -> this: this node runs after @p other. */
+    XGraphNode& succeed(XGraphNode& other);
+
+    const std::string& name() const { return mName; }
+    size_t numSuccessors() const { return mSuccessors.size(); }
+    size_t numPredecessors() const { return mNumPredecessors; }
+
+private:
+    friend class XTaskGraph;
+
+    XGraphNode(XTaskGraph& graph, std::string name, std::function<void()> work)
+        : mGraph(graph), mName(std::move(name)), mWork(std::move(work)) {}
+
+    XTaskGraph&              mGraph;
+    std::string              mName;
+    std::function<void()>    mWork;
+    std::vector<XGraphNode*> mSuccessors;
+    size_t                   mNumPredecessors = 0;
+    size_t                   mIndex           = 0;  // position in XTaskGraph::mNodes
+    std::atomic<size_t>      mPending{0};  // predecessors left in the current run
+};
+
+class XTaskGraph {
+public:
+    explicit XTaskGraph(std::string name = "graph") : mName(std::move(name)) {}
+
+    XTaskGraph(const XTaskGraph&) = delete;
+    XTaskGraph& operator=(const XTaskGraph&) = delete;
+
+    /** @brief Add a node. The returned reference stays valid for the graph's lifetime. */
+    template <class F>
+    XGraphNode& emplace(std::string name, F&& work);
+
+    /** @brief Look up a node by name, or nullptr. */
+    XGraphNode* find(const std::string& name) const;
+
+    const std::string& name() const { return mName; }
+    size_t size() const { return mNodes.size(); }
+    bool   empty() const { return mNodes.empty(); }
+
+    /**
+     * @brief Execute the graph on @p pool; the caller helps until it completes.
+     * @return err::kSuccess; err::kErrorStateInvalid if the graph has a cycle;
+     *         err::kErrorBusy if a run is already in flight; err::kErrorAborted
+     *         if a node threw (the remaining nodes are skipped).
+     */
+    int run(XThreadpool& pool);
+
+    /**
+     * @brief Start the graph on @p pool and return immediately.
+     *
+     * @p onDone runs on the thread that finishes the last node; query
+     * status() from it. The graph must outlive the run.
+     */
+    int runAsync(XThreadpool& pool, XTask onDone = {});
+
+    /** @brief True while a run is in flight. */
+    bool isRunning() const { return mRunning.load(std::memory_order_acquire); }
+
+    /** @brief Result of the last completed run (see run()). */
+    int status() const { return mStatus.load(std::memory_order_acquire); }
+
+private:
+    friend class XGraphNode;
+
+    int  start(XThreadpool& pool, XTaskGroup* group, XTask onDone);
+    int  validate();
+    void schedule(XGraphNode* node);
+    void execute(XGraphNode* node);
+    void finish();
+
+    std::string                              mName;
+    std::vector<std::unique_ptr<XGraphNode>> mNodes;
+    std::vector<XGraphNode*>                 mRoots;
+    bool                                     mValidated = false;
+
+    // Per-run state.
+    XThreadpool*        mPool  = nullptr;
+    XTaskGroup*         mGroup = nullptr;  // set for blocking runs
+    XTask               mOnDone;
+    std::atomic<size_t> mRemaining{0};
+    std::atomic<bool>   mRunning{false};
+    std::atomic<bool>   mFailed{false};
+    std::atomic<int>    mStatus{0};
+};
+
+}}  // namespace au::flow
+
+#include "xtask_graph.impl.h"
+
+#endif // AURA_FLOW_XTASK_GRAPH_H_
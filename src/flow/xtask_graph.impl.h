@@ -0,0 +1,173 @@
+#ifndef AURA_FLOW_XTASK_GRAPH_IMPL_H_
+#define AURA_FLOW_XTASK_GRAPH_IMPL_H_
+
+#include "log/xerror.h"
+#include "log/xlogger.h"
+#include "xtask_graph.h"
+
+namespace au { namespace flow {
+
+// ============================================================================
+// XGraphNode
+// ============================================================================
+
+inline XGraphNode& XGraphNode::precede(XGraphNode& other)
+{
+    XCHECK(&other.mGraph == &mGraph);
+    XCHECK(!mGraph.isRunning());
+    mSuccessors.push_back(&other);
+    ++other.mNumPredecessors;
+    mGraph.mValidated = false;
+    return *this;
+}
+
+inline XGraphNode& XGraphNode::succeed(XGraphNode& other)
+{
+    other.precede(*this);
+    return *this;
+}
+
+// ============================================================================
+// XTaskGraph
+// ============================================================================
+
+template <class F>
+XGraphNode& XTaskGraph::emplace(std::string name, F&& work)
+{
+    XCHECK(!isRunning());
+    mNodes.emplace_back(new XGraphNode(*this, std::move(name), std::function<void()>(std::forward<F>(work))));
+    mNodes.back()->mIndex = mNodes.size() - 1;
+    mValidated = false;
+    return *mNodes.back();
+}
+
+inline XGraphNode* XTaskGraph::find(const std::string& name) const
+{
+    for (const auto& node : mNodes) {
+        if (node->mName == name) return node.get();
+    }
+    return nullptr;
+}
+
+inline int XTaskGraph::validate()
+{
+    if (mValidated) return err::kSuccess;
+
+    // Kahn's algorithm: every node must become ready exactly once.
+    std::vector<size_t>      indegree(mNodes.size());
+    std::vector<XGraphNode*> ready;
+    mRoots.clear();
+    for (size_t i = 0; i < mNodes.size(); ++i) {
+        indegree[i] = mNodes[i]->mNumPredecessors;
+        if (indegree[i] == 0) {
+            mRoots.push_back(mNodes[i].get());
+            ready.push_back(mNodes[i].get());
+        }
+    }
+
+    size_t visited = 0;
+    while (!ready.empty()) {
+        XGraphNode* n = ready.back();
+        ready.pop_back();
+        ++visited;
+        for (XGraphNode* s : n->mSuccessors) {
+            if (--indegree[s->mIndex] == 0) ready.push_back(s);
+        }
+    }
+    XCHECK_WITH_MSG(visited == mNodes.size(), err::kErrorStateInvalid, "task graph '%s' has a cycle\n",
+                    mName.c_str());
+
+    mValidated = true;
+    return err::kSuccess;
+}
+
+inline int XTaskGraph::start(XThreadpool& pool, XTaskGroup* group, XTask onDone)
+{
+    bool expected = false;
+    XCHECK_WITH_RET(mRunning.compare_exchange_strong(expected, true, std::memory_order_acq_rel), err::kErrorBusy);
+
+    int ret = validate();
+    if (err::isError(ret) || mNodes.empty()) {
+        mStatus.store(ret, std::memory_order_release);
+        mRunning.store(false, std::memory_order_release);
+        if (onDone) onDone();
+        return ret;
+    }
+
+    for (auto& node : mNodes) {
+        node->mPending.store(node->mNumPredecessors, std::memory_order_relaxed);
+    }
+    mPool   = &pool;
+    mGroup  = group;
+    mOnDone = std::move(onDone);
+    mFailed.store(false, std::memory_order_relaxed);
+    mRemaining.store(mNodes.size(), std::memory_order_release);
+
+    for (XGraphNode* root : mRoots) {
+        schedule(root);
+    }
+    return err::kSuccess;
+}
+
+inline int XTaskGraph::run(XThreadpool& pool)
+{
+    XTaskGroup group(pool);
+    int        ret = start(pool, &group, {});
+    if (err::isError(ret)) return ret;
+    group.wait();
+    return status();
+}
+
+inline int XTaskGraph::runAsync(XThreadpool& pool, XTask onDone)
+{
+    return start(pool, nullptr, std::move(onDone));
+}
+
+inline void XTaskGraph::schedule(XGraphNode* node)
+{
+    if (mGroup) {
+        mGroup->run([this, node] { execute(node); });
+    } else {
+        mPool->submit([this, node] { execute(node); });
+    }
+}
+
+inline void XTaskGraph::execute(XGraphNode* node)
+{
+    if (!mFailed.load(std::memory_order_relaxed) && node->mWork) {
+        try {
+            node->mWork();
+        } catch (const std::exception& e) {
+            XLOG_E("task graph '%s': node '%s' threw: %s\n", mName.c_str(), node->mName.c_str(), e.what());
+            mFailed.store(true, std::memory_order_relaxed);
+        } catch (...) {
+            XLOG_E("task graph '%s': node '%s' threw\n", mName.c_str(), node->mName.c_str());
+            mFailed.store(true, std::memory_order_relaxed);
+        }
+    }
+
+    // Successors are released even after a failure (their work is skipped)
+    // so the run always drains and the graph can be run again.
+    for (XGraphNode* succ : node->mSuccessors) {
+        if (succ->mPending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            schedule(succ);
+        }
+    }
+    if (mRemaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        finish();
+    }
+}
+
+inline void XTaskGraph::finish()
+{
+    XTask onDone = std::move(mOnDone);
+    mStatus.store(mFailed.load(std::memory_order_relaxed) ? err::kErrorAborted : err::kSuccess,
+                  std::memory_order_release);
+    mGroup = nullptr;
+    mRunning.store(false, std::memory_order_release);
+    if (onDone) onDone();
+}
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XTASK_GRAPH_IMPL_H_
@@ -8,13 +8,48 @@
  * @example
  *   auto& flow = au::flow::XFlow::get();
  *   flow.init(4, 2);  // 4 workers, 2 pipelines
+ *   flow.resize(2, 1);  // thermally throttled: shed threads without re-init
  *
  *   // Parallel tiled loop
  *   flow.parallelizeTiledTasks(100, 10, [](size_t i, size_t tile) {
  *       // process items [i, i+tile)
  *   });
+ *
+ *   // Drop stale tiles once the frame is dropped (frame.cancel() from any thread)
+ *   au::flow::XCancelSource frame;
+ *   flow.parallelizeTiledTasks(100, 10, denoiseTile, frame.token());
+ *
+ *   // Adaptive loop: grain chosen from measured per-item cost, caller helps
+ *   flow.parallelFor(height, [](size_t row, size_t count) {
+ *       // process rows [row, row+count)
+ *   });
+ *
+ *   // Reductions, scans and sorts without hand-rolled per-tile partials
+ *   int64_t sum = flow.parallelReduce(pixels.begin(), pixels.end(), int64_t(0), std::plus<>());
+ *   flow.parallelSort(keys.begin(), keys.end());
+ *
+ *   // Preview must not queue behind analytics
+ *   flow.addPipeline(au::flow::kPriorityHigh, renderPreview, frame);
+ *   flow.addPipeline(au::flow::kPriorityBackground, runAnalytics, frame);
+ *
+ *   // Dependent stages: build once, run per frame on the pipeline threads
+ *   au::flow::XTaskGraph graph("camera");
+ *   graph.emplace("decode", decode).precede(graph.emplace("denoise", denoise));
+ *   flow.runGraph(graph);
+ *
+ *   // Streaming: overlapping frames, at most 3 in flight
+ *   auto stream = flow.makePipeline<RawFrame>({3})
+ *                     .serial("decode", decode)
+ *                     .parallel("denoise", denoise)
+ *                     .serial("encode", encode)
+ *                     .build();
+ *   stream.push(std::move(raw));
  */
 
+#include "xparallel_algorithm.h"
+#include "xparallel_for.h"
+#include "xpipeline.h"
+#include "xtask_graph.h"
 #include "xthreadpool.h"
 #include <memory>
 
@@ -34,10 +69,87 @@ public:
 
     int init(size_t workers, size_t pipelines);
 
-    int parallelizeTiledTasks(size_t range, size_t tile, std::function<void(size_t, size_t)>&& f);
+    /** @brief Initialise with full pool options, e.g. pipelines pinned to the performance cores. */
+    int init(const XThreadpoolOptions& workers, const XThreadpoolOptions& pipelines);
+
+    /**
+     * @brief Resize both pools at runtime, e.g. shrink while thermally throttled.
+     * @return err::kErrorNotReady before init(), err::kErrorInvalidParam if a
+     *         size exceeds the pool's maxThreads (then neither pool changes).
+     */
+    int resize(size_t workers, size_t pipelines);
+
+    /**
+     * @brief Run f(start, count) over [0, range) in tiles of @p tile on the worker threads.
+     *
+     * Tiles not yet started when @p cancel fires are skipped (e.g. the frame
+     * was dropped upstream); the call then returns err::kErrorAborted.
+     * If a tile throws, tiles not yet started are skipped and the first
+     * exception is rethrown once the running ones have finished.
+     */
+    int parallelizeTiledTasks(size_t range, size_t tile, std::function<void(size_t, size_t)>&& f,
+                              const XCancelToken& cancel = {});
+
+    /**
+     * @brief Fork-join loop over [0, range) with lazy binary splitting.
+     *
+     * Unlike parallelizeTiledTasks the caller picks no tile: the grain adapts
+     * to the measured cost of f(start, count), and the calling thread runs
+     * part of the range itself instead of blocking on futures.
+     */
+    template <class F>
+    int parallelFor(size_t range, F&& f, const XParallelForOptions& opt = {});
+
+    /**
+     * @name Parallel algorithms on the worker threads
+     * Same arguments as the free functions in xparallel_algorithm.h, minus the pool.
+     */
+    ///@{
+    template <class... Args>
+    auto parallelReduce(Args&&... args);
+
+    template <class... Args>
+    auto parallelTransformReduce(Args&&... args);
 
+    template <class... Args>
+    auto parallelInclusiveScan(Args&&... args);
+
+    template <class... Args>
+    auto parallelExclusiveScan(Args&&... args);
+
+    template <class... Args>
+    void parallelSort(Args&&... args);
+    ///@}
+
+    template <class F, class... Args, class = std::enable_if_t<!detail::isTaskOption<F>>>
+    auto addPipeline(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        return addPipeline(kPriorityNormal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /** @brief Run a pipeline task on the lane @p priority (e.g. kPriorityHigh for preview). */
     template <class F, class... Args>
-    auto addPipeline(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
+    auto addPipeline(XTaskPriority priority, F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
+
+    /** @brief `co_await flow.schedule()` resumes the coroutine on a worker thread (C++20; see xcoro.h). */
+    XScheduleAwaitable schedule(XTaskPriority priority = kPriorityNormal);
+
+    /** @brief Queueing-delay counters of one lane of the pipeline threads. */
+    XLaneStats laneStats(XTaskPriority priority) const;
+
+    /** @brief Per-worker counters of the worker and the pipeline pools (see XThreadpool::stats()). */
+    XThreadpoolStats workerStats() const;
+    XThreadpoolStats pipelineStats() const;
+
+    /** @brief Run a prebuilt task graph on the pipeline threads; the caller helps until done. */
+    int runGraph(XTaskGraph& graph);
+
+    /** @brief Start a prebuilt task graph on the pipeline threads; @p onDone fires after the last node. */
+    int runGraphAsync(XTaskGraph& graph, XTask onDone = {});
+
+    /** @brief Start building a streaming pipeline whose stages run on the pipeline threads. */
+    template <class In>
+    XPipelineBuilder<In, In> makePipeline(const XPipelineOptions& opt = {});
 
 private:
     XFlow();
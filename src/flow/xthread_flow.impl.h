@@ -1,6 +1,9 @@
 #ifndef AURA_FLOW_XTHREAD_FLOW_IMPL_H_
 #define AURA_FLOW_XTHREAD_FLOW_IMPL_H_
 
+#include <exception>
+
+#include "log/xerror.h"
 #include "log/xlogger.h"
 #include "xthread_flow.h"
 
@@ -13,32 +16,158 @@ inline XFlow::~XFlow() = default;
 
 inline int XFlow::init(size_t workers, size_t pipelines)
 {
-    XCHECK_WITH_RET(!mInited, kErrorAlreadyExists);
+    XThreadpoolOptions workerOpt;
+    XThreadpoolOptions pipelineOpt;
+    workerOpt.threads   = workers;
+    workerOpt.name      = "flow-work";
+    pipelineOpt.threads = pipelines;
+    pipelineOpt.name    = "flow-pipe";
+    return init(workerOpt, pipelineOpt);
+}
+
+inline int XFlow::init(const XThreadpoolOptions& workers, const XThreadpoolOptions& pipelines)
+{
+    XCHECK_WITH_RET(!mInited, err::kErrorAlreadyExists);
     mWorkers   = std::make_unique<XThreadpool>(workers);
     mPipelines = std::make_unique<XThreadpool>(pipelines);
     mInited    = true;
-    return kSuccess;
+    return err::kSuccess;
 }
 
-inline int XFlow::parallelizeTiledTasks(size_t range, size_t tile, std::function<void(size_t, size_t)>&& f)
+inline int XFlow::resize(size_t workers, size_t pipelines)
 {
-    XCHECK_WITH_RET(mInited, kErrorNotReady);
+    XCHECK_WITH_RET(mInited, err::kErrorNotReady);
+    XCHECK_WITH_RET(workers <= mWorkers->maxThreads() && pipelines <= mPipelines->maxThreads(),
+                    err::kErrorInvalidParam);
+    const int ret = mWorkers->resize(workers);
+    return ret != err::kSuccess ? ret : mPipelines->resize(pipelines);
+}
 
-    std::vector<std::future<void>> futures;
-    for (size_t i = 0; i < range; i += tile) {
-        futures.emplace_back(mWorkers->enqueue(f, i, std::min(range - i, tile)));
-    }
-    for (auto it = futures.rbegin(); it != futures.rend(); ++it) {
-        it->get();
+inline int XFlow::parallelizeTiledTasks(size_t range, size_t tile, std::function<void(size_t, size_t)>&& f,
+                                         const XCancelToken& cancel)
+{
+    XCHECK_WITH_RET(mInited, err::kErrorNotReady);
+    XCHECK_WITH_RET(tile > 0, err::kErrorInvalidParam);
+
+    // One shared counter for the whole batch instead of a future per tile.
+    // The first exception is kept (written once, read after wait()) and
+    // rethrown to the caller, as future::get() used to.
+    std::atomic<bool>  aborted{false};
+    std::atomic<bool>  failed{false};
+    std::exception_ptr error;
+    XTaskGroup         group(*mWorkers);
+    size_t             i = 0;
+    for (; i < range && !cancel.isCancelled() && !failed.load(std::memory_order_relaxed); i += tile) {
+        const size_t count = std::min(range - i, tile);
+        group.run([&f, &cancel, &aborted, &failed, &error, i, count] {
+            if (failed.load(std::memory_order_relaxed)) return;
+            if (cancel.isCancelled()) {
+                aborted.store(true, std::memory_order_relaxed);
+                return;
+            }
+            try {
+                f(i, count);
+            } catch (...) {
+                if (!failed.exchange(true, std::memory_order_relaxed)) error = std::current_exception();
+            }
+        });
     }
-    return kSuccess;
+    group.wait();
+    if (error) std::rethrow_exception(error);
+    return i < range || aborted.load(std::memory_order_relaxed) ? err::kErrorAborted : err::kSuccess;
+}
+
+template <class F>
+int XFlow::parallelFor(size_t range, F&& f, const XParallelForOptions& opt)
+{
+    XCHECK_WITH_RET(mInited, err::kErrorNotReady);
+    return au::flow::parallelFor(*mWorkers, 0, range, std::forward<F>(f), opt);
+}
+
+template <class... Args>
+auto XFlow::parallelReduce(Args&&... args)
+{
+    XCHECK(mInited);
+    return au::flow::parallelReduce(*mWorkers, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+auto XFlow::parallelTransformReduce(Args&&... args)
+{
+    XCHECK(mInited);
+    return au::flow::parallelTransformReduce(*mWorkers, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+auto XFlow::parallelInclusiveScan(Args&&... args)
+{
+    XCHECK(mInited);
+    return au::flow::parallelInclusiveScan(*mWorkers, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+auto XFlow::parallelExclusiveScan(Args&&... args)
+{
+    XCHECK(mInited);
+    return au::flow::parallelExclusiveScan(*mWorkers, std::forward<Args>(args)...);
+}
+
+template <class... Args>
+void XFlow::parallelSort(Args&&... args)
+{
+    XCHECK(mInited);
+    au::flow::parallelSort(*mWorkers, std::forward<Args>(args)...);
 }
 
 template <class F, class... Args>
-auto XFlow::addPipeline(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+auto XFlow::addPipeline(XTaskPriority priority, F&& f, Args&&... args)
+    -> std::future<std::invoke_result_t<F, Args...>>
+{
+    XCHECK(mInited);
+    return mPipelines->enqueue(priority, std::forward<F>(f), std::forward<Args>(args)...);
+}
+
+inline XScheduleAwaitable XFlow::schedule(XTaskPriority priority)
+{
+    XCHECK(mInited);
+    return mWorkers->schedule(priority);
+}
+
+inline XLaneStats XFlow::laneStats(XTaskPriority priority) const
+{
+    XCHECK_WITH_RET(mInited, XLaneStats{});
+    return mPipelines->laneStats(priority);
+}
+
+inline XThreadpoolStats XFlow::workerStats() const
+{
+    XCHECK_WITH_RET(mInited, XThreadpoolStats{});
+    return mWorkers->stats();
+}
+
+inline XThreadpoolStats XFlow::pipelineStats() const
+{
+    XCHECK_WITH_RET(mInited, XThreadpoolStats{});
+    return mPipelines->stats();
+}
+
+inline int XFlow::runGraph(XTaskGraph& graph)
+{
+    XCHECK_WITH_RET(mInited, err::kErrorNotReady);
+    return graph.run(*mPipelines);
+}
+
+inline int XFlow::runGraphAsync(XTaskGraph& graph, XTask onDone)
+{
+    XCHECK_WITH_RET(mInited, err::kErrorNotReady);
+    return graph.runAsync(*mPipelines, std::move(onDone));
+}
+
+template <class In>
+XPipelineBuilder<In, In> XFlow::makePipeline(const XPipelineOptions& opt)
 {
     XCHECK(mInited);
-    return mPipelines->enqueue(std::forward<F>(f), std::forward<Args>(args)...);
+    return au::flow::makePipeline<In>(*mPipelines, opt);
 }
 
 }  // namespace flow
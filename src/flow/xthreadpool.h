@@ -3,17 +3,102 @@
 
 /**
  * @file xthreadpool.h
- * @brief Thread pool for concurrent task execution.
+ * @brief Work-stealing thread pool for concurrent task execution.
+ *
+ * Scheduling:
+ *  - Every worker owns a Chase-Lev deque. Tasks enqueued from a worker go to
+ *    its own deque (LIFO pop, cache-warm); tasks enqueued from outside go to
+ *    a per-worker inbox picked round-robin, so external producers do not all
+ *    contend on one lock.
+ *  - An idle worker first drains its deque and inbox, then steals from
+ *    victims starting at a random index, then spins for spinNs (polling one
+ *    counter), then parks. Spinning trades CPU for wake-up latency: a burst
+ *    that starts within spinNs is picked up without a condition-variable wake.
+ *  - Parking is per worker: a submission wakes exactly one parked worker and
+ *    skips the wake entirely when nobody is parked (no notify_all herd).
+ *
+ * Sizing:
+ *  - resize() grows or shrinks the pool at runtime, up to maxThreads (worker
+ *    slots are allocated up front). Surplus workers finish their current task
+ *    and their own deque, then exit; tasks left in their inboxes are stolen.
+ *  - With idleTimeoutNs set, a worker parked that long exits; the next
+ *    submission that finds no parked worker restarts it.
+ *
+ * Priorities:
+ *  - Three lanes: high, normal and background. Normal tasks take the
+ *    work-stealing path above; high and background tasks go to two shared
+ *    FIFO lanes. An idle worker serves high, then normal, then background.
+ *  - Starvation protection: after highBurst consecutive high tasks a worker
+ *    takes one normal task if any is queued, and a background task waiting
+ *    longer than backgroundAgingNs runs ahead of both other lanes.
+ *  - laneStats() reports the enqueue-to-start delay per lane.
+ *
+ * Instrumentation:
+ *  - stats() snapshots per-worker counters: tasks run, busy and idle time,
+ *    enqueue-to-start delay, queue-depth high-water mark and steals.
+ *    writeStats() prints them through an au::perf::IPerfWriter4.
+ *  - Workers only touch their own cache line; the cost is one extra clock
+ *    read per task. Define AU_FLOW_DISABLE_STATS=1 to compile the timing,
+ *    steal and depth counters out (stats() then reports only the lane
+ *    counters: tasks and delays).
+ *
+ * Placement (XThreadpoolOptions):
+ *  - Workers can be given explicit CPU masks, restricted to the performance
+ *    cores (highest max frequency per au::sys::getCpuInfo) and/or pinned one
+ *    per core, so latency-critical work is not migrated to little cores.
+ *  - Workers are named "<name>-<index>" for profilers and can run under a
+ *    nice value or another SCHED policy. All of these are hints: a refused
+ *    request is logged and the worker runs unconstrained.
+ *
+ * NUMA (numaAware, for multi-socket servers):
+ *  - Worker i belongs to node i % nodes and runs on that node's CPUs, so the
+ *    workers of every node stay balanced at any resize() size.
+ *  - External submissions go to the inboxes of the submitting thread's own
+ *    node; submitToNode() targets a node explicitly, e.g. the one holding
+ *    the task's XNodeResource buffers.
+ *  - An idle worker steals from its own node first and crosses nodes only
+ *    when its node has nothing queued (stats() counts remoteSteals).
+ *  - Nodes come from au::sys::getNumaTopology(), or from numaNodes to fake a
+ *    layout. With fewer than two nodes the option changes nothing.
+ *
+ * Submission cost:
+ *  - Tasks are XTask objects (64-byte inline storage) in pooled nodes.
+ *  - submit() is fire-and-forget and allocation-free once the pools are warm.
+ *  - enqueue() additionally creates a std::promise whose shared state comes
+ *    from the same pools.
+ *  - XTaskGroup tracks a batch of submit()s with one counter instead of one
+ *    future per task.
+ *
+ * Cancellation:
+ *  - enqueue(XCancelToken, ...) takes a task returning void or an err:: code.
+ *    If the token is cancelled before a worker starts the task, the task is
+ *    discarded and its future resolves with err::kErrorAborted.
  *
  * @example
  *   au::flow::XThreadpool pool(4);
+ *   au::flow::XThreadpool isp({4, {}, true, true, "isp"});  // pinned to big cores
  *   auto f1 = pool.enqueue([](int a) { return a * 2; }, 21);
  *   auto f2 = pool.enqueue([]() { return std::string("hello"); });
  *   printf("%d %s\n", f1.get(), f2.get().c_str());
+ *
+ *   pool.submit(au::flow::kPriorityHigh, [&] { renderPreview(frame); });
+ *   pool.submit(au::flow::kPriorityBackground, [&] { updateStatistics(frame); });
+ *   printf("preview mean delay %.1f us\n", pool.laneStats(au::flow::kPriorityHigh).meanDelayUs());
+ *   for (auto& w : pool.stats().workers) printf("worker %zu %.0f%% busy\n", w.index, 100 * w.utilization());
+ *
+ *   au::flow::XCancelSource frame;
+ *   auto tile = pool.enqueue(frame.token(), [](size_t i) { denoiseTile(i); }, 7);
+ *   frame.cancel();  // frame dropped: tile resolves to err::kErrorAborted unless already started
+ *
+ *   au::flow::XTaskGroup group(pool);
+ *   for (int i = 0; i < 64; ++i) group.run([i] { work(i); });
+ *   group.wait();
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <vector>
-#include <queue>
 #include <memory>
 #include <thread>
 #include <mutex>
@@ -21,12 +106,127 @@
 #include <future>
 #include <functional>
 #include <stdexcept>
+#include <string>
+
+#include "perf/xtimer4.h"
+#include "sys/xplatform.h"
+#include "xcancel.h"
+#include "xtask.h"
+#include "xwork_deque.h"
 
 namespace au { namespace flow {
 
+enum XTaskPriority : int {
+    kPriorityHigh       = 0,  ///< latency-critical work, e.g. preview frames
+    kPriorityNormal     = 1,  ///< default lane
+    kPriorityBackground = 2,  ///< analytics, prefetch: runs when nothing else waits
+};
+
+constexpr int kNumPriorities = 3;
+
+namespace detail {
+
+/// Leading arguments that select an enqueue()/submit() overload rather than the task.
+template <class T>
+constexpr bool isTaskOption =
+    std::is_same_v<std::decay_t<T>, XTaskPriority> || std::is_same_v<std::decay_t<T>, XCancelToken>;
+
+}  // namespace detail
+
+/// Enqueue-to-start delay of the tasks one lane has started.
+struct XLaneStats {
+    uint64_t tasks        = 0;
+    uint64_t totalDelayNs = 0;
+    uint64_t maxDelayNs   = 0;
+
+    double meanDelayUs() const { return tasks ? static_cast<double>(totalDelayNs) / 1e3 / tasks : 0; }
+};
+
+#if defined(AU_FLOW_DISABLE_STATS) && AU_FLOW_DISABLE_STATS
+#define AU_FLOW_STATS 0
+#else
+#define AU_FLOW_STATS 1
+#endif
+
+/// False when AU_FLOW_DISABLE_STATS compiled the worker timing counters out.
+constexpr bool kThreadpoolStats = AU_FLOW_STATS;
+
+/// Counters of one worker (or of the non-worker threads) since construction or resetStats().
+struct XWorkerStats {
+    size_t   index          = 0;
+    uint64_t tasks          = 0;
+    uint64_t busyNs         = 0;  ///< inside task functions
+    uint64_t idleNs         = 0;  ///< between tasks: searching, spinning, parked
+    uint64_t totalDelayNs   = 0;  ///< enqueue-to-start, summed over the tasks run here
+    uint64_t maxDelayNs     = 0;
+    uint64_t steals         = 0;  ///< tasks taken from another worker's deque or inbox
+    uint64_t remoteSteals   = 0;  ///< the part of steals taken from another NUMA node
+    int      node           = -1; ///< NUMA node id; -1 unless the pool groups workers by node
+    size_t   peakQueueDepth = 0;  ///< deepest this worker's deque or inbox got
+
+    double meanDelayUs() const { return tasks ? static_cast<double>(totalDelayNs) / 1e3 / tasks : 0; }
+    double utilization() const
+    {
+        return busyNs + idleNs ? static_cast<double>(busyNs) / static_cast<double>(busyNs + idleNs) : 0;
+    }
+};
+
+struct XThreadpoolStats {
+    std::vector<XWorkerStats> workers;     ///< every slot that ever ran a thread
+    XWorkerStats              external;    ///< tasks run by outside threads helping (tryRunPending)
+    size_t                    peakQueued = 0;  ///< high-water mark of tasks queued pool-wide
+};
+
+struct XThreadpoolOptions {
+    size_t threads = 0;
+
+    /// Per-worker CPU sets: worker i runs on cpuMasks[i % size()]. Takes
+    /// precedence over performanceCoresOnly / pinWorkers when non-empty.
+    std::vector<std::vector<int>> cpuMasks;
+
+    /// Keep workers on the cores with the highest max frequency (big cores).
+    bool performanceCoresOnly = false;
+
+    /// Pin each worker to one core, round-robin over the allowed cores.
+    bool pinWorkers = false;
+
+    /// Worker threads are named "<name>-<index>"; empty leaves them unnamed.
+    std::string name = "aura";
+
+    au::sys::SchedPolicy policy = au::sys::SchedPolicy::Default;
+
+    /// Nice value for Default/Batch, real-time priority for Fifo/RoundRobin.
+    int priority = 0;
+
+    /// A worker that ran this many high tasks in a row takes one normal task next.
+    uint32_t highBurst = 16;
+
+    /// A background task queued longer than this runs before high and normal work.
+    uint64_t backgroundAgingNs = 50000000;
+
+    /// Upper bound for resize(); 0 = max(threads, hardware threads).
+    size_t maxThreads = 0;
+
+    /// An idle worker polls for new work this long before parking; 0 parks at once.
+    uint64_t spinNs = 50000;
+
+    /// Group workers by NUMA node: CPUs, inboxes and stealing (see above).
+    /// Node CPUs take precedence over performanceCoresOnly; cpuMasks over both.
+    bool numaAware = false;
+
+    /// Node layout for numaAware; empty reads au::sys::getNumaTopology().
+    std::vector<au::sys::NumaNodeInfo> numaNodes;
+
+    /// A worker parked this long exits until work arrives again; 0 parks indefinitely.
+    uint64_t idleTimeoutNs = 0;
+};
+
+class XScheduleAwaitable;
+
 class XThreadpool {
 public:
     explicit XThreadpool(size_t threads);
+    explicit XThreadpool(const XThreadpoolOptions& opt);
     ~XThreadpool();
 
     XThreadpool(const XThreadpool&) = delete;
@@ -38,15 +238,306 @@ public:
      * @tparam Args Argument types.
      * @return std::future holding the return value.
      */
+    template <class F, class... Args, class = std::enable_if_t<!detail::isTaskOption<F>>>
+    auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>
+    {
+        return enqueue(kPriorityNormal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /** @brief Enqueue on the lane @p priority. */
     template <class F, class... Args>
-    auto enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
+    auto enqueue(XTaskPriority priority, F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>>;
+
+    /**
+     * @brief Enqueue a cancellable task; @p f returns void or an err:: code.
+     *
+     * The task is discarded without running if @p cancel fires before a
+     * worker starts it; the future then resolves with err::kErrorAborted.
+     * A running task may poll @p cancel itself. A void task yields err::kSuccess.
+     */
+    template <class F, class... Args>
+    std::future<int> enqueue(const XCancelToken& cancel, F&& f, Args&&... args)
+    {
+        return enqueue(kPriorityNormal, cancel, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /** @brief Enqueue a cancellable task on the lane @p priority. */
+    template <class F, class... Args>
+    std::future<int> enqueue(XTaskPriority priority, const XCancelToken& cancel, F&& f, Args&&... args);
+
+    /**
+     * @brief Fire-and-forget submission: no future, no heap allocation on the
+     *        hot path. Exceptions escaping the task are logged and swallowed.
+     */
+    template <class F, class... Args, class = std::enable_if_t<!detail::isTaskOption<F>>>
+    void submit(F&& f, Args&&... args)
+    {
+        submit(kPriorityNormal, std::forward<F>(f), std::forward<Args>(args)...);
+    }
+
+    /** @brief Fire-and-forget submission on the lane @p priority. */
+    template <class F, class... Args>
+    void submit(XTaskPriority priority, F&& f, Args&&... args);
+
+    /**
+     * @brief Fire-and-forget submission to the workers of NUMA node @p node
+     *        (an au::sys::NumaNodeInfo id). Idle workers of other nodes may
+     *        still steal the task. A plain submit() when the pool is not
+     *        NUMA-aware or does not know @p node.
+     */
+    template <class F>
+    void submitToNode(int node, F&& f);
+
+    /** @brief Number of NUMA nodes the workers are grouped into; 1 when not NUMA-aware. */
+    size_t numaNodes() const { return std::max<size_t>(mNodes.size(), 1); }
+
+    /** @brief NUMA node id of worker @p worker; -1 when not NUMA-aware. */
+    int workerNode(size_t worker) const;
+
+    /** @brief NUMA node id of the calling worker; -1 from outside the pool or when not NUMA-aware. */
+    int currentNode() const;
+
+    /**
+     * @brief `co_await pool.schedule()` moves the calling coroutine onto a
+     *        worker of this pool (C++20; see xcoro.h).
+     */
+    XScheduleAwaitable schedule(XTaskPriority priority = kPriorityNormal);
+
+    /** @brief Queueing-delay counters of one lane, summed over all threads. */
+    XLaneStats laneStats(XTaskPriority priority) const;
+
+    /** @brief Zero the queueing-delay counters, e.g. at the start of a measurement window. */
+    void resetLaneStats();
+
+    /** @brief Snapshot of the per-worker counters; safe while tasks run. */
+    XThreadpoolStats stats() const;
+
+    /** @brief Zero every counter, lane counters included. */
+    void resetStats();
+
+    /** @brief Print stats() as one line per worker, e.g. to the writer installed on an XPerfContext4. */
+    void writeStats(au::perf::IPerfWriter4& writer) const;
+
+    /** @brief Number of worker threads the pool runs when busy (see resize()). */
+    size_t size() const { return mTarget.load(std::memory_order_acquire); }
+
+    /** @brief Worker threads currently alive; below size() while idle workers are retired. */
+    size_t liveThreads() const { return mLive.load(std::memory_order_acquire); }
+
+    /** @brief The largest size resize() accepts. */
+    size_t maxThreads() const { return mSlots.size(); }
+
+    /**
+     * @brief Change the number of worker threads, e.g. shrink under thermal
+     *        throttling or grow for a batch job.
+     *
+     * Growing starts the threads at once. Shrinking does not wait: surplus
+     * workers exit after their current task. Callable from any thread,
+     * including pool tasks.
+     * @return err::kSuccess, err::kErrorInvalidParam if @p threads > maxThreads(),
+     *         or err::kErrorStateInvalid once the pool is being destroyed.
+     */
+    int resize(size_t threads);
+
+    /**
+     * @brief Run one pending task on the calling thread, if any.
+     *
+     * Workers take from their own deque first; any other thread steals. Lets
+     * a thread that waits on pool work contribute instead of sleeping.
+     * @return true if a task was run.
+     */
+    bool tryRunPending();
+
+    /**
+     * @brief Whether work spawned now would likely be picked up by an idle
+     *        thread: the calling worker's deque is empty (nobody is left to
+     *        steal from it), or, from outside the pool, nothing is queued.
+     */
+    bool hasIdleCapacity() const;
+
+private:
+    struct Task {
+        XTask         fn;
+        int64_t       enqueueNs = 0;
+        XTaskPriority lane      = kPriorityNormal;
+    };
+
+    template <class F>
+    static Task* makeTask(F&& f);
+    static void  destroyTask(Task* task);
+
+    /// Growable FIFO ring; unlike std::queue it keeps its storage when drained.
+    struct Inbox {
+        std::vector<Task*> ring = std::vector<Task*>(64);
+        size_t             head  = 0;
+        size_t             count = 0;
+
+        bool  empty() const { return count == 0; }
+        void  push(Task* t);
+        Task* pop();
+    };
+
+    struct LaneCounters {
+        std::atomic<uint64_t> tasks{0};
+        std::atomic<uint64_t> delayNs{0};
+        std::atomic<uint64_t> maxNs{0};
+
+        void record(uint64_t ns);
+    };
+
+#if AU_FLOW_STATS
+    /// Timing and scheduling counters; written by the owning thread, except peakDepth.
+    struct alignas(64) WorkerCounters {
+        std::atomic<uint64_t> busyNs{0};
+        std::atomic<uint64_t> idleNs{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> remoteSteals{0};
+        std::atomic<size_t>   peakDepth{0};
+        int64_t               lastEndNs = 0;  // end of the previous task; 0 = none yet
+    };
+#endif
+
+    /// Shared FIFO for the high and background lanes.
+    struct Lane {
+        std::mutex           mutex;
+        Inbox                queue;
+        std::atomic<size_t>  count{0};
+        std::atomic<int64_t> headNs{0};  // enqueue time of the oldest task
+
+        void  push(Task* t);
+        Task* pop();
+    };
+
+    struct Worker {
+        XWorkDeque<Task*>       deque;
+        std::mutex              inboxMutex;
+        Inbox                   inbox;
+        std::condition_variable wakeup;      // guarded by mIdleMutex
+        bool                    notified = false;
+        uint32_t                rng      = 0;
+        std::vector<int>        cpus;        // affinity applied at start; empty = unconstrained
+        uint32_t                highStreak = 0;
+        LaneCounters            lanes[kNumPriorities];
+        size_t                  index = 0;
+        int                     group = -1;    // index into mNodes; -1 = not NUMA-aware
+        std::thread             thread;        // guarded by mIdleMutex
+        bool                    live = false;  // thread running; guarded by mIdleMutex
+#if AU_FLOW_STATS
+        WorkerCounters          counters;
+#endif
+    };
+
+    /** @brief Worker slot of the calling thread if it belongs to this pool, else nullptr. */
+    Worker* currentWorker() const;
+
+    void  push(Task* task, int group = -1);
+    Worker& inboxFor(int group);
+    int   callerGroup() const;
+    void  runTask(Task* task, Worker* self);
+    Task* popLane(XTaskPriority lane);
+    bool  backgroundStarving() const;
+    Task* findTask(Worker& self);
+    Task* stealTask(const Worker* self, uint32_t& rng, bool* remote = nullptr);
+    Task* popInbox(Worker& w, bool blocking);
+    Task* spinForTask(Worker& self);
+    bool  park(Worker& self);
+    bool  retire(Worker& self, bool idle);
+    void  notifyOne();
+    void  startWorkerLocked(Worker& w);
+    void  configureWorker(size_t index);
+    void  workerLoop(size_t index);
+
+    const XThreadpoolOptions             mOptions;
+    std::vector<std::unique_ptr<Worker>> mSlots;     // maxThreads slots, fixed at construction
+
+    alignas(64) std::atomic<size_t> mQueued{0};      // tasks pushed but not yet popped
+    alignas(64) std::atomic<size_t> mNextInbox{0};   // round-robin cursor for external pushes
+    alignas(64) std::atomic<size_t> mNumSleeping{0};
+    std::atomic<size_t>             mTarget{0};      // resize() target
+    std::atomic<size_t>             mLive{0};        // running worker threads
+    std::atomic<size_t>             mScanSlots{1};   // slots ever used: inboxes to steal from
+
+    /// Workers of one NUMA node: slots g, g + n, g + 2n, ... for group g of n.
+    struct NodeGroup {
+        int                             id = 0;
+        alignas(64) std::atomic<size_t> nextInbox{0};  // round-robin cursor for pushes to this node
+    };
+    std::vector<std::unique_ptr<NodeGroup>> mNodes;     // empty unless numaAware found several nodes
+    std::vector<int>                        mCpuGroup;  // cpu id -> index into mNodes; -1 = unknown
+
+    Lane         mHighLane;
+    Lane         mBackgroundLane;
+    LaneCounters mExternalLanes[kNumPriorities];  // tasks run by non-worker threads
+#if AU_FLOW_STATS
+    WorkerCounters      mExternalCounters;
+    std::atomic<size_t> mPeakQueued{0};
+#endif
+
+    std::mutex           mIdleMutex;
+    std::vector<Worker*> mIdle;                      // parked workers, guarded by mIdleMutex
+    std::atomic<bool>    mStopped{false};
+};
+
+/**
+ * @brief Completion counter for a batch of fire-and-forget tasks.
+ *
+ * Replaces one std::future per task with a single caller-owned counter. The
+ * destructor waits, so a group never outlives its tasks.
+ *
+ * wait() runs pending pool tasks instead of sleeping (help-while-wait), so a
+ * task running on the pool may itself open and wait on a group: nested
+ * parallel regions cannot deadlock the pool.
+ */
+class XTaskGroup {
+public:
+    explicit XTaskGroup(XThreadpool& pool) : mPool(pool) {}
+    ~XTaskGroup() { wait(); }
+
+    XTaskGroup(const XTaskGroup&) = delete;
+    XTaskGroup& operator=(const XTaskGroup&) = delete;
+
+    /** @brief Submit @p f to the pool as part of this group. */
+    template <class F>
+    void run(F&& f);
+
+    /** @brief Return once every task run() so far has finished; helps the pool meanwhile. */
+    void wait();
+
+    /** @brief True when no task of this group is pending or running. */
+    bool done() const { return mPending.load(std::memory_order_acquire) == 0; }
+
+private:
+    void finishOne();
+
+    XThreadpool&            mPool;
+    std::atomic<size_t>     mPending{0};
+    std::mutex              mMutex;
+    std::condition_variable mDone;
+};
+
+/**
+ * @brief Awaitable that resumes the awaiting coroutine as a task on a pool.
+ *
+ * await_suspend() is a template over the handle type, so this header needs
+ * no <coroutine> and still compiles as C++17.
+ */
+class XScheduleAwaitable {
+public:
+    XScheduleAwaitable(XThreadpool& pool, XTaskPriority priority) : mPool(pool), mPriority(priority) {}
+
+    bool await_ready() const noexcept { return false; }
+
+    template <class Handle>
+    void await_suspend(Handle handle) const
+    {
+        mPool.submit(mPriority, [handle] { handle.resume(); });
+    }
+
+    void await_resume() const noexcept {}
 
 private:
-    std::vector<std::thread>           mWorkers;
-    std::queue<std::function<void()>>  mTasks;
-    std::mutex                         mMutex;
-    std::condition_variable            mCondition;
-    bool                               mStopped = false;
+    XThreadpool&  mPool;
+    XTaskPriority mPriority;
 };
 
 }}  // namespace au::flow
@@ -1,56 +1,892 @@
 #ifndef AURA_FLOW_XTHREADPOOL_IMPL_H_
 #define AURA_FLOW_XTHREADPOOL_IMPL_H_
 
+#include <algorithm>
+#include <cstdio>
+#include <system_error>
+#include <tuple>
+
+#include "log/xerror.h"
+#include "log/xlogger.h"
 #include "xthreadpool.h"
 
 namespace au { namespace flow {
 
-inline XThreadpool::XThreadpool(size_t threads) {
-    for (size_t i = 0; i < threads; ++i) {
-        mWorkers.emplace_back([this] {
-            for (;;) {
-                std::function<void()> task;
-                {
-                    std::unique_lock<std::mutex> lock(mMutex);
-                    mCondition.wait(lock, [this] { return mStopped || !mTasks.empty(); });
-                    if (mStopped && mTasks.empty()) return;
-                    task = std::move(mTasks.front());
-                    mTasks.pop();
-                }
-                task();
+namespace detail {
+
+/// Identifies the pool / worker slot the calling thread belongs to.
+struct XWorkerTls {
+    const void* pool   = nullptr;
+    void*       worker = nullptr;
+};
+
+inline XWorkerTls& workerTls()
+{
+    static thread_local XWorkerTls tls;
+    return tls;
+}
+
+inline uint32_t xorshift32(uint32_t& state)
+{
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return x;
+}
+
+/// Rounds of yield-and-retry before a waiter falls back to a timed sleep.
+constexpr int kStealSpinRounds = 64;
+
+inline int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+template <class T>
+inline void raiseTo(std::atomic<T>& peak, T value)
+{
+    T prev = peak.load(std::memory_order_relaxed);
+    while (value > prev && !peak.compare_exchange_weak(prev, value, std::memory_order_relaxed)) {}
+}
+
+/// Pool tasks the calling thread is inside; > 1 while a task helps a group wait.
+inline uint32_t& taskDepth()
+{
+    static thread_local uint32_t depth = 0;
+    return depth;
+}
+
+inline XThreadpoolOptions optionsWithThreads(size_t threads)
+{
+    XThreadpoolOptions opt;
+    opt.threads = threads;
+    return opt;
+}
+
+}  // namespace detail
+
+inline XThreadpool::XThreadpool(size_t threads) : XThreadpool(detail::optionsWithThreads(threads)) {}
+
+inline XThreadpool::XThreadpool(const XThreadpoolOptions& opt) : mOptions(opt)
+{
+    // Always keep at least one slot so external pushes have an inbox even for
+    // a zero-thread pool (tasks then wait, as they did with the shared queue).
+    const size_t threads = opt.threads;
+    const size_t limit   = opt.maxThreads ? opt.maxThreads : std::thread::hardware_concurrency();
+    const size_t slots   = std::max<size_t>({limit, threads, 1});
+
+    std::vector<int> allowed;
+    if (opt.cpuMasks.empty() && (opt.performanceCoresOnly || opt.pinWorkers)) {
+        const std::vector<au::sys::CpuCoreInfo> cores = au::sys::getCpuInfo().cores;
+        if (opt.performanceCoresOnly) {
+            allowed = au::sys::getPerformanceCores(cores);
+        } else {
+            for (const auto& c : cores) {
+                if (c.online) allowed.push_back(c.id);
             }
-        });
+        }
+        if (allowed.empty()) XLOG_W("no CPU topology available; workers are not pinned\n");
+    }
+
+    std::vector<au::sys::NumaNodeInfo> nodes;
+    if (opt.numaAware) {
+        nodes = opt.numaNodes.empty() ? au::sys::getNumaTopology() : opt.numaNodes;
+        if (nodes.size() < 2) nodes.clear();  // one node: nothing to group
+    }
+    for (size_t g = 0; g < nodes.size(); ++g) {
+        mNodes.emplace_back(std::make_unique<NodeGroup>());
+        mNodes.back()->id = nodes[g].id;
+        for (int cpu : nodes[g].cpus) {
+            if (cpu < 0) continue;
+            if (static_cast<size_t>(cpu) >= mCpuGroup.size()) mCpuGroup.resize(cpu + 1, -1);
+            mCpuGroup[cpu] = static_cast<int>(g);
+        }
     }
+
+    for (size_t i = 0; i < slots; ++i) {
+        mSlots.emplace_back(std::make_unique<Worker>());
+        Worker& w = *mSlots.back();
+        w.rng     = static_cast<uint32_t>(i * 2654435761u + 1u);
+        w.index   = i;
+        if (!nodes.empty()) w.group = static_cast<int>(i % nodes.size());
+        if (!opt.cpuMasks.empty()) {
+            w.cpus = opt.cpuMasks[i % opt.cpuMasks.size()];
+        } else if (w.group >= 0 && !nodes[w.group].cpus.empty()) {
+            const std::vector<int>& cpus = nodes[w.group].cpus;
+            w.cpus = opt.pinWorkers ? std::vector<int>{cpus[(i / nodes.size()) % cpus.size()]} : cpus;
+        } else if (!allowed.empty()) {
+            w.cpus = opt.pinWorkers ? std::vector<int>{allowed[i % allowed.size()]} : allowed;
+        }
+    }
+    resize(threads);
+}
+
+template <class F>
+inline XThreadpool::Task* XThreadpool::makeTask(F&& f)
+{
+    void* mem = detail::poolAllocate(sizeof(Task));
+    try {
+        return ::new (mem) Task{XTask(std::forward<F>(f))};
+    } catch (...) {
+        detail::poolDeallocate(mem, sizeof(Task));
+        throw;
+    }
+}
+
+inline void XThreadpool::destroyTask(Task* task)
+{
+    task->~Task();
+    detail::poolDeallocate(task, sizeof(Task));
+}
+
+inline void XThreadpool::runTask(Task* task, Worker* self)
+{
+    const int64_t start = detail::nowNs();
+    const int64_t delay = start - task->enqueueNs;
+    LaneCounters& lane  = self ? self->lanes[task->lane] : mExternalLanes[task->lane];
+    lane.record(static_cast<uint64_t>(delay > 0 ? delay : 0));
+
+#if AU_FLOW_STATS
+    // A task run while another task helps a group wait is already inside
+    // that task's busy time; only the outermost one is timed.
+    const bool      outer = detail::taskDepth()++ == 0;
+    WorkerCounters& c     = self ? self->counters : mExternalCounters;
+    if (outer && self && c.lastEndNs != 0) {
+        c.idleNs.fetch_add(static_cast<uint64_t>(std::max<int64_t>(start - c.lastEndNs, 0)),
+                           std::memory_order_relaxed);
+    }
+#endif
+
+    try {
+        task->fn();
+    } catch (const std::exception& e) {
+        XLOG_E("uncaught exception in submitted task: %s\n", e.what());
+    } catch (...) {
+        XLOG_E("uncaught exception in submitted task\n");
+    }
+    destroyTask(task);
+
+#if AU_FLOW_STATS
+    --detail::taskDepth();
+    if (outer) {
+        const int64_t end = detail::nowNs();
+        c.busyNs.fetch_add(static_cast<uint64_t>(end - start), std::memory_order_relaxed);
+        if (self) c.lastEndNs = end;
+    }
+#endif
 }
 
 template <class F, class... Args>
-auto XThreadpool::enqueue(F&& f, Args&&... args) -> std::future<std::invoke_result_t<F, Args...>> {
+auto XThreadpool::enqueue(XTaskPriority priority, F&& f, Args&&... args)
+    -> std::future<std::invoke_result_t<F, Args...>>
+{
     using return_type = std::invoke_result_t<F, Args...>;
 
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        std::bind(std::forward<F>(f), std::forward<Args>(args)...)
-    );
+    if (mStopped.load(std::memory_order_acquire))
+        throw std::runtime_error("enqueue on stopped threadpool");
 
-    std::future<return_type> res = task->get_future();
-    {
-        std::unique_lock<std::mutex> lock(mMutex);
-        if (mStopped)
-            throw std::runtime_error("enqueue on stopped threadpool");
-        mTasks.emplace([task]() { (*task)(); });
-    }
-    mCondition.notify_one();
+    std::promise<return_type> promise(std::allocator_arg, detail::XPoolAllocator<char>());
+    std::future<return_type>  res = promise.get_future();
+
+    Task* task = makeTask([promise = std::move(promise), fn = std::forward<F>(f),
+                           bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        try {
+            if constexpr (std::is_void_v<return_type>) {
+                std::apply(fn, bound);
+                promise.set_value();
+            } else {
+                promise.set_value(std::apply(fn, bound));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    });
+    task->lane = priority;
+    push(task);
+    return res;
+}
+
+template <class F, class... Args>
+std::future<int> XThreadpool::enqueue(XTaskPriority priority, const XCancelToken& cancel, F&& f, Args&&... args)
+{
+    using return_type = std::invoke_result_t<F, Args...>;
+    static_assert(std::is_void_v<return_type> || std::is_convertible_v<return_type, int>,
+                  "a cancellable task returns void or an err:: code");
+
+    if (mStopped.load(std::memory_order_acquire))
+        throw std::runtime_error("enqueue on stopped threadpool");
+
+    std::promise<int> promise(std::allocator_arg, detail::XPoolAllocator<char>());
+    std::future<int>  res = promise.get_future();
+
+    Task* task = makeTask([promise = std::move(promise), cancel, fn = std::forward<F>(f),
+                           bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        if (cancel.isCancelled()) {
+            promise.set_value(err::kErrorAborted);
+            return;
+        }
+        try {
+            if constexpr (std::is_void_v<return_type>) {
+                std::apply(fn, bound);
+                promise.set_value(err::kSuccess);
+            } else {
+                promise.set_value(static_cast<int>(std::apply(fn, bound)));
+            }
+        } catch (...) {
+            promise.set_exception(std::current_exception());
+        }
+    });
+    task->lane = priority;
+    push(task);
     return res;
 }
 
-inline XThreadpool::~XThreadpool() {
+template <class F, class... Args>
+void XThreadpool::submit(XTaskPriority priority, F&& f, Args&&... args)
+{
+    if (mStopped.load(std::memory_order_acquire))
+        throw std::runtime_error("submit on stopped threadpool");
+
+    Task* task = nullptr;
+    if constexpr (sizeof...(Args) == 0) {
+        task = makeTask(std::forward<F>(f));
+    } else {
+        task = makeTask([fn = std::forward<F>(f), bound = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+            std::apply(fn, bound);
+        });
+    }
+    task->lane = priority;
+    push(task);
+}
+
+inline XThreadpool::~XThreadpool()
+{
     {
-        std::unique_lock<std::mutex> lock(mMutex);
-        mStopped = true;
+        std::unique_lock<std::mutex> lock(mIdleMutex);
+        mStopped.store(true, std::memory_order_seq_cst);
+        for (Worker* w : mIdle) {
+            w->notified = true;
+            w->wakeup.notify_one();
+        }
+        mIdle.clear();
+        mNumSleeping.store(0, std::memory_order_seq_cst);
+    }
+    // No thread starts once mStopped is set (both starters check it under mIdleMutex).
+    for (auto& slot : mSlots) {
+        if (slot->thread.joinable()) slot->thread.join();
+    }
+    // Zero-thread pools never ran anything; release what is left.
+    for (Lane* lane : {&mHighLane, &mBackgroundLane}) {
+        while (!lane->queue.empty()) destroyTask(lane->queue.pop());
+    }
+    for (auto& slot : mSlots) {
+        Task* t = nullptr;
+        while (slot->deque.pop(t)) destroyTask(t);
+        while (!slot->inbox.empty()) {
+            destroyTask(slot->inbox.pop());
+        }
+    }
+}
+
+inline XThreadpool::Worker* XThreadpool::currentWorker() const
+{
+    const detail::XWorkerTls& tls = detail::workerTls();
+    return tls.pool == this ? static_cast<Worker*>(tls.worker) : nullptr;
+}
+
+inline void XThreadpool::push(Task* task, int group)
+{
+    // Count first so the pool never looks drained while a task is in flight.
+    // seq_cst pairs with the increment of mNumSleeping in park(): either we
+    // observe the sleeper, or the sleeper observes this task.
+    [[maybe_unused]] const size_t queued = mQueued.fetch_add(1, std::memory_order_seq_cst) + 1;
+    task->enqueueNs = detail::nowNs();
+#if AU_FLOW_STATS
+    detail::raiseTo(mPeakQueued, queued);
+#endif
+    if (task->lane == kPriorityHigh) {
+        mHighLane.push(task);
+    } else if (task->lane == kPriorityBackground) {
+        mBackgroundLane.push(task);
+    } else if (Worker* self = currentWorker(); self && (group < 0 || group == self->group)) {
+        self->deque.push(task);
+#if AU_FLOW_STATS
+        detail::raiseTo(self->counters.peakDepth, self->deque.sizeApprox());
+#endif
+    } else {
+        Worker& w = inboxFor(group >= 0 ? group : callerGroup());
+        std::lock_guard<std::mutex> lock(w.inboxMutex);
+        w.inbox.push(task);
+#if AU_FLOW_STATS
+        detail::raiseTo(w.counters.peakDepth, w.inbox.count);
+#endif
+    }
+    notifyOne();
+}
+
+inline XThreadpool::Worker& XThreadpool::inboxFor(int group)
+{
+    const size_t target = std::max<size_t>(mTarget.load(std::memory_order_relaxed), 1);
+    if (group >= 0) {
+        // Round-robin over the node's workers below the current size.
+        const size_t n = mNodes.size(), g = static_cast<size_t>(group);
+        if (g < target) {
+            const size_t count = (target - g + n - 1) / n;
+            const size_t k     = mNodes[g]->nextInbox.fetch_add(1, std::memory_order_relaxed) % count;
+            return *mSlots[g + k * n];
+        }
+    }
+    return *mSlots[mNextInbox.fetch_add(1, std::memory_order_relaxed) % target];
+}
+
+inline int XThreadpool::callerGroup() const
+{
+    if (mNodes.empty()) return -1;
+    const int cpu = au::sys::getCurrentCpu();
+    return cpu >= 0 && static_cast<size_t>(cpu) < mCpuGroup.size() ? mCpuGroup[cpu] : -1;
+}
+
+template <class F>
+void XThreadpool::submitToNode(int node, F&& f)
+{
+    if (mStopped.load(std::memory_order_acquire))
+        throw std::runtime_error("submit on stopped threadpool");
+
+    int group = -1;
+    for (size_t g = 0; g < mNodes.size(); ++g) {
+        if (mNodes[g]->id == node) group = static_cast<int>(g);
+    }
+    push(makeTask(std::forward<F>(f)), group);
+}
+
+inline int XThreadpool::workerNode(size_t worker) const
+{
+    if (worker >= mSlots.size() || mSlots[worker]->group < 0) return -1;
+    return mNodes[mSlots[worker]->group]->id;
+}
+
+inline int XThreadpool::currentNode() const
+{
+    const Worker* self = currentWorker();
+    return self && self->group >= 0 ? mNodes[self->group]->id : -1;
+}
+
+inline void XThreadpool::Inbox::push(Task* t)
+{
+    if (count == ring.size()) {
+        std::vector<Task*> bigger(ring.size() * 2);
+        for (size_t i = 0; i < count; ++i) {
+            bigger[i] = ring[(head + i) % ring.size()];
+        }
+        ring.swap(bigger);
+        head = 0;
+    }
+    ring[(head + count) % ring.size()] = t;
+    ++count;
+}
+
+inline XThreadpool::Task* XThreadpool::Inbox::pop()
+{
+    Task* t = ring[head];
+    head    = (head + 1) % ring.size();
+    --count;
+    return t;
+}
+
+inline void XThreadpool::Lane::push(Task* t)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) headNs.store(t->enqueueNs, std::memory_order_relaxed);
+    queue.push(t);
+    count.fetch_add(1, std::memory_order_release);
+}
+
+inline XThreadpool::Task* XThreadpool::Lane::pop()
+{
+    if (count.load(std::memory_order_acquire) == 0) return nullptr;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (queue.empty()) return nullptr;
+    Task* t = queue.pop();
+    count.fetch_sub(1, std::memory_order_relaxed);
+    if (!queue.empty()) headNs.store(queue.ring[queue.head]->enqueueNs, std::memory_order_relaxed);
+    return t;
+}
+
+inline void XThreadpool::LaneCounters::record(uint64_t ns)
+{
+    tasks.fetch_add(1, std::memory_order_relaxed);
+    delayNs.fetch_add(ns, std::memory_order_relaxed);
+    detail::raiseTo(maxNs, ns);
+}
+
+inline XThreadpool::Task* XThreadpool::popLane(XTaskPriority lane)
+{
+    Task* t = (lane == kPriorityHigh ? mHighLane : mBackgroundLane).pop();
+    if (t) mQueued.fetch_sub(1, std::memory_order_relaxed);
+    return t;
+}
+
+inline bool XThreadpool::backgroundStarving() const
+{
+    if (mBackgroundLane.count.load(std::memory_order_relaxed) == 0) return false;
+    const int64_t waited = detail::nowNs() - mBackgroundLane.headNs.load(std::memory_order_relaxed);
+    return waited > static_cast<int64_t>(mOptions.backgroundAgingNs);
+}
+
+inline XScheduleAwaitable XThreadpool::schedule(XTaskPriority priority)
+{
+    return XScheduleAwaitable(*this, priority);
+}
+
+inline XLaneStats XThreadpool::laneStats(XTaskPriority priority) const
+{
+    XLaneStats stats;
+    auto       add = [&stats](const LaneCounters& c) {
+        stats.tasks += c.tasks.load(std::memory_order_relaxed);
+        stats.totalDelayNs += c.delayNs.load(std::memory_order_relaxed);
+        stats.maxDelayNs = std::max(stats.maxDelayNs, c.maxNs.load(std::memory_order_relaxed));
+    };
+    for (const auto& slot : mSlots) add(slot->lanes[priority]);
+    add(mExternalLanes[priority]);
+    return stats;
+}
+
+inline void XThreadpool::resetLaneStats()
+{
+    auto reset = [](LaneCounters& c) {
+        c.tasks.store(0, std::memory_order_relaxed);
+        c.delayNs.store(0, std::memory_order_relaxed);
+        c.maxNs.store(0, std::memory_order_relaxed);
+    };
+    for (auto& slot : mSlots) {
+        for (auto& c : slot->lanes) reset(c);
+    }
+    for (auto& c : mExternalLanes) reset(c);
+}
+
+inline XThreadpoolStats XThreadpool::stats() const
+{
+    auto fill = [](XWorkerStats& ws, const LaneCounters* lanes) {
+        for (int k = 0; k < kNumPriorities; ++k) {
+            ws.tasks += lanes[k].tasks.load(std::memory_order_relaxed);
+            ws.totalDelayNs += lanes[k].delayNs.load(std::memory_order_relaxed);
+            ws.maxDelayNs = std::max(ws.maxDelayNs, lanes[k].maxNs.load(std::memory_order_relaxed));
+        }
+    };
+#if AU_FLOW_STATS
+    auto fillCounters = [](XWorkerStats& ws, const WorkerCounters& c) {
+        ws.busyNs         = c.busyNs.load(std::memory_order_relaxed);
+        ws.idleNs         = c.idleNs.load(std::memory_order_relaxed);
+        ws.steals         = c.steals.load(std::memory_order_relaxed);
+        ws.remoteSteals   = c.remoteSteals.load(std::memory_order_relaxed);
+        ws.peakQueueDepth = c.peakDepth.load(std::memory_order_relaxed);
+    };
+#endif
+
+    XThreadpoolStats out;
+    const size_t     n = std::min(mScanSlots.load(std::memory_order_acquire), mSlots.size());
+    out.workers.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        out.workers[i].index = i;
+        out.workers[i].node  = workerNode(i);
+        fill(out.workers[i], mSlots[i]->lanes);
+#if AU_FLOW_STATS
+        fillCounters(out.workers[i], mSlots[i]->counters);
+#endif
+    }
+    fill(out.external, mExternalLanes);
+#if AU_FLOW_STATS
+    fillCounters(out.external, mExternalCounters);
+    out.peakQueued = mPeakQueued.load(std::memory_order_relaxed);
+#endif
+    return out;
+}
+
+inline void XThreadpool::resetStats()
+{
+    resetLaneStats();
+#if AU_FLOW_STATS
+    // lastEndNs belongs to the worker: the idle gap in progress is counted in full.
+    auto reset = [](WorkerCounters& c) {
+        c.busyNs.store(0, std::memory_order_relaxed);
+        c.idleNs.store(0, std::memory_order_relaxed);
+        c.steals.store(0, std::memory_order_relaxed);
+        c.remoteSteals.store(0, std::memory_order_relaxed);
+        c.peakDepth.store(0, std::memory_order_relaxed);
+    };
+    for (auto& slot : mSlots) reset(slot->counters);
+    reset(mExternalCounters);
+    mPeakQueued.store(0, std::memory_order_relaxed);
+#endif
+}
+
+inline void XThreadpool::writeStats(au::perf::IPerfWriter4& writer) const
+{
+    const XThreadpoolStats snap = stats();
+    const char*            name  = mOptions.name.empty() ? "pool" : mOptions.name.c_str();
+
+    char line[256];
+    auto emit = [&](int n) {
+        if (n > 0) writer.write(line, std::min(static_cast<size_t>(n), sizeof(line) - 1));
+    };
+    auto emitWorker = [&](const char* who, const XWorkerStats& w) {
+        emit(std::snprintf(line, sizeof(line),
+                           "  %-9s %10llu tasks  busy %10.3f ms  idle %10.3f ms  util %5.1f%%  "
+                           "delay %8.1f / %8.1f us  steals %8llu  peak depth %zu\n",
+                           who, static_cast<unsigned long long>(w.tasks), w.busyNs / 1e6, w.idleNs / 1e6,
+                           100 * w.utilization(), w.meanDelayUs(), w.maxDelayNs / 1e3,
+                           static_cast<unsigned long long>(w.steals), w.peakQueueDepth));
+    };
+
+    emit(std::snprintf(line, sizeof(line), "[%s] %zu/%zu threads live, peak queued %zu%s\n", name, liveThreads(),
+                       size(), snap.peakQueued, kThreadpoolStats ? "" : " (timing compiled out)"));
+    for (const XWorkerStats& w : snap.workers) {
+        char who[32];
+        if (w.node >= 0) {
+            std::snprintf(who, sizeof(who), "worker %zu@%d", w.index, w.node);
+        } else {
+            std::snprintf(who, sizeof(who), "worker %zu", w.index);
+        }
+        emitWorker(who, w);
+    }
+    if (snap.external.tasks) emitWorker("external", snap.external);
+}
+
+inline XThreadpool::Task* XThreadpool::popInbox(Worker& w, bool blocking)
+{
+    std::unique_lock<std::mutex> lock(w.inboxMutex, std::defer_lock);
+    if (blocking) {
+        lock.lock();
+    } else if (!lock.try_lock()) {
+        return nullptr;
+    }
+    return w.inbox.empty() ? nullptr : w.inbox.pop();
+}
+
+inline XThreadpool::Task* XThreadpool::findTask(Worker& self)
+{
+    Task* t = nullptr;
+    if (backgroundStarving() && (t = popLane(kPriorityBackground)) != nullptr) return t;
+
+    // High first, but a long run of high tasks yields once to normal work.
+    if (self.highStreak < mOptions.highBurst) {
+        if ((t = popLane(kPriorityHigh)) != nullptr) {
+            ++self.highStreak;
+            return t;
+        }
+    }
+    self.highStreak = 0;
+
+    if (self.deque.pop(t) || (t = popInbox(self, true)) != nullptr) {
+        mQueued.fetch_sub(1, std::memory_order_relaxed);
+        return t;
+    }
+    bool remote = false;
+    if ((t = stealTask(&self, self.rng, &remote)) != nullptr) {
+#if AU_FLOW_STATS
+        self.counters.steals.fetch_add(1, std::memory_order_relaxed);
+        if (remote) self.counters.remoteSteals.fetch_add(1, std::memory_order_relaxed);
+#endif
+        return t;
+    }
+    if ((t = popLane(kPriorityHigh)) != nullptr) return t;
+    return popLane(kPriorityBackground);
+}
+
+inline XThreadpool::Task* XThreadpool::stealTask(const Worker* self, uint32_t& rng, bool* remote)
+{
+    const size_t n     = mScanSlots.load(std::memory_order_acquire);
+    const size_t start = detail::xorshift32(rng) % n;
+    Task*        t     = nullptr;
+    // A grouped worker sweeps its own node first, then the others.
+    const int passes = self && self->group >= 0 ? 2 : 1;
+    for (int pass = 0; pass < passes; ++pass) {
+        for (size_t k = 0; k < n; ++k) {
+            Worker& victim = *mSlots[(start + k) % n];
+            if (&victim == self) continue;
+            if (passes == 2 && (victim.group == self->group) != (pass == 0)) continue;
+            // Outsiders have no inbox of their own, so they wait for the lock.
+            if (victim.deque.steal(t) || (t = popInbox(victim, self == nullptr)) != nullptr) {
+                mQueued.fetch_sub(1, std::memory_order_relaxed);
+                if (remote) *remote = pass == 1;
+                return t;
+            }
+        }
+    }
+    return nullptr;
+}
+
+inline bool XThreadpool::tryRunPending()
+{
+    Task*   task = nullptr;
+    Worker* self = currentWorker();
+    if (self) {
+        task = findTask(*self);
+    } else if (mQueued.load(std::memory_order_relaxed) > 0) {
+        static thread_local uint32_t rng = 0x9e3779b9u;
+        if ((task = popLane(kPriorityHigh)) == nullptr && (task = stealTask(nullptr, rng)) == nullptr) {
+            task = popLane(kPriorityBackground);
+        }
+    }
+    if (!task) return false;
+    runTask(task, self);
+    return true;
+}
+
+inline bool XThreadpool::hasIdleCapacity() const
+{
+    if (size() == 0) return false;
+    if (const Worker* self = currentWorker()) {
+        return self->deque.emptyApprox();
+    }
+    return mQueued.load(std::memory_order_relaxed) == 0;
+}
+
+inline int XThreadpool::resize(size_t threads)
+{
+    XCHECK_WITH_RET(threads <= mSlots.size(), err::kErrorInvalidParam);
+
+    std::lock_guard<std::mutex> lock(mIdleMutex);
+    if (mStopped.load(std::memory_order_relaxed)) return err::kErrorStateInvalid;
+
+    if (threads > mScanSlots.load(std::memory_order_relaxed)) {
+        mScanSlots.store(threads, std::memory_order_release);
+    }
+    mTarget.store(threads, std::memory_order_seq_cst);
+    for (size_t i = 0; i < threads; ++i) {
+        if (!mSlots[i]->live) startWorkerLocked(*mSlots[i]);
     }
-    mCondition.notify_all();
-    for (auto& worker : mWorkers) {
-        worker.join();
+    // Parked surplus workers would never look at mTarget again; wake them to exit.
+    for (auto it = mIdle.begin(); it != mIdle.end();) {
+        if ((*it)->index < threads) {
+            ++it;
+            continue;
+        }
+        (*it)->notified = true;
+        (*it)->wakeup.notify_one();
+        it = mIdle.erase(it);
+        mNumSleeping.fetch_sub(1, std::memory_order_relaxed);
+    }
+    return err::kSuccess;
+}
+
+inline void XThreadpool::startWorkerLocked(Worker& w)
+{
+    // A retired thread clears `live` under mIdleMutex and then only returns,
+    // so this join does not wait on anything that needs the lock.
+    if (w.thread.joinable()) w.thread.join();
+    try {
+        const size_t index = w.index;
+        w.thread           = std::thread([this, index] { workerLoop(index); });
+    } catch (const std::system_error& e) {
+        XLOG_E("worker %zu: cannot start thread: %s\n", w.index, e.what());
+        return;
+    }
+    w.live = true;
+    mLive.fetch_add(1, std::memory_order_seq_cst);
+}
+
+inline void XThreadpool::notifyOne()
+{
+    // seq_cst pairs with retire(): either we see the worker gone, or it sees our task.
+    if (mNumSleeping.load(std::memory_order_seq_cst) == 0 &&
+        mLive.load(std::memory_order_seq_cst) >= mTarget.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mIdleMutex);
+    if (!mIdle.empty()) {
+        Worker* w = mIdle.back();
+        mIdle.pop_back();
+        mNumSleeping.fetch_sub(1, std::memory_order_relaxed);
+        w->notified = true;
+        w->wakeup.notify_one();
+        return;
+    }
+    if (mStopped.load(std::memory_order_relaxed)) return;
+
+    // Nobody parked and workers were retired for idleness: bring one back.
+    const size_t target = mTarget.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < target; ++i) {
+        if (!mSlots[i]->live) {
+            startWorkerLocked(*mSlots[i]);
+            return;
+        }
+    }
+}
+
+inline bool XThreadpool::park(Worker& self)
+{
+    std::unique_lock<std::mutex> lock(mIdleMutex);
+    if (mStopped.load(std::memory_order_relaxed)) return false;
+    if (self.index >= mTarget.load(std::memory_order_relaxed)) return false;  // surplus: exit instead
+
+    self.notified = false;
+    mIdle.push_back(&self);
+    mNumSleeping.fetch_add(1, std::memory_order_seq_cst);
+
+    auto leaveIdle = [this, &self] {
+        for (auto it = mIdle.begin(); it != mIdle.end(); ++it) {
+            if (*it == &self) {
+                mIdle.erase(it);
+                mNumSleeping.fetch_sub(1, std::memory_order_relaxed);
+                break;
+            }
+        }
+    };
+
+    // Re-check after announcing ourselves; see push().
+    if (mQueued.load(std::memory_order_seq_cst) > 0) {
+        leaveIdle();
+        return false;
+    }
+    auto woken = [&self] { return self.notified; };
+    if (mOptions.idleTimeoutNs == 0) {
+        self.wakeup.wait(lock, woken);
+        return false;
+    }
+    if (self.wakeup.wait_for(lock, std::chrono::nanoseconds(mOptions.idleTimeoutNs), woken)) return false;
+    leaveIdle();
+    return true;
+}
+
+inline bool XThreadpool::retire(Worker& self, bool idle)
+{
+    std::lock_guard<std::mutex> lock(mIdleMutex);
+    if (mStopped.load(std::memory_order_relaxed)) return false;  // the destructor joins everyone
+    if (!idle && self.index < mTarget.load(std::memory_order_relaxed)) return false;  // grown back
+    if (!self.deque.emptyApprox()) return false;  // nobody else may pop our bottom end
+
+    // Dekker with push()/notifyOne(): drop out of mLive before the last look
+    // at mQueued, so a concurrent push either sees us gone or we see it.
+    mLive.fetch_sub(1, std::memory_order_seq_cst);
+    if (idle && mQueued.load(std::memory_order_seq_cst) > 0) {
+        mLive.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    self.live = false;
+    return true;
+}
+
+inline XThreadpool::Task* XThreadpool::spinForTask(Worker& self)
+{
+    // Poll the shared counter only; the queues are scanned once it moves.
+    const int64_t deadline = detail::nowNs() + static_cast<int64_t>(mOptions.spinNs);
+    do {
+        std::this_thread::yield();
+        if (mQueued.load(std::memory_order_relaxed) > 0) {
+            if (Task* t = findTask(self)) return t;
+        }
+    } while (detail::nowNs() < deadline);
+    return nullptr;
+}
+
+inline void XThreadpool::configureWorker(size_t index)
+{
+    const Worker& self = *mSlots[index];
+    if (!mOptions.name.empty()) {
+        au::sys::setThreadName(mOptions.name + "-" + std::to_string(index));
+    }
+    if (!self.cpus.empty() && !au::sys::setThreadAffinity(self.cpus)) {
+        XLOG_W("worker %zu: CPU affinity (%zu cpus) rejected\n", index, self.cpus.size());
+    }
+    if (mOptions.policy != au::sys::SchedPolicy::Default || mOptions.priority != 0) {
+        if (!au::sys::setThreadScheduling(mOptions.policy, mOptions.priority)) {
+            XLOG_W("worker %zu: scheduling policy %d / priority %d rejected\n", index,
+                   static_cast<int>(mOptions.policy), mOptions.priority);
+        }
+    }
+}
+
+inline void XThreadpool::workerLoop(size_t index)
+{
+    Worker& self = *mSlots[index];
+    detail::workerTls() = {this, &self};
+    configureWorker(index);
+#if AU_FLOW_STATS
+    self.counters.lastEndNs = detail::nowNs();  // time retired is not idle time
+#endif
+
+    for (;;) {
+        if (index >= mTarget.load(std::memory_order_relaxed) && retire(self, false)) break;
+
+        Task* task = findTask(self);
+        if (task == nullptr && mOptions.spinNs > 0) task = spinForTask(self);
+        if (task) {
+            runTask(task, &self);
+            continue;
+        }
+        if (mStopped.load(std::memory_order_acquire) && mQueued.load(std::memory_order_acquire) == 0) {
+            break;
+        }
+        if (park(self) && retire(self, true)) break;
+    }
+    detail::workerTls() = {};
+}
+
+// ============================================================================
+// XTaskGroup
+// ============================================================================
+
+template <class F>
+void XTaskGroup::run(F&& f)
+{
+    mPending.fetch_add(1, std::memory_order_relaxed);
+    try {
+        mPool.submit([this, fn = std::forward<F>(f)]() mutable {
+            struct Finish {
+                XTaskGroup* group;
+                ~Finish() { group->finishOne(); }
+            } finish{this};
+            fn();
+        });
+    } catch (...) {
+        finishOne();
+        throw;
+    }
+}
+
+inline void XTaskGroup::finishOne()
+{
+    // Only the final decrement takes the lock, and it happens under the lock
+    // so wait() cannot return (and destroy the group) while we still touch it.
+    size_t pending = mPending.load(std::memory_order_relaxed);
+    while (pending > 1) {
+        if (mPending.compare_exchange_weak(pending, pending - 1, std::memory_order_acq_rel)) return;
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mPending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        mDone.notify_all();
+    }
+}
+
+inline void XTaskGroup::wait()
+{
+    // Help while waiting: a worker that blocked here would hold a pool thread
+    // hostage, and nested groups would deadlock once every worker waits.
+    // When nothing is runnable our tasks are executing elsewhere; sleep
+    // briefly, but keep re-checking in case new work (e.g. from a nested
+    // region on another thread) shows up.
+    int idle = 0;
+    while (!done()) {
+        if (mPool.tryRunPending()) {
+            idle = 0;
+            continue;
+        }
+        if (++idle < detail::kStealSpinRounds) {
+            std::this_thread::yield();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait_for(lock, std::chrono::milliseconds(1), [this] { return done(); });
+        idle = 0;
     }
+    // Synchronise with the final finishOne(), which runs under mMutex.
+    std::lock_guard<std::mutex> lock(mMutex);
 }
 
 }}  // namespace au::flow
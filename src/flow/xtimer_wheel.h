@@ -0,0 +1,184 @@
+#ifndef AURA_FLOW_XTIMER_WHEEL_H_
+#define AURA_FLOW_XTIMER_WHEEL_H_
+
+/**
+ * @file xtimer_wheel.h
+ * @brief Hierarchical timer wheel running delayed and periodic tasks on an XThreadpool.
+ *
+ * One driver thread per wheel advances a clock in ticks of resolutionNs and
+ * submits every expired callback to the pool; no thread sleeps per timer.
+ *
+ *  - levels x slotsPerLevel buckets. Level 0 holds timers due within one
+ *    revolution, one tick per slot; each higher level covers slotsPerLevel
+ *    times the span of the one below. When level 0 wraps, the next slot of
+ *    level 1 is redistributed downwards (and so on up the levels).
+ *  - schedule() and cancel() are O(1): a timer is a node in a preallocated
+ *    slab linked into one bucket. Cascading moves each timer at most once
+ *    per level.
+ *  - The driver sleeps until the next tick only while level 0 holds timers;
+ *    otherwise it sleeps until the next cascade, or indefinitely when idle.
+ *  - Periodic timers are fixed-rate: the next expiry is the previous one
+ *    plus the period, so they do not drift. A firing is skipped while the
+ *    previous run of the same timer is still executing.
+ *  - Timers fire at the first tick at or after their deadline, i.e. up to
+ *    one resolution late, plus pool queueing.
+ *
+ * Callbacks run on pool workers and must not block them for long. The
+ * destructor stops the driver and drops timers that have not fired.
+ *
+ * @example
+ *   au::flow::XTimerWheel timers(pool);              // 1 ms ticks
+ *   auto watchdog = timers.scheduleEvery(std::chrono::milliseconds(500), [&] { checkAlive(); });
+ *   auto timeout  = timers.schedule(std::chrono::milliseconds(40), [&] { dropFrame(id); });
+ *   if (frameArrived) timers.cancel(timeout);
+ */
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "xtask.h"
+#include "xthreadpool.h"
+
+namespace au { namespace flow {
+
+struct XTimerWheelOptions {
+    /// Length of one tick; timers fire at most this late.
+    uint64_t resolutionNs = 1000000;
+
+    /// Buckets per level, rounded up to a power of two.
+    size_t slotsPerLevel = 256;
+
+    /// Levels; span = slotsPerLevel^levels ticks (256^4 ms is about 50 days).
+    /// Longer delays are parked in the top level and re-cascaded.
+    size_t levels = 4;
+
+    /// Pool lane the callbacks are submitted to.
+    XTaskPriority priority = kPriorityNormal;
+
+    /// Name of the driver thread; empty leaves it unnamed.
+    std::string name = "aura-timer";
+};
+
+/// Handle of a scheduled timer; a default-constructed id refers to nothing.
+struct XTimerId {
+    uint32_t index      = 0;
+    uint32_t generation = 0;
+
+    bool valid() const { return generation != 0; }
+};
+
+struct XTimerWheelStats {
+    size_t   pending   = 0;  ///< timers scheduled and not yet fired or cancelled
+    uint64_t fired     = 0;  ///< callbacks submitted to the pool
+    uint64_t skipped   = 0;  ///< periodic firings dropped while the previous run was still going
+    uint64_t cancelled = 0;
+    uint64_t cascaded  = 0;  ///< timers moved down a level
+};
+
+class XTimerWheel {
+public:
+    explicit XTimerWheel(XThreadpool& pool, const XTimerWheelOptions& opt = {});
+    ~XTimerWheel();
+
+    XTimerWheel(const XTimerWheel&) = delete;
+    XTimerWheel& operator=(const XTimerWheel&) = delete;
+
+    /** @brief Run @p fn once on the pool after @p delay. */
+    template <class F>
+    XTimerId schedule(std::chrono::nanoseconds delay, F&& fn)
+    {
+        return add(delay, std::chrono::nanoseconds(0), XTask(std::forward<F>(fn)));
+    }
+
+    /** @brief Run @p fn every @p period, first after one period, until cancelled. */
+    template <class F>
+    XTimerId scheduleEvery(std::chrono::nanoseconds period, F&& fn)
+    {
+        return add(period, period, XTask(std::forward<F>(fn)));
+    }
+
+    /**
+     * @brief Remove a pending timer; a periodic timer fires no more.
+     * @return true if the timer was pending, false if it already fired (one-shot),
+     *         was cancelled before, or @p id is invalid. A run already submitted
+     *         to the pool is not interrupted.
+     */
+    bool cancel(XTimerId id);
+
+    /** @brief Timers scheduled and not yet fired (one-shot) or cancelled. */
+    size_t pending() const;
+
+    XTimerWheelStats stats() const;
+
+    uint64_t resolutionNs() const { return mResolutionNs; }
+
+private:
+    static constexpr uint32_t kNil = UINT32_MAX;
+
+    /// State shared between a periodic timer and its runs on the pool.
+    struct Periodic {
+        XTask             fn;
+        std::atomic<bool> running{false};
+    };
+
+    struct Node {
+        XTask                     fn;        // one-shot callback
+        std::shared_ptr<Periodic> periodic;  // periodic callback, else null
+        uint64_t                  expiry     = 0;  // absolute tick
+        uint64_t                  period     = 0;  // ticks; 0 = one-shot
+        uint32_t                  prev       = kNil;
+        uint32_t                  next       = kNil;
+        uint32_t                  bucket     = kNil;  // level * slots + slot while linked
+        uint32_t                  generation = 1;
+    };
+
+    XTimerId add(std::chrono::nanoseconds delay, std::chrono::nanoseconds period, XTask fn);
+
+    uint64_t tickNow() const;
+    uint32_t allocNode();
+    void     freeNode(uint32_t index);
+    void     link(uint32_t index);
+    void     unlink(uint32_t index);
+    uint32_t detach(uint32_t bucket);
+    void     cascade();
+    void     expire();
+    void     advance(uint64_t target);
+    uint64_t wakeTick() const;
+    void     run();
+
+    XThreadpool&             mPool;
+    const XTimerWheelOptions mOptions;
+    const uint64_t           mResolutionNs;
+    const uint32_t           mSlotBits;
+    const uint32_t           mLevels;
+    const uint64_t           mSlotMask;
+    const int64_t            mOriginNs;  // steady clock at tick 0
+
+    mutable std::mutex      mMutex;
+    std::condition_variable mWake;
+    std::vector<Node>       mNodes;
+    std::vector<uint32_t>   mFree;
+    std::vector<uint32_t>   mBuckets;      // list heads, levels * slots
+    std::vector<size_t>     mLevelCount;   // timers linked per level
+    std::vector<XTask>      mDue;          // expired this round, submitted outside the lock
+    uint64_t                mNow      = 0;            // last processed tick
+    uint64_t                mWakeTick = UINT64_MAX;   // tick the driver sleeps until
+    size_t                  mPending  = 0;
+    bool                    mStopping = false;
+    XTimerWheelStats        mStats;
+
+    std::thread mThread;
+};
+
+}}  // namespace au::flow
+
+#include "xtimer_wheel.impl.h"
+
+#endif // AURA_FLOW_XTIMER_WHEEL_H_
@@ -0,0 +1,307 @@
+#ifndef AURA_FLOW_XTIMER_WHEEL_IMPL_H_
+#define AURA_FLOW_XTIMER_WHEEL_IMPL_H_
+
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+
+#include "log/xlogger.h"
+#include "sys/xplatform.h"
+#include "xring_queue.h"
+#include "xtimer_wheel.h"
+
+namespace au { namespace flow {
+
+namespace detail {
+
+inline uint32_t log2Pow2(uint64_t v)
+{
+    uint32_t bits = 0;
+    while ((uint64_t(1) << bits) < v) ++bits;
+    return bits;
+}
+
+}  // namespace detail
+
+inline XTimerWheel::XTimerWheel(XThreadpool& pool, const XTimerWheelOptions& opt)
+    : mPool(pool),
+      mOptions(opt),
+      mResolutionNs(std::max<uint64_t>(opt.resolutionNs, 1)),
+      mSlotBits(detail::log2Pow2(detail::roundUpPow2(std::max<size_t>(opt.slotsPerLevel, 2)))),
+      // Keep levels * bits below 64 so every span fits a tick count.
+      mLevels(static_cast<uint32_t>(std::clamp<size_t>(opt.levels, 1, 63 / mSlotBits))),
+      mSlotMask((uint64_t(1) << mSlotBits) - 1),
+      mOriginNs(detail::nowNs())
+{
+    mBuckets.assign(size_t(mLevels) << mSlotBits, kNil);
+    mLevelCount.assign(mLevels, 0);
+    mThread = std::thread([this] { run(); });
+}
+
+inline XTimerWheel::~XTimerWheel()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mStopping = true;
+    }
+    mWake.notify_one();
+    mThread.join();
+}
+
+inline uint64_t XTimerWheel::tickNow() const
+{
+    return static_cast<uint64_t>(detail::nowNs() - mOriginNs) / mResolutionNs;
+}
+
+inline XTimerId XTimerWheel::add(std::chrono::nanoseconds delay, std::chrono::nanoseconds period, XTask fn)
+{
+    // Round up: a timer never fires before its deadline.
+    const int64_t  dueNs      = detail::nowNs() - mOriginNs + std::max<int64_t>(delay.count(), 0);
+    const uint64_t dueTick    = (static_cast<uint64_t>(dueNs) + mResolutionNs - 1) / mResolutionNs;
+    const uint64_t periodTick = period.count() > 0
+                                    ? std::max<uint64_t>((static_cast<uint64_t>(period.count()) + mResolutionNs - 1) /
+                                                             mResolutionNs,
+                                                         1)
+                                    : 0;
+    std::shared_ptr<Periodic> periodic;
+    if (periodTick) {
+        periodic     = std::make_shared<Periodic>();
+        periodic->fn = std::move(fn);
+    }
+
+    bool     wake = false;
+    XTimerId id;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        // An idle driver leaves the clock behind; nothing is linked, so catch up.
+        if (mPending == 0) mNow = std::max(mNow, tickNow());
+        const uint32_t              index = allocNode();
+        Node&                       node  = mNodes[index];
+        node.fn                           = std::move(fn);
+        node.periodic                     = std::move(periodic);
+        node.expiry                       = std::max(dueTick, mNow + 1);
+        node.period                       = periodTick;
+        link(index);
+        ++mPending;
+        wake = node.expiry < mWakeTick;
+        id   = {index, node.generation};
+    }
+    if (wake) mWake.notify_one();
+    return id;
+}
+
+inline bool XTimerWheel::cancel(XTimerId id)
+{
+    XTask fn;  // destroyed outside the lock
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!id.valid() || id.index >= mNodes.size()) return false;
+        Node& node = mNodes[id.index];
+        if (node.generation != id.generation || node.bucket == kNil) return false;
+        unlink(id.index);
+        fn = std::move(node.fn);
+        freeNode(id.index);
+        --mPending;
+        ++mStats.cancelled;
+    }
+    return true;
+}
+
+inline size_t XTimerWheel::pending() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mPending;
+}
+
+inline XTimerWheelStats XTimerWheel::stats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    XTimerWheelStats            stats = mStats;
+    stats.pending                     = mPending;
+    return stats;
+}
+
+inline uint32_t XTimerWheel::allocNode()
+{
+    if (!mFree.empty()) {
+        const uint32_t index = mFree.back();
+        mFree.pop_back();
+        return index;
+    }
+    mNodes.emplace_back();
+    return static_cast<uint32_t>(mNodes.size() - 1);
+}
+
+inline void XTimerWheel::freeNode(uint32_t index)
+{
+    Node& node = mNodes[index];
+    node.fn    = XTask();
+    node.periodic.reset();
+    // Skip 0 so a recycled node never matches a default XTimerId.
+    if (++node.generation == 0) node.generation = 1;
+    mFree.push_back(index);
+}
+
+inline void XTimerWheel::link(uint32_t index)
+{
+    Node&          node  = mNodes[index];
+    const uint64_t delta = node.expiry > mNow ? node.expiry - mNow : 0;
+
+    // The lowest level whose revolution covers the delay; beyond the top
+    // level's span the timer is parked in its farthest bucket and re-cascaded.
+    uint32_t level = 0;
+    while (level + 1 < mLevels && (delta >> ((level + 1) * mSlotBits)) != 0) ++level;
+    const uint32_t spanBits = mLevels * mSlotBits;
+    uint64_t       at       = std::max(node.expiry, mNow);
+    if (spanBits < 64 && (delta >> spanBits) != 0) at = mNow + (uint64_t(1) << spanBits) - 1;
+
+    const uint32_t bucket = (level << mSlotBits) | static_cast<uint32_t>((at >> (level * mSlotBits)) & mSlotMask);
+    node.bucket           = bucket;
+    node.prev             = kNil;
+    node.next             = mBuckets[bucket];
+    if (node.next != kNil) mNodes[node.next].prev = index;
+    mBuckets[bucket] = index;
+    ++mLevelCount[level];
+}
+
+inline void XTimerWheel::unlink(uint32_t index)
+{
+    Node& node = mNodes[index];
+    if (node.prev != kNil) {
+        mNodes[node.prev].next = node.next;
+    } else {
+        mBuckets[node.bucket] = node.next;
+    }
+    if (node.next != kNil) mNodes[node.next].prev = node.prev;
+    --mLevelCount[node.bucket >> mSlotBits];
+    node.bucket = kNil;
+    node.prev = node.next = kNil;
+}
+
+inline uint32_t XTimerWheel::detach(uint32_t bucket)
+{
+    const uint32_t head = mBuckets[bucket];
+    mBuckets[bucket]    = kNil;
+    for (uint32_t i = head; i != kNil; i = mNodes[i].next) {
+        mNodes[i].bucket = kNil;
+        --mLevelCount[bucket >> mSlotBits];
+    }
+    return head;
+}
+
+inline void XTimerWheel::cascade()
+{
+    // Level L turns over when the low L * bits of the clock are zero; the
+    // highest such level is redistributed first so lower ones receive its timers.
+    uint32_t top = 0;
+    while (top + 1 < mLevels && (mNow & ((uint64_t(1) << ((top + 1) * mSlotBits)) - 1)) == 0) ++top;
+    for (uint32_t level = top; level >= 1; --level) {
+        const uint32_t slot = static_cast<uint32_t>((mNow >> (level * mSlotBits)) & mSlotMask);
+        for (uint32_t i = detach((level << mSlotBits) | slot); i != kNil;) {
+            const uint32_t next = mNodes[i].next;
+            link(i);
+            ++mStats.cascaded;
+            i = next;
+        }
+    }
+}
+
+inline void XTimerWheel::expire()
+{
+    for (uint32_t i = detach(static_cast<uint32_t>(mNow & mSlotMask)); i != kNil;) {
+        Node&          node = mNodes[i];
+        const uint32_t next = node.next;
+        if (!node.periodic) {
+            mDue.push_back(std::move(node.fn));
+            freeNode(i);
+            --mPending;
+            ++mStats.fired;
+        } else {
+            if (node.periodic->running.exchange(true, std::memory_order_acq_rel)) {
+                ++mStats.skipped;
+            } else {
+                mDue.emplace_back([p = node.periodic] {
+                    struct Done {
+                        Periodic& p;
+                        ~Done() { p.running.store(false, std::memory_order_release); }
+                    } done{*p};
+                    p->fn();
+                });
+                ++mStats.fired;
+            }
+            // Fixed rate; if the driver fell behind, skip the missed periods.
+            node.expiry += node.period;
+            if (node.expiry <= mNow) node.expiry += ((mNow - node.expiry) / node.period + 1) * node.period;
+            link(i);
+        }
+        i = next;
+    }
+}
+
+inline void XTimerWheel::advance(uint64_t target)
+{
+    while (mNow < target) {
+        if (mPending == 0) {
+            mNow = target;
+            return;
+        }
+        if (mLevelCount[0] == 0) {
+            // Nothing can expire before level 1 turns over next.
+            const uint64_t boundary = ((mNow >> mSlotBits) + 1) << mSlotBits;
+            if (boundary > target) {
+                mNow = target;
+                return;
+            }
+            mNow = boundary - 1;
+        }
+        ++mNow;
+        if (mLevels > 1 && (mNow & mSlotMask) == 0) cascade();
+        expire();
+    }
+}
+
+inline uint64_t XTimerWheel::wakeTick() const
+{
+    if (mPending == 0) return UINT64_MAX;
+    if (mLevelCount[0] != 0) return mNow + 1;
+    return ((mNow >> mSlotBits) + 1) << mSlotBits;
+}
+
+inline void XTimerWheel::run()
+{
+    if (!mOptions.name.empty()) au::sys::setThreadName(mOptions.name);
+
+    std::vector<XTask>           due;
+    std::unique_lock<std::mutex> lock(mMutex);
+    while (!mStopping) {
+        advance(tickNow());
+        if (!mDue.empty()) {
+            due.swap(mDue);
+            lock.unlock();
+            for (XTask& fn : due) {
+                try {
+                    mPool.submit(mOptions.priority, std::move(fn));
+                } catch (const std::exception& e) {
+                    XLOG_W("timer callback dropped: %s\n", e.what());
+                }
+            }
+            due.clear();
+            lock.lock();
+            continue;
+        }
+
+        mWakeTick = wakeTick();
+        if (mWakeTick == UINT64_MAX) {
+            mWake.wait(lock);
+        } else {
+            const auto at = std::chrono::steady_clock::time_point(
+                std::chrono::nanoseconds(mOriginNs + static_cast<int64_t>(mWakeTick * mResolutionNs)));
+            mWake.wait_until(lock, at);
+        }
+        mWakeTick = UINT64_MAX;
+    }
+}
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XTIMER_WHEEL_IMPL_H_
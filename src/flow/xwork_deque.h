@@ -0,0 +1,148 @@
+#ifndef AURA_FLOW_XWORK_DEQUE_H_
+#define AURA_FLOW_XWORK_DEQUE_H_
+
+/**
+ * @file xwork_deque.h
+ * @brief Chase-Lev work-stealing deque (single owner, many thieves).
+ *
+ * The owning thread pushes and pops at the bottom (LIFO, cache-warm), any
+ * other thread steals from the top (FIFO, oldest first). Memory orderings
+ * follow Le et al., "Correct and Efficient Work-Stealing for Weak Memory
+ * Models" (PPoPP'13).
+ *
+ * Elements must be trivially copyable (in practice: task pointers). The ring
+ * grows on demand; retired rings are kept until destruction because a thief
+ * may still be reading from them.
+ *
+ * @example
+ *   au::flow::XWorkDeque<Task*> dq;
+ *   dq.push(t);              // owner only
+ *   Task* out = nullptr;
+ *   dq.pop(out);             // owner only
+ *   dq.steal(out);           // any thread
+ */
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace au { namespace flow {
+
+template <typename T>
+class XWorkDeque {
+    static_assert(std::is_trivially_copyable_v<T>, "XWorkDeque elements must be trivially copyable");
+
+public:
+    explicit XWorkDeque(size_t capacity = 256)
+    {
+        size_t cap = 1;
+        while (cap < capacity) cap <<= 1;
+        mRings.emplace_back(std::make_unique<Ring>(cap));
+        mRing.store(mRings.back().get(), std::memory_order_relaxed);
+    }
+
+    XWorkDeque(const XWorkDeque&) = delete;
+    XWorkDeque& operator=(const XWorkDeque&) = delete;
+
+    /** @brief Push at the bottom. Owner thread only. */
+    void push(T item)
+    {
+        int64_t b = mBottom.load(std::memory_order_relaxed);
+        int64_t t = mTop.load(std::memory_order_acquire);
+        Ring*   r = mRing.load(std::memory_order_relaxed);
+        if (b - t > r->mask) {
+            r = grow(r, t, b);
+        }
+        r->put(b, item);
+        // Release store rather than fence + relaxed store: same ordering, but
+        // visible to ThreadSanitizer, which does not model standalone fences.
+        mBottom.store(b + 1, std::memory_order_release);
+    }
+
+    /** @brief Pop from the bottom. Owner thread only. */
+    bool pop(T& out)
+    {
+        int64_t b = mBottom.load(std::memory_order_relaxed) - 1;
+        Ring*   r = mRing.load(std::memory_order_relaxed);
+        mBottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = mTop.load(std::memory_order_relaxed);
+
+        if (t > b) {
+            mBottom.store(b + 1, std::memory_order_relaxed);
+            return false;
+        }
+        out = r->get(b);
+        if (t == b) {
+            // Last element: race against thieves for it.
+            bool won = mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            mBottom.store(b + 1, std::memory_order_relaxed);
+            return won;
+        }
+        return true;
+    }
+
+    /** @brief Steal from the top. Any thread. Fails spuriously under contention. */
+    bool steal(T& out)
+    {
+        int64_t t = mTop.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = mBottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return false;
+        }
+        Ring* r    = mRing.load(std::memory_order_acquire);
+        T     item = r->get(t);
+        if (!mTop.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return false;
+        }
+        out = item;
+        return true;
+    }
+
+    /** @brief Approximate number of elements (racy snapshot). */
+    size_t sizeApprox() const
+    {
+        int64_t b = mBottom.load(std::memory_order_relaxed);
+        int64_t t = mTop.load(std::memory_order_relaxed);
+        return b > t ? static_cast<size_t>(b - t) : 0;
+    }
+
+    bool emptyApprox() const { return sizeApprox() == 0; }
+
+private:
+    struct Ring {
+        explicit Ring(size_t cap) : mask(static_cast<int64_t>(cap) - 1), slots(new std::atomic<T>[cap]) {}
+
+        T    get(int64_t i) const { return slots[i & mask].load(std::memory_order_relaxed); }
+        void put(int64_t i, T v) { slots[i & mask].store(v, std::memory_order_relaxed); }
+
+        int64_t                        mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+    };
+
+    Ring* grow(Ring* old, int64_t t, int64_t b)
+    {
+        auto bigger = std::make_unique<Ring>(static_cast<size_t>(old->mask + 1) * 2);
+        for (int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        Ring* r = bigger.get();
+        mRings.emplace_back(std::move(bigger));
+        mRing.store(r, std::memory_order_release);
+        return r;
+    }
+
+    // top and bottom live on separate cache lines: thieves hammer mTop.
+    alignas(64) std::atomic<int64_t> mTop{0};
+    alignas(64) std::atomic<int64_t> mBottom{0};
+    alignas(64) std::atomic<Ring*>   mRing{nullptr};
+    std::vector<std::unique_ptr<Ring>> mRings;  // owner-only; keeps retired rings alive
+};
+
+}}  // namespace au::flow
+
+#endif // AURA_FLOW_XWORK_DEQUE_H_
@@ -1,15 +1,67 @@
 #include "json/xjson.h"
 
+#include <cstdlib>
+#include <cstring>
 #include <fstream>
 
 #include "cJSON.h"
 #include "file/xfile.h"
 #include "log/xerror.h"
 #include "log/xlogger.h"
+#include "memory/xmemory_tracker.h"
 
 namespace au {
 namespace json {
 
+namespace {
+
+#if defined(AU_JSON_MEMORY_ACCOUNTING) && AU_JSON_MEMORY_ACCOUNTING
+/// cJSON frees without a size, so every block carries its size in a header.
+constexpr size_t kSizeHeader = alignof(std::max_align_t);
+
+au::memory::XMemoryTag& jsonTag()
+{
+    static au::memory::XMemoryTag& tag = au::memory::memoryTag("json");
+    return tag;
+}
+
+void* trackedMalloc(size_t size)
+{
+    auto* base = static_cast<unsigned char*>(malloc(size + kSizeHeader));
+    if (!base) return nullptr;
+    memcpy(base, &size, sizeof(size));
+    jsonTag().onAlloc(size);
+    return base + kSizeHeader;
+}
+
+void trackedFree(void* ptr)
+{
+    if (!ptr) return;
+    auto*  base = static_cast<unsigned char*>(ptr) - kSizeHeader;
+    size_t size = 0;
+    memcpy(&size, base, sizeof(size));
+    jsonTag().onFree(size);
+    free(base);
+}
+#endif
+
+/// With AU_JSON_MEMORY_ACCOUNTING, charge cJSON allocations to the "json"
+/// memory tag. Called before any tree is built, so no block allocated
+/// without the header is ever freed.
+void installMemoryHooks()
+{
+#if defined(AU_JSON_MEMORY_ACCOUNTING) && AU_JSON_MEMORY_ACCOUNTING
+    static const bool installed = [] {
+        cJSON_Hooks hooks{trackedMalloc, trackedFree};
+        cJSON_InitHooks(&hooks);
+        return true;
+    }();
+    (void)installed;
+#endif
+}
+
+}  // namespace
+
 // ============================================================================
 // XJsonValue
 // ============================================================================
@@ -97,9 +149,13 @@ bool XJsonValue::hasKey(const std::string& key) const
 // XJson
 // ============================================================================
 
-XJson::XJson() = default;
+XJson::XJson() { installMemoryHooks(); }
 
-XJson::XJson(const std::string& filename) { parseFile(filename); }
+XJson::XJson(const std::string& filename)
+{
+    installMemoryHooks();
+    parseFile(filename);
+}
 
 XJson::~XJson() { clear(); }
 
@@ -19,6 +19,12 @@
  *   // Parse from string
  *   auto j = au::json::XJson::parse(R"({"key": 42})");
  *   printf("%d\n", j["key"].getInt());
+ *
+ * Configure with -DENABLE_JSON_MEMORY_ACCOUNTING=ON (which defines
+ * AU_JSON_MEMORY_ACCOUNTING=1 for aura and its users) to charge every cJSON
+ * allocation to the "json" memory tag (see xmemory_tracker.h).
+ * It is off by default: the hooks replace cJSON's process-wide allocator and
+ * add a size header and shared atomic updates to every node.
  */
 
 #include <string>
@@ -29,6 +35,13 @@ struct cJSON;
 
 namespace au { namespace json {
 
+/// True when AU_JSON_MEMORY_ACCOUNTING routes cJSON through the "json" tag.
+#if defined(AU_JSON_MEMORY_ACCOUNTING) && AU_JSON_MEMORY_ACCOUNTING
+constexpr bool kJsonMemoryAccounting = true;
+#else
+constexpr bool kJsonMemoryAccounting = false;
+#endif
+
 class XJsonValue {
 public:
     explicit XJsonValue(cJSON* p);
@@ -0,0 +1,188 @@
+#ifndef AURA_MEMORY_XARENA_H_
+#define AURA_MEMORY_XARENA_H_
+
+/**
+ * @file xarena.h
+ * @brief Monotonic bump arena for per-frame scratch memory.
+ *
+ * allocate() bumps a pointer inside the current block; deallocate() does
+ * nothing. Memory comes back all at once: reset() at the end of a frame,
+ * or rewind() to a mark() taken earlier (XArenaScope does this on scope
+ * exit). Blocks are kept across resets, so once a frame's working set has
+ * been seen, scratch allocation never reaches the upstream resource.
+ *
+ * An XArena is not thread-safe. XArena::local() is the calling thread's own
+ * instance, so XFlow workers allocate without sharing a lock. Anything
+ * allocated from an arena, including XBuffer and XImage storage, must be
+ * gone before the arena is rewound past it, and must not be resized on
+ * another thread.
+ *
+ * @example
+ *   pool.submit([] {
+ *       au::memory::XArenaScope frame;                    // rewinds on exit
+ *       auto& arena = au::memory::XArena::local();
+ *       auto  tmp   = au::memory::XBuffer<float>(w * h, au::memory::XBufferOptions{64, false, &arena});
+ *       au::cv::XImage blurred(&arena, w, h, au::cv::kXFormatGrayU8);
+ *       ...
+ *   });
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "xmemory_resource.h"
+
+namespace au { namespace memory {
+
+struct XArenaOptions {
+    /// Size of each upstream block; larger requests get a block of their own.
+    size_t blockBytes = size_t(1) << 20;
+
+    /// Where blocks come from; nullptr = defaultResource().
+    XMemoryResource* upstream = nullptr;
+};
+
+class XArena : public XMemoryResource {
+public:
+    /// Position returned by mark(); rewind() frees everything allocated after it.
+    struct Marker {
+        size_t block  = 0;
+        size_t offset = 0;
+    };
+
+    explicit XArena(const XArenaOptions& options = XArenaOptions())
+        : mUpstream(options.upstream ? options.upstream : defaultResource()),
+          mBlockBytes(std::max<size_t>(options.blockBytes, 256)) {}
+
+    ~XArena() override { release(); }
+
+    XArena(const XArena&) = delete;
+    XArena& operator=(const XArena&) = delete;
+
+    /** @brief The calling thread's arena (default options), created on first use. */
+    static XArena& local()
+    {
+        thread_local XArena arena;
+        return arena;
+    }
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (bytes == 0) bytes = 1;
+        if (mCurrent < mBlocks.size()) {
+            if (void* p = bump(mBlocks[mCurrent], mOffset, bytes, alignment)) return p;
+        }
+        if (!nextBlock(bytes, alignment)) return nullptr;
+        return bump(mBlocks[mCurrent], mOffset, bytes, alignment);
+    }
+
+    /** @brief No-op: memory is reclaimed by reset() or rewind(). */
+    void deallocate(void*, size_t, size_t = alignof(std::max_align_t)) override {}
+
+    Marker mark() const { return {mCurrent, mOffset}; }
+
+    /** @brief Free everything allocated since @p marker; blocks are kept for reuse. */
+    void rewind(const Marker& marker)
+    {
+        if (marker.block > mCurrent || (marker.block == mCurrent && marker.offset > mOffset)) return;
+        mCurrent = marker.block;
+        mOffset  = marker.offset;
+    }
+
+    /** @brief Free everything, keeping the blocks: call once per frame. */
+    void reset() { rewind(Marker{}); }
+
+    /** @brief Free everything and return the blocks upstream. */
+    void release()
+    {
+        for (const Block& block : mBlocks) mUpstream->deallocate(block.base, block.size, kBlockAlignment);
+        mBlocks.clear();
+        mCurrent = 0;
+        mOffset  = 0;
+    }
+
+    /** @brief Bytes handed out since the last reset, including alignment padding. */
+    size_t used() const
+    {
+        size_t total = 0;
+        for (size_t i = 0; i < mCurrent && i < mBlocks.size(); ++i) total += mBlocks[i].size;
+        return total + mOffset;
+    }
+
+    /** @brief Bytes held from upstream. */
+    size_t capacity() const
+    {
+        size_t total = 0;
+        for (const Block& block : mBlocks) total += block.size;
+        return total;
+    }
+
+    size_t blockCount() const { return mBlocks.size(); }
+
+private:
+    static constexpr size_t kBlockAlignment = 64;
+
+    struct Block {
+        uint8_t* base;
+        size_t   size;
+    };
+
+    static void* bump(const Block& block, size_t& offset, size_t bytes, size_t alignment)
+    {
+        const uintptr_t base  = reinterpret_cast<uintptr_t>(block.base);
+        const uintptr_t start = (base + offset + alignment - 1) & ~uintptr_t(alignment - 1);
+        if (start + bytes > base + block.size) return nullptr;
+        offset = start + bytes - base;
+        return reinterpret_cast<void*>(start);
+    }
+
+    /// Move past the current block to a free one that fits, allocating one if needed.
+    bool nextBlock(size_t bytes, size_t alignment)
+    {
+        const size_t first = mBlocks.empty() ? 0 : mCurrent + 1;
+        const size_t need  = bytes + (alignment > kBlockAlignment ? alignment : 0);
+        for (size_t i = first; i < mBlocks.size(); ++i) {
+            if (mBlocks[i].size >= need) {
+                std::swap(mBlocks[i], mBlocks[first]);  // blocks past the current one are all free
+                mCurrent = first;
+                mOffset  = 0;
+                return true;
+            }
+        }
+        const size_t size = std::max(mBlockBytes, need);
+        auto*        base = static_cast<uint8_t*>(mUpstream->allocate(size, kBlockAlignment));
+        if (!base) return false;
+        mBlocks.insert(mBlocks.begin() + first, Block{base, size});
+        mCurrent = first;
+        mOffset  = 0;
+        return true;
+    }
+
+    XMemoryResource* const mUpstream;
+    const size_t           mBlockBytes;
+    std::vector<Block>     mBlocks;
+    size_t                 mCurrent = 0;  ///< block being bumped (meaningless while mBlocks is empty)
+    size_t                 mOffset  = 0;  ///< bytes used in mBlocks[mCurrent]
+};
+
+/** @brief Marks an arena on construction and rewinds it on destruction. */
+class XArenaScope {
+public:
+    explicit XArenaScope(XArena& arena = XArena::local()) : mArena(arena), mMarker(arena.mark()) {}
+    ~XArenaScope() { mArena.rewind(mMarker); }
+
+    XArenaScope(const XArenaScope&) = delete;
+    XArenaScope& operator=(const XArenaScope&) = delete;
+
+    XArena& arena() const { return mArena; }
+
+private:
+    XArena&        mArena;
+    XArena::Marker mMarker;
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XARENA_H_
@@ -5,6 +5,12 @@
  * @file xbuffer.h
  * @brief Managed buffer with shared ownership, move semantics, and iterators.
  *
+ * XBufferOptions control how storage is obtained: alignment for SIMD or
+ * page-sized DMA buffers, skipping the zero-fill for buffers that are
+ * overwritten at once, and the XMemoryResource (pool, arena, NUMA node) the
+ * elements and the shared control block come from. Copies share storage
+ * either way.
+ *
  * @example
  *   au::memory::XBuffer<float> buf(1024);
  *   buf[0] = 3.14f;
@@ -17,16 +23,155 @@
  *
  *   // Move:
  *   auto buf3 = std::move(buf);  // buf is now empty
+ *
+ *   // From a memory resource, e.g. on NUMA node 1:
+ *   au::memory::XNodeResource node1(1);
+ *   au::memory::XBuffer<float> local(1024, node1);
+ *
+ *   // 64-byte aligned and not zero-filled, for a frame decoded into at once:
+ *   auto frame = au::memory::XBuffer<uint8_t>::uninitialized(4000 * 3000 * 3 / 2, au::memory::kCacheLineAlignment);
+ *
+ *   // Owning slices: each tile keeps the frame alive, nothing is copied.
+ *   au::memory::XBufferView<uint8_t> tile = frame.subview(row0 * stride, rows * stride);
+ *   pool.submit([tile] { process(tile.span()); });
  */
 
 #include <memory>
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <algorithm>
 #include <cassert>
+#include <new>
+#include <type_traits>
+#if __cplusplus >= 202002L && __has_include(<span>)
+#include <span>
+#endif
+
+#include "xmemory_resource.h"
 
 namespace au { namespace memory {
 
+inline constexpr size_t kCacheLineAlignment = 64;
+inline constexpr size_t kPageAlignment      = 4096;
+
+/// How an XBuffer allocates; the defaults behave like new T[count]().
+struct XBufferOptions {
+    /// Alignment of data() in bytes, a power of two; 0 = alignof(T).
+    size_t alignment = 0;
+
+    /// Value-initialise new elements; false leaves trivially constructible
+    /// elements uninitialised (others are still default-constructed).
+    bool zeroFill = true;
+
+    /// Source of the elements and the control block; must outlive the
+    /// buffer and its copies. nullptr = the global heap.
+    XMemoryResource* resource = nullptr;
+};
+
+/// std allocator over an XMemoryResource, so shared_ptr control blocks come from it too.
+template <typename U>
+struct XResourceAllocator {
+    using value_type = U;
+
+    XMemoryResource* resource;
+
+    explicit XResourceAllocator(XMemoryResource* r) : resource(r) {}
+    template <typename V>
+    XResourceAllocator(const XResourceAllocator<V>& other) : resource(other.resource) {}
+
+    U* allocate(size_t n) {
+        void* p = resource->allocate(n * sizeof(U), alignof(U));
+        if (!p) throw std::bad_alloc();
+        return static_cast<U*>(p);
+    }
+    void deallocate(U* p, size_t n) { resource->deallocate(p, n * sizeof(U), alignof(U)); }
+
+    template <typename V>
+    bool operator==(const XResourceAllocator<V>& other) const { return resource == other.resource; }
+    template <typename V>
+    bool operator!=(const XResourceAllocator<V>& other) const { return resource != other.resource; }
+};
+
+/// Non-owning contiguous range, a C++17 stand-in for std::span.
+template <typename T>
+struct XSpan {
+    T*     ptr   = nullptr;
+    size_t count = 0;
+
+    T* data() const { return ptr; }
+    size_t size() const { return count; }
+    size_t sizeBytes() const { return count * sizeof(T); }
+    bool empty() const { return count == 0; }
+    T& operator[](size_t i) const { assert(i < count); return ptr[i]; }
+    T* begin() const { return ptr; }
+    T* end() const { return ptr + count; }
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<U, const T> && !std::is_const_v<T>>>
+    operator XSpan<U>() const { return {ptr, count}; }
+#ifdef __cpp_lib_span
+    operator std::span<T>() const { return {ptr, count}; }
+#endif
+};
+
+/**
+ * @brief Owning slice of an XBuffer (or of another view).
+ *
+ * Shares the parent's control block through an aliasing shared_ptr, so the
+ * storage lives as long as any view of it; nothing is copied. Use
+ * XBufferView<const T> (XConstBufferView<T>) for read-only access; a
+ * mutable view converts to it implicitly.
+ */
+template <typename T>
+class XBufferView {
+public:
+    XBufferView() = default;
+
+    /** @brief View @p count elements at @p data, owned by the control block of @p data. */
+    XBufferView(std::shared_ptr<T> data, size_t count) : mData(std::move(data)), mSize(mData ? count : 0) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    XBufferView(const XBufferView<U>& other) : mData(other.shared()), mSize(other.size()) {}
+
+    T* data() const { return mData.get(); }
+    T& operator[](size_t i) const { assert(i < mSize); return mData.get()[i]; }
+
+    size_t size() const { return mSize; }
+    size_t sizeBytes() const { return mSize * sizeof(T); }
+    bool empty() const { return mSize == 0; }
+
+    T* begin() const { return data(); }
+    T* end() const { return data() + mSize; }
+
+    /**
+     * @brief Elements [offset, offset + count) of this view, sharing ownership.
+     *        count is clamped to the end of the view.
+     */
+    XBufferView subview(size_t offset, size_t count = SIZE_MAX) const {
+        assert(offset <= mSize);
+        offset = std::min(offset, mSize);
+        return XBufferView(std::shared_ptr<T>(mData, data() + offset), std::min(count, mSize - offset));
+    }
+
+    XSpan<T> span() const { return {data(), mSize}; }
+    operator XSpan<T>() const { return span(); }
+    template <typename U, typename = std::enable_if_t<std::is_same_v<U, const T> && !std::is_const_v<T>>>
+    operator XSpan<U>() const { return {data(), mSize}; }
+#ifdef __cpp_lib_span
+    operator std::span<T>() const { return {data(), mSize}; }
+#endif
+
+    /** @brief The aliasing pointer; its control block is the parent buffer's. */
+    const std::shared_ptr<T>& shared() const { return mData; }
+
+private:
+    std::shared_ptr<T> mData;
+    size_t mSize = 0;
+};
+
+template <typename T>
+using XConstBufferView = XBufferView<const T>;
+
 template <typename T>
 class XBuffer {
 public:
@@ -44,6 +189,28 @@ public:
         std::fill(data(), data() + mSize, value);
     }
 
+    /**
+     * @brief Allocate count elements as described by @p options.
+     *        resize() keeps allocating the same way.
+     * @throws std::bad_alloc if the resource is exhausted.
+     */
+    XBuffer(size_t count, const XBufferOptions& options)
+        : mData(allocate(count, options))
+        , mSize(count)
+        , mOptions(options) {}
+
+    /**
+     * @brief Allocate count zero-initialized elements from @p resource.
+     *        The resource must outlive the buffer; resize() keeps using it.
+     */
+    XBuffer(size_t count, XMemoryResource& resource)
+        : XBuffer(count, XBufferOptions{0, true, &resource}) {}
+
+    /** @brief count elements left uninitialised, aligned to @p alignment (0 = alignof(T)). */
+    static XBuffer uninitialized(size_t count, size_t alignment = 0) {
+        return XBuffer(count, XBufferOptions{alignment, false, nullptr});
+    }
+
     ~XBuffer() = default;
 
     // Shallow copy (shared ownership)
@@ -52,7 +219,7 @@ public:
 
     // Move
     XBuffer(XBuffer&& other) noexcept
-        : mData(std::move(other.mData)), mSize(other.mSize) {
+        : mData(std::move(other.mData)), mSize(other.mSize), mOptions(other.mOptions) {
         other.mSize = 0;
     }
 
@@ -60,6 +227,7 @@ public:
         if (this != &other) {
             mData = std::move(other.mData);
             mSize = other.mSize;
+            mOptions = other.mOptions;
             other.mSize = 0;
         }
         return *this;
@@ -79,6 +247,14 @@ public:
     size_t sizeBytes() const { return mSize * sizeof(T); }
     bool empty() const { return mSize == 0; }
 
+    /** @brief Resource the buffer allocates from; nullptr for the default heap. */
+    XMemoryResource* resource() const { return mOptions.resource; }
+
+    const XBufferOptions& options() const { return mOptions; }
+
+    /** @brief Number of buffers and views sharing this storage (0 when empty). */
+    long useCount() const { return mData.use_count(); }
+
     // -- Iterators --
 
     T* begin() { return data(); }
@@ -86,17 +262,33 @@ public:
     const T* begin() const { return data(); }
     const T* end() const { return data() + mSize; }
 
+    // -- Views (share ownership, no copy) --
+
+    /** @brief Elements [offset, offset + count); count is clamped to the end. */
+    XBufferView<T> subview(size_t offset, size_t count = SIZE_MAX) {
+        return view().subview(offset, count);
+    }
+    XBufferView<const T> subview(size_t offset, size_t count = SIZE_MAX) const {
+        return view().subview(offset, count);
+    }
+
+    XBufferView<T> view() { return XBufferView<T>(mData, mSize); }
+    XBufferView<const T> view() const { return XBufferView<const T>(mData, mSize); }
+
+    XSpan<T> span() { return {data(), mSize}; }
+    XSpan<const T> span() const { return {data(), mSize}; }
+
     // -- Mutation --
 
     void fill(const T& value) { std::fill(begin(), end(), value); }
 
     /**
      * @brief Resize the buffer (allocates new memory, copies old data).
-     *        New elements are zero-initialized.
+     *        New elements are zero-initialized unless the options say otherwise.
      */
     void resize(size_t newCount) {
         if (newCount == mSize) return;
-        std::shared_ptr<T> newData(new T[newCount](), std::default_delete<T[]>());
+        std::shared_ptr<T> newData = allocate(newCount, mOptions);
         if (mData && mSize > 0) {
             std::copy(data(), data() + std::min(mSize, newCount), newData.get());
         }
@@ -109,9 +301,54 @@ public:
         mSize = 0;
     }
 
+    /** @brief Deep copy with the same options; the copy owns new storage. */
+    XBuffer clone() const {
+        XBufferOptions noFill = mOptions;
+        noFill.zeroFill       = false;  // every element is overwritten below
+
+        XBuffer out;
+        out.mData    = allocate(mSize, noFill);
+        out.mSize    = mSize;
+        out.mOptions = mOptions;
+        std::copy(begin(), end(), out.data());
+        return out;
+    }
+
 private:
+    static std::shared_ptr<T> allocate(size_t count, const XBufferOptions& options) {
+        if (!options.resource && options.alignment == 0 && options.zeroFill) {
+            return std::shared_ptr<T>(new T[count](), std::default_delete<T[]>());
+        }
+        if (count == 0) return nullptr;
+
+        XMemoryResource* resource  = options.resource ? options.resource : defaultResource();
+        const size_t     alignment = std::max(options.alignment, alignof(T));
+        const size_t     bytes     = count * sizeof(T);
+        T* p = static_cast<T*>(resource->allocate(bytes, alignment));
+        if (!p) throw std::bad_alloc();
+        try {
+            if (options.zeroFill) {
+                std::uninitialized_value_construct_n(p, count);
+            } else {
+                std::uninitialized_default_construct_n(p, count);
+            }
+        } catch (...) {
+            resource->deallocate(p, bytes, alignment);
+            throw;
+        }
+        // On failure the shared_ptr constructor calls the deleter itself.
+        return std::shared_ptr<T>(
+            p,
+            [resource, count, bytes, alignment](T* q) {
+                std::destroy_n(q, count);
+                resource->deallocate(q, bytes, alignment);
+            },
+            XResourceAllocator<T>(resource));
+    }
+
     std::shared_ptr<T> mData;
     size_t mSize = 0;
+    XBufferOptions mOptions;
 };
 
 }}  // namespace au::memory
@@ -0,0 +1,117 @@
+#ifndef AURA_MEMORY_XCOW_BUFFER_H_
+#define AURA_MEMORY_XCOW_BUFFER_H_
+
+/**
+ * @file xcow_buffer.h
+ * @brief Copy-on-write buffer: copies share storage until one of them writes.
+ *
+ * XBuffer copies are shallow, so any holder's write is seen by all of them.
+ * XCowBuffer keeps the cheap copy but gives every holder value semantics:
+ * the first mutable access (non-const data(), operator[], begin(), span(),
+ * fill()) on a shared buffer copies it first. Unshared access only checks
+ * the use count, and const access never copies, so a read-mostly fan-out
+ * to several consumers costs one refcount increment per consumer. In hot
+ * loops, take data() once rather than indexing element by element.
+ *
+ * Read-only views taken with view() count as holders: writing afterwards
+ * detaches, and the views keep the old contents.
+ *
+ * One XCowBuffer object is not thread-safe, but copies of it may be read
+ * and written from different threads.
+ *
+ * @example
+ *   au::memory::XCowBuffer<uint8_t> frame(4000 * 3000);
+ *   decode(frame.data());                        // unique: writes in place
+ *
+ *   auto forPreview = frame;                     // no copy
+ *   auto forEncoder = frame;                     // no copy
+ *   encode(forEncoder.cdata());                  // reads never copy
+ *   forPreview[0] = 255;                         // copies once, then writes
+ */
+
+#include <atomic>
+
+#include "xbuffer.h"
+
+namespace au { namespace memory {
+
+template <typename T>
+class XCowBuffer {
+public:
+    XCowBuffer() = default;
+
+    /** @brief count zero-initialized elements. */
+    explicit XCowBuffer(size_t count) : mBuffer(count) {}
+
+    XCowBuffer(size_t count, const T& value) : mBuffer(count, value) {}
+
+    XCowBuffer(size_t count, const XBufferOptions& options) : mBuffer(count, options) {}
+
+    /**
+     * @brief Adopt @p buffer. Other XBuffer copies of it are plain holders:
+     *        they count as sharers but are not protected from each other.
+     */
+    explicit XCowBuffer(XBuffer<T> buffer) : mBuffer(std::move(buffer)) {}
+
+    // -- Read access (never copies) --
+
+    const T* data() const { return mBuffer.data(); }
+    const T* cdata() const { return mBuffer.data(); }
+    const T& operator[](size_t i) const { return mBuffer[i]; }
+    const T* begin() const { return mBuffer.begin(); }
+    const T* end() const { return mBuffer.end(); }
+    XSpan<const T> span() const { return mBuffer.span(); }
+
+    /** @brief Read-only owning view; it keeps the current contents if the buffer is written later. */
+    XBufferView<const T> view() const { return mBuffer.view(); }
+
+    // -- Write access (detaches when shared) --
+
+    T* data() { return writable().data(); }
+    T& operator[](size_t i) { return writable()[i]; }
+    T* begin() { return writable().begin(); }
+    T* end() { return mBuffer.end(); }  // begin() has already detached
+    XSpan<T> span() { return writable().span(); }
+
+    void fill(const T& value) { writable().fill(value); }
+
+    /** @brief Resize into new storage; other holders keep the old contents. */
+    void resize(size_t newCount) { mBuffer.resize(newCount); }
+
+    void clear() { mBuffer.clear(); }
+
+    // -- Size --
+
+    size_t size() const { return mBuffer.size(); }
+    size_t sizeBytes() const { return mBuffer.sizeBytes(); }
+    bool empty() const { return mBuffer.empty(); }
+    const XBufferOptions& options() const { return mBuffer.options(); }
+
+    // -- Sharing --
+
+    /** @brief True if no other buffer or view shares the storage; a write will not copy. */
+    bool isUnique() const { return mBuffer.useCount() <= 1; }
+
+    /** @brief Make the storage private now (a no-op when already unique). */
+    void detach() {
+        if (!isUnique()) {
+            mBuffer = mBuffer.clone();
+        } else {
+            // Pairs with the release decrement of the holder that just let
+            // go, so its earlier reads happen before our writes.
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+    }
+
+private:
+    XBuffer<T>& writable() {
+        detach();
+        return mBuffer;
+    }
+
+    XBuffer<T> mBuffer;
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XCOW_BUFFER_H_
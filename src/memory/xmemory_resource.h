@@ -0,0 +1,102 @@
+#ifndef AURA_MEMORY_XMEMORY_RESOURCE_H_
+#define AURA_MEMORY_XMEMORY_RESOURCE_H_
+
+/**
+ * @file xmemory_resource.h
+ * @brief Pluggable allocation source for XBuffer and XImage planes.
+ *
+ * A small std::pmr::memory_resource look-alike: <memory_resource> is
+ * missing from older Android NDK toolchains. Containers keep a pointer to
+ * the resource, so it must outlive every buffer allocated from it.
+ *
+ *  - defaultResource(): aligned operator new/delete.
+ *  - XNodeResource: pages preferring one NUMA node (au::sys::allocOnNode).
+ *    Each allocation of a page or more is its own mapping: meant for large,
+ *    long-lived buffers such as image planes and tensors.
+ *
+ * @example
+ *   au::memory::XNodeResource node1(1);
+ *   au::memory::XBuffer<float> weights(1 << 20, node1);      // on node 1
+ *   au::cv::XImage frame(&node1, 3840, 2160, au::cv::kXFormatNV12);
+ */
+
+#include <cstddef>
+#include <new>
+
+#include "sys/xplatform.h"
+
+namespace au { namespace memory {
+
+class XMemoryResource {
+public:
+    virtual ~XMemoryResource() = default;
+
+    /** @brief Allocate @p bytes aligned to @p alignment (a power of two); nullptr on failure. */
+    virtual void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) = 0;
+
+    /** @brief Release @p p; @p bytes and @p alignment must match the allocate() call. */
+    virtual void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t)) = 0;
+};
+
+/** @brief Plain heap allocation. */
+class XHeapResource : public XMemoryResource {
+public:
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        return ::operator new(bytes, std::align_val_t(alignment), std::nothrow);
+    }
+
+    void deallocate(void* p, size_t, size_t alignment = alignof(std::max_align_t)) override
+    {
+        ::operator delete(p, std::align_val_t(alignment));
+    }
+};
+
+/** @brief Process-wide XHeapResource used when no resource is given. */
+inline XMemoryResource* defaultResource()
+{
+    static XHeapResource heap;
+    return &heap;
+}
+
+/**
+ * @brief Page-granular memory placed on one NUMA node; zero-filled.
+ *
+ * On a single-node machine, or where the kernel refuses the binding, it
+ * behaves like anonymous mmap memory. Requests smaller than a page (such
+ * as shared_ptr control blocks) come from the heap instead.
+ */
+class XNodeResource : public XMemoryResource {
+public:
+    /** @param node NUMA node id (as in au::sys::NumaNodeInfo::id); < 0 = no preference. */
+    explicit XNodeResource(int node) : mNode(node) {}
+
+    int node() const { return mNode; }
+
+    /** @brief Node mappings are page aligned; smaller or over-aligned requests come from the heap. */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (onHeap(bytes, alignment)) return defaultResource()->allocate(bytes, alignment);
+        return au::sys::allocOnNode(bytes, mNode);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (onHeap(bytes, alignment)) return defaultResource()->deallocate(p, bytes, alignment);
+        au::sys::freeOnNode(p, bytes);
+    }
+
+private:
+    static constexpr size_t kSmall = 4096;
+
+    static bool onHeap(size_t bytes, size_t alignment)
+    {
+        return bytes < kSmall || alignment > au::sys::getPageSize();
+    }
+
+    int mNode;
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XMEMORY_RESOURCE_H_
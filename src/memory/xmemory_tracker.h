@@ -0,0 +1,308 @@
+#ifndef AURA_MEMORY_XMEMORY_TRACKER_H_
+#define AURA_MEMORY_XMEMORY_TRACKER_H_
+
+/**
+ * @file xmemory_tracker.h
+ * @brief Per-tag memory accounting: live bytes, peak bytes and allocation counts.
+ *
+ * A tag names a module or call site. Allocations are charged to it by
+ * routing them through an XTrackingResource (XBuffer options, the XImage
+ * mempool argument) or by calling onAlloc()/onFree() directly; builds with
+ * AU_JSON_MEMORY_ACCOUNTING=1 also charge XJson trees to the "json" tag.
+ * Recording costs a few relaxed atomic operations.
+ *
+ * XMemoryProbe reports the high-water mark of a tag over a scope, e.g. one
+ * frame. writeMemoryStats() and logMemoryStats() dump every tag; a tag with
+ * allocations outstanding at shutdown is a leak.
+ *
+ * Define AU_MEMORY_DISABLE_ACCOUNTING=1 to compile the counters out: the
+ * tags and resources stay usable but record nothing and report zeros.
+ *
+ * @example
+ *   static auto& tag = au::memory::memoryTag("denoise");
+ *   au::memory::XTrackingResource tracked(tag);
+ *   {
+ *       au::memory::XMemoryProbe probe(tag);
+ *       au::cv::XImage scratch(&tracked, 4000, 3000, au::cv::kXFormatNV12);
+ *       au::memory::XBuffer<float> weights(1 << 20, tracked);
+ *       printf("frame peak %zu bytes\n", probe.peakBytes());
+ *   }
+ *   au::memory::logMemoryStats();
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "log/xlogger.h"
+#include "perf/xtimer4.h"
+#include "xmemory_resource.h"
+
+#if defined(AU_MEMORY_DISABLE_ACCOUNTING) && AU_MEMORY_DISABLE_ACCOUNTING
+#define AU_MEMORY_ACCOUNTING 0
+#else
+#define AU_MEMORY_ACCOUNTING 1
+#endif
+
+namespace au { namespace memory {
+
+/// False when AU_MEMORY_DISABLE_ACCOUNTING compiled the counters out.
+constexpr bool kMemoryAccounting = AU_MEMORY_ACCOUNTING;
+
+struct XMemoryTagStats {
+    std::string name;
+    size_t      liveBytes = 0;
+    size_t      peakBytes = 0;  ///< since start or the last resetPeak()
+    uint64_t    allocs    = 0;
+    uint64_t    frees     = 0;
+
+    /// Allocations not freed yet.
+    uint64_t outstanding() const { return allocs - frees; }
+};
+
+class XMemoryTag {
+public:
+    explicit XMemoryTag(std::string name) : mName(std::move(name)) {}
+
+    XMemoryTag(const XMemoryTag&) = delete;
+    XMemoryTag& operator=(const XMemoryTag&) = delete;
+
+    const std::string& name() const { return mName; }
+
+    void onAlloc(size_t bytes) noexcept
+    {
+#if AU_MEMORY_ACCOUNTING
+        const size_t live = mLive.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        mAllocs.fetch_add(1, std::memory_order_relaxed);
+        raise(mPeak, live);
+        raise(mWindowPeak, live);
+#else
+        (void)bytes;
+#endif
+    }
+
+    void onFree(size_t bytes) noexcept
+    {
+#if AU_MEMORY_ACCOUNTING
+        mLive.fetch_sub(bytes, std::memory_order_relaxed);
+        mFrees.fetch_add(1, std::memory_order_relaxed);
+#else
+        (void)bytes;
+#endif
+    }
+
+    size_t liveBytes() const
+    {
+#if AU_MEMORY_ACCOUNTING
+        return mLive.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    XMemoryTagStats stats() const
+    {
+        XMemoryTagStats s;
+        s.name = mName;
+#if AU_MEMORY_ACCOUNTING
+        s.liveBytes = mLive.load(std::memory_order_relaxed);
+        s.peakBytes = mPeak.load(std::memory_order_relaxed);
+        s.allocs    = mAllocs.load(std::memory_order_relaxed);
+        s.frees     = mFrees.load(std::memory_order_relaxed);
+#endif
+        return s;
+    }
+
+    /** @brief Restart the peak from the current live bytes. */
+    void resetPeak()
+    {
+#if AU_MEMORY_ACCOUNTING
+        mPeak.store(mLive.load(std::memory_order_relaxed), std::memory_order_relaxed);
+#endif
+    }
+
+private:
+    friend class XMemoryProbe;
+
+#if AU_MEMORY_ACCOUNTING
+    static void raise(std::atomic<size_t>& peak, size_t value)
+    {
+        size_t seen = peak.load(std::memory_order_relaxed);
+        while (value > seen && !peak.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    }
+
+    std::atomic<size_t>   mLive{0};
+    std::atomic<size_t>   mPeak{0};
+    std::atomic<size_t>   mWindowPeak{0};  ///< peak since the innermost XMemoryProbe started
+    std::atomic<uint64_t> mAllocs{0};
+    std::atomic<uint64_t> mFrees{0};
+#endif
+    std::string mName;
+};
+
+namespace detail {
+
+struct XMemoryTagRegistry {
+    std::mutex                               mutex;
+    std::deque<std::unique_ptr<XMemoryTag>> tags;  ///< never shrinks: references stay valid
+};
+
+inline XMemoryTagRegistry& memoryTagRegistry()
+{
+    static XMemoryTagRegistry* registry = new XMemoryTagRegistry;  // outlives static destructors
+    return *registry;
+}
+
+}  // namespace detail
+
+/**
+ * @brief The process-wide tag called @p name, created on first use.
+ *        The reference stays valid for the life of the process: look it up
+ *        once (e.g. into a function-local static), not per allocation.
+ */
+inline XMemoryTag& memoryTag(const std::string& name)
+{
+    auto&                       registry = detail::memoryTagRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& tag : registry.tags) {
+        if (tag->name() == name) return *tag;
+    }
+    registry.tags.push_back(std::make_unique<XMemoryTag>(name));
+    return *registry.tags.back();
+}
+
+/** @brief Snapshot of every tag, in creation order. */
+inline std::vector<XMemoryTagStats> memoryStats()
+{
+    auto&                        registry = detail::memoryTagRegistry();
+    std::lock_guard<std::mutex>  lock(registry.mutex);
+    std::vector<XMemoryTagStats> out;
+    out.reserve(registry.tags.size());
+    for (auto& tag : registry.tags) out.push_back(tag->stats());
+    return out;
+}
+
+/**
+ * @brief High-water mark of one tag over a scope.
+ *
+ * Probes on the same tag nest; the enclosing probe still sees the peak
+ * reached inside the inner one. Overlapping probes on the same tag from
+ * different threads share one window, so each reports the combined peak.
+ */
+class XMemoryProbe {
+public:
+    explicit XMemoryProbe(XMemoryTag& tag) : mTag(tag), mBaseline(tag.liveBytes())
+    {
+#if AU_MEMORY_ACCOUNTING
+        mSaved = tag.mWindowPeak.exchange(mBaseline, std::memory_order_relaxed);
+#endif
+    }
+
+    ~XMemoryProbe()
+    {
+#if AU_MEMORY_ACCOUNTING
+        XMemoryTag::raise(mTag.mWindowPeak, mSaved);
+#endif
+    }
+
+    XMemoryProbe(const XMemoryProbe&) = delete;
+    XMemoryProbe& operator=(const XMemoryProbe&) = delete;
+
+    /** @brief Highest live bytes of the tag since construction. */
+    size_t peakBytes() const
+    {
+#if AU_MEMORY_ACCOUNTING
+        return mTag.mWindowPeak.load(std::memory_order_relaxed);
+#else
+        return 0;
+#endif
+    }
+
+    /** @brief Live bytes when the probe started. */
+    size_t baselineBytes() const { return mBaseline; }
+
+    /** @brief Peak growth over the baseline: the scope's extra footprint. */
+    size_t peakGrowthBytes() const
+    {
+        const size_t peak = peakBytes();
+        return peak > mBaseline ? peak - mBaseline : 0;
+    }
+
+private:
+    XMemoryTag&  mTag;
+    const size_t mBaseline;
+    size_t       mSaved = 0;
+};
+
+/** @brief Forwards to another resource and charges every allocation to a tag. */
+class XTrackingResource : public XMemoryResource {
+public:
+    /** @param upstream nullptr = defaultResource(). */
+    explicit XTrackingResource(XMemoryTag& tag, XMemoryResource* upstream = nullptr)
+        : mTag(tag), mUpstream(upstream ? upstream : defaultResource()) {}
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        void* p = mUpstream->allocate(bytes, alignment);
+        if (p) mTag.onAlloc(bytes);
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (!p) return;
+        mTag.onFree(bytes);
+        mUpstream->deallocate(p, bytes, alignment);
+    }
+
+    XMemoryTag& tag() const { return mTag; }
+    XMemoryResource* upstream() const { return mUpstream; }
+
+private:
+    XMemoryTag&            mTag;
+    XMemoryResource* const mUpstream;
+};
+
+/** @brief One line per tag through @p writer; outstanding allocations are flagged. */
+inline void writeMemoryStats(au::perf::IPerfWriter4& writer)
+{
+    char line[256];
+    auto emit = [&](int n) {
+        if (n > 0) writer.write(line, std::min(static_cast<size_t>(n), sizeof(line) - 1));
+    };
+
+    if (!kMemoryAccounting) {
+        emit(std::snprintf(line, sizeof(line), "[memory] accounting compiled out\n"));
+        return;
+    }
+    for (const XMemoryTagStats& s : memoryStats()) {
+        emit(std::snprintf(line, sizeof(line),
+                           "[memory] %-16s live %12.1f KB  peak %12.1f KB  allocs %10llu  frees %10llu%s\n",
+                           s.name.c_str(), s.liveBytes / 1024.0, s.peakBytes / 1024.0,
+                           static_cast<unsigned long long>(s.allocs), static_cast<unsigned long long>(s.frees),
+                           s.outstanding() ? "  (outstanding)" : ""));
+    }
+}
+
+/** @brief writeMemoryStats() through the logger at info level. */
+inline void logMemoryStats()
+{
+    struct LogWriter : au::perf::IPerfWriter4 {
+        void write(const char* data, std::size_t size) noexcept override
+        {
+            XLOG_I("%.*s", static_cast<int>(size), data);
+        }
+    } writer;
+    writeMemoryStats(writer);
+}
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XMEMORY_TRACKER_H_
@@ -0,0 +1,371 @@
+#ifndef AURA_MEMORY_XOBJECT_POOL_H_
+#define AURA_MEMORY_XOBJECT_POOL_H_
+
+/**
+ * @file xobject_pool.h
+ * @brief Bounded object pool with per-thread caches over a lock-free free list.
+ *
+ * acquire() constructs a T in a recycled slot and returns an RAII Handle;
+ * destroying the handle destroys the T and recycles the slot. Slots are
+ * allocated in chunks up to a fixed capacity, so once the pipeline has seen
+ * its peak object count, construct/destroy pairs stop reaching the heap:
+ * suited to per-frame XImage headers, task state and result objects.
+ *
+ *  - Each thread keeps a small cache of free slots: the common
+ *    acquire/release pair touches no shared cache line.
+ *  - Overflowing caches spill half their slots to a global Treiber stack
+ *    (tagged head, no ABA); empty caches pop from it.
+ *  - At capacity acquire() returns an empty handle. Slots parked in other
+ *    threads' caches count against the capacity until those threads reuse
+ *    them or exit.
+ *
+ * The pool must outlive its handles. Handles may be released on any thread.
+ *
+ * @example
+ *   au::memory::XObjectPool<Result> results({1024});
+ *   pool.submit([&] {
+ *       auto r = results.acquire(frameId);       // no heap after warm-up
+ *       if (!r) return;                           // capacity reached
+ *       r->score = run(*r);
+ *       publish(std::move(r));                    // returns to the pool when dropped
+ *   });
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "log/xlogger.h"
+
+namespace au { namespace memory {
+
+struct XObjectPoolOptions {
+    /// Most objects that can exist at once (at most 2^32 - 2).
+    size_t capacity = size_t(1) << 16;
+
+    /// Free slots a thread keeps before spilling half to the global list.
+    size_t cacheSize = 32;
+};
+
+struct XObjectPoolStats {
+    uint64_t acquires   = 0;
+    uint64_t releases   = 0;
+    uint64_t cacheHits  = 0;  ///< acquires served by the calling thread's cache
+    uint64_t globalHits = 0;  ///< acquires served by the global free list
+    uint64_t created    = 0;  ///< slots ever handed out fresh (<= capacity)
+    uint64_t exhausted  = 0;  ///< acquires refused at capacity
+    size_t   capacity   = 0;
+
+    uint64_t inUse() const { return acquires - releases; }
+};
+
+template <typename T>
+class XObjectPool {
+    struct State;
+
+public:
+    /// Owns one pooled object; move-only.
+    class Handle {
+    public:
+        Handle() = default;
+        ~Handle() { reset(); }
+
+        Handle(Handle&& other) noexcept
+            : mState(std::exchange(other.mState, nullptr)), mObject(std::exchange(other.mObject, nullptr)),
+              mIndex(other.mIndex) {}
+
+        Handle& operator=(Handle&& other) noexcept {
+            if (this != &other) {
+                reset();
+                mState  = std::exchange(other.mState, nullptr);
+                mObject = std::exchange(other.mObject, nullptr);
+                mIndex  = other.mIndex;
+            }
+            return *this;
+        }
+
+        Handle(const Handle&) = delete;
+        Handle& operator=(const Handle&) = delete;
+
+        T* get() const { return mObject; }
+        T* operator->() const { return mObject; }
+        T& operator*() const { return *mObject; }
+        explicit operator bool() const { return mObject != nullptr; }
+
+        /** @brief Destroy the object now and return its slot to the pool. */
+        void reset() {
+            if (!mObject) return;
+            mObject->~T();
+            mObject = nullptr;
+            std::exchange(mState, nullptr)->release(mIndex);
+        }
+
+    private:
+        friend class XObjectPool;
+        Handle(State* state, T* object, uint32_t index) : mState(state), mObject(object), mIndex(index) {}
+
+        State*   mState  = nullptr;
+        T*       mObject = nullptr;
+        uint32_t mIndex  = 0;
+    };
+
+    explicit XObjectPool(const XObjectPoolOptions& options = XObjectPoolOptions())
+        : mState(std::make_shared<State>(options)) {}
+
+    /** @brief Objects must all be released by now; free slots are returned to the heap. */
+    ~XObjectPool() {
+        const uint64_t live = stats().inUse();
+        if (live) XLOG_W("XObjectPool destroyed with %llu objects in use\n", static_cast<unsigned long long>(live));
+        mState->shutdown();
+    }
+
+    XObjectPool(const XObjectPool&) = delete;
+    XObjectPool& operator=(const XObjectPool&) = delete;
+
+    /**
+     * @brief Construct a T from @p args in a free slot.
+     * @return Empty handle if the pool is at capacity.
+     * @throws Whatever T's constructor throws (the slot is recycled).
+     */
+    template <typename... Args>
+    Handle acquire(Args&&... args) {
+        State&         state = *mState;
+        const uint32_t index = state.take();
+        if (index == kNil) return Handle();
+        void* storage = state.slot(index).storage;
+        try {
+            T* object = new (storage) T(std::forward<Args>(args)...);
+            return Handle(&state, object, index);
+        } catch (...) {
+            state.release(index);
+            throw;
+        }
+    }
+
+    XObjectPoolStats stats() const { return mState->stats(); }
+
+    size_t capacity() const { return mState->capacity; }
+
+private:
+    static constexpr uint32_t kNil        = UINT32_MAX;
+    static constexpr uint32_t kChunkSlots = 64;
+
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+        std::atomic<uint32_t> next{kNil};  ///< global free-list link
+    };
+
+    struct LocalCache;
+
+    /// Everything the handles and thread caches point at. Thread caches keep
+    /// it alive (not its slots) until they exit, so a dead pool is never
+    /// touched through a stale cache.
+    struct State : std::enable_shared_from_this<State> {
+        explicit State(const XObjectPoolOptions& options)
+            : capacity(std::min<size_t>(options.capacity, kNil - 1)),
+              cacheSize(std::max<size_t>(options.cacheSize, 2)),
+              chunks((capacity + kChunkSlots - 1) / kChunkSlots) {
+            for (auto& chunk : chunks) chunk.store(nullptr, std::memory_order_relaxed);
+        }
+
+        ~State() { freeChunks(); }
+
+        Slot& slot(uint32_t index) {
+            return chunks[index / kChunkSlots].load(std::memory_order_acquire)[index % kChunkSlots];
+        }
+
+        /// A free slot index, or kNil at capacity.
+        uint32_t take() {
+            LocalCache& cache = LocalCache::of(this);
+            uint32_t    index = kNil;
+            if (!cache.slots.empty()) {
+                index = cache.slots.back();
+                cache.slots.pop_back();
+                cache.bump(cache.cacheHits);
+            } else if ((index = pop()) != kNil) {
+                cache.bump(cache.globalHits);
+            } else if ((index = fresh()) == kNil) {
+                exhausted.fetch_add(1, std::memory_order_relaxed);
+                return kNil;
+            }
+            cache.bump(cache.acquires);
+            return index;
+        }
+
+        void release(uint32_t index) {
+            LocalCache& cache = LocalCache::of(this);
+            cache.bump(cache.releases);
+            cache.slots.push_back(index);
+            if (cache.slots.size() > cacheSize) {
+                // Spill the older half as one chain.
+                const size_t spill = cache.slots.size() / 2;
+                for (size_t i = 0; i + 1 < spill; ++i) {
+                    slot(cache.slots[i]).next.store(cache.slots[i + 1], std::memory_order_relaxed);
+                }
+                push(cache.slots[0], cache.slots[spill - 1]);
+                cache.slots.erase(cache.slots.begin(), cache.slots.begin() + spill);
+            }
+        }
+
+        /// Push the chain first..last (already linked) onto the global list.
+        void push(uint32_t first, uint32_t last) {
+            uint64_t head = top.load(std::memory_order_relaxed);
+            uint64_t next;
+            do {
+                slot(last).next.store(indexOf(head), std::memory_order_relaxed);
+                next = pack(first, tagOf(head) + 1);
+            } while (!top.compare_exchange_weak(head, next, std::memory_order_release, std::memory_order_relaxed));
+        }
+
+        uint32_t pop() {
+            uint64_t head = top.load(std::memory_order_acquire);
+            uint64_t next;
+            do {
+                const uint32_t index = indexOf(head);
+                if (index == kNil) return kNil;
+                // A stale read is harmless: the tag makes the CAS fail.
+                next = pack(slot(index).next.load(std::memory_order_relaxed), tagOf(head) + 1);
+            } while (!top.compare_exchange_weak(head, next, std::memory_order_acquire, std::memory_order_acquire));
+            return indexOf(head);
+        }
+
+        uint32_t fresh() {
+            uint32_t index = nextFresh.load(std::memory_order_relaxed);
+            do {
+                if (index >= capacity) return kNil;
+            } while (!nextFresh.compare_exchange_weak(index, index + 1, std::memory_order_relaxed));
+
+            auto& chunk = chunks[index / kChunkSlots];
+            if (!chunk.load(std::memory_order_acquire)) {
+                Slot* mine     = new Slot[kChunkSlots];
+                Slot* expected = nullptr;
+                if (!chunk.compare_exchange_strong(expected, mine, std::memory_order_acq_rel)) delete[] mine;
+            }
+            return index;
+        }
+
+        XObjectPoolStats stats() {
+            XObjectPoolStats s;
+            std::lock_guard<std::mutex> lock(registryMutex);
+            s           = retired;
+            s.created   = nextFresh.load(std::memory_order_relaxed);
+            s.exhausted = exhausted.load(std::memory_order_relaxed);
+            s.capacity  = capacity;
+            for (const LocalCache* cache : caches) cache->addTo(s);
+            return s;
+        }
+
+        void shutdown() {
+            std::lock_guard<std::mutex> lock(registryMutex);
+            alive = false;
+            freeChunks();
+        }
+
+        void freeChunks() {
+            for (auto& chunk : chunks) delete[] chunk.exchange(nullptr, std::memory_order_relaxed);
+        }
+
+        static uint64_t pack(uint32_t index, uint32_t tag) { return (uint64_t(tag) << 32) | index; }
+        static uint32_t indexOf(uint64_t head) { return static_cast<uint32_t>(head); }
+        static uint32_t tagOf(uint64_t head) { return static_cast<uint32_t>(head >> 32); }
+
+        const size_t                     capacity;
+        const size_t                     cacheSize;
+        std::vector<std::atomic<Slot*>>  chunks;
+        std::atomic<uint64_t>            top{pack(kNil, 0)};  ///< global free list: tag << 32 | index
+        std::atomic<uint32_t>            nextFresh{0};
+        std::atomic<uint64_t>            exhausted{0};
+
+        std::mutex               registryMutex;  ///< guards caches, retired, alive and shutdown
+        std::vector<LocalCache*> caches;
+        XObjectPoolStats         retired;        ///< counters of caches whose threads exited
+        bool                     alive = true;
+    };
+
+    /// One thread's free slots and counters for one pool.
+    struct LocalCache {
+        explicit LocalCache(std::shared_ptr<State> s) : state(std::move(s)) {
+            slots.reserve(state->cacheSize + 1);
+            std::lock_guard<std::mutex> lock(state->registryMutex);
+            state->caches.push_back(this);
+        }
+
+        /// Thread exit: give the slots back and fold the counters in.
+        ~LocalCache() {
+            std::lock_guard<std::mutex> lock(state->registryMutex);
+            auto& caches = state->caches;
+            caches.erase(std::find(caches.begin(), caches.end(), this));
+            addTo(state->retired);
+            if (state->alive && !slots.empty()) {
+                for (size_t i = 0; i + 1 < slots.size(); ++i) {
+                    state->slot(slots[i]).next.store(slots[i + 1], std::memory_order_relaxed);
+                }
+                state->push(slots.front(), slots.back());
+            }
+        }
+
+        /// Single-writer counter: a plain load and store, no read-modify-write.
+        static void bump(std::atomic<uint64_t>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        void addTo(XObjectPoolStats& s) const {
+            s.acquires += acquires.load(std::memory_order_relaxed);
+            s.releases += releases.load(std::memory_order_relaxed);
+            s.cacheHits += cacheHits.load(std::memory_order_relaxed);
+            s.globalHits += globalHits.load(std::memory_order_relaxed);
+        }
+
+        /// The calling thread's cache for @p state, created on first use.
+        static LocalCache& of(State* state) {
+            LocalCache*& last = tLast;
+            if (last && last->owner == state) return *last;
+
+            thread_local Caches local;
+            for (auto& cache : local.all) {
+                if (cache->owner == state) return *(last = cache.get());
+            }
+            // Drop caches of pools that are gone before adding one.
+            last = nullptr;
+            local.all.erase(std::remove_if(local.all.begin(), local.all.end(),
+                                           [](const std::unique_ptr<LocalCache>& c) { return !c->isAlive(); }),
+                            local.all.end());
+            local.all.push_back(std::make_unique<LocalCache>(state->shared_from_this()));
+            return *(last = local.all.back().get());
+        }
+
+        bool isAlive() const {
+            std::lock_guard<std::mutex> lock(state->registryMutex);
+            return state->alive;
+        }
+
+        std::shared_ptr<State> state;
+        State* const           owner = state.get();
+        std::vector<uint32_t>  slots;
+        std::atomic<uint64_t>  acquires{0};
+        std::atomic<uint64_t>  releases{0};
+        std::atomic<uint64_t>  cacheHits{0};
+        std::atomic<uint64_t>  globalHits{0};
+    };
+
+    struct Caches {
+        ~Caches() { tLast = nullptr; }
+        std::vector<std::unique_ptr<LocalCache>> all;
+    };
+
+    /// Last cache used on this thread; trivially destructible, so the hot
+    /// path skips the TLS init guard that Caches needs.
+    static inline thread_local LocalCache* tLast = nullptr;
+
+    std::shared_ptr<State> mState;
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XOBJECT_POOL_H_
@@ -0,0 +1,64 @@
+#ifndef AURA_MEMORY_XPAGE_RESOURCE_H_
+#define AURA_MEMORY_XPAGE_RESOURCE_H_
+
+/**
+ * @file xpage_resource.h
+ * @brief mmap-backed resource for large frames, optionally on huge pages.
+ *
+ * Every allocation of a page or more is its own anonymous mapping
+ * (au::sys::allocPages), so full-resolution RAW/RGB planes can use huge
+ * pages (fewer TLB misses on streaming passes) and be pre-faulted at
+ * allocation instead of stalling the first pass over the frame. Mapping is
+ * a syscall per buffer: put an XPoolResource in front of it for frames
+ * that are allocated repeatedly, with XPoolOptions::discardBytes to hand
+ * idle pages back to the OS.
+ *
+ * @example
+ *   au::memory::XPageResource huge({au::sys::HugePages::Transparent, true});
+ *   au::cv::XImage raw(&huge, 8192, 6144, au::cv::kXFormatRawU16);   // 100 MB, already faulted in
+ *
+ *   au::memory::XPoolOptions opt;
+ *   opt.upstream     = &huge;
+ *   opt.discardBytes = 1 << 20;                                      // idle frames release their pages
+ *   au::memory::XPoolResource frames(opt);
+ */
+
+#include <cstddef>
+
+#include "sys/xplatform.h"
+#include "xmemory_resource.h"
+
+namespace au { namespace memory {
+
+class XPageResource : public XMemoryResource {
+public:
+    explicit XPageResource(const au::sys::PageAllocOptions& options = au::sys::PageAllocOptions())
+        : mOptions(options) {}
+
+    const au::sys::PageAllocOptions& options() const { return mOptions; }
+
+    /** @brief Mappings are page aligned; smaller or over-aligned requests come from the heap. */
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (onHeap(bytes, alignment)) return defaultResource()->allocate(bytes, alignment);
+        return au::sys::allocPages(bytes, mOptions);
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (onHeap(bytes, alignment)) return defaultResource()->deallocate(p, bytes, alignment);
+        au::sys::freePages(p, bytes, mOptions);
+    }
+
+private:
+    static bool onHeap(size_t bytes, size_t alignment)
+    {
+        return bytes < au::sys::getPageSize() || alignment > au::sys::getPageSize();
+    }
+
+    au::sys::PageAllocOptions mOptions;
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XPAGE_RESOURCE_H_
@@ -0,0 +1,269 @@
+#ifndef AURA_MEMORY_XPOOL_RESOURCE_H_
+#define AURA_MEMORY_XPOOL_RESOURCE_H_
+
+/**
+ * @file xpool_resource.h
+ * @brief Size-class pool resource: recycles freed blocks instead of returning them.
+ *
+ * Requests are rounded up to one of four size classes per power of two (at
+ * most 25% slack) and freed blocks go onto that class's free list, so a
+ * pipeline that keeps allocating the same frame shapes stops hitting the heap
+ * (and the page-fault cost of fresh mappings) after the first few frames.
+ * The free lists are intrusive: the hit path takes one mutex and allocates
+ * nothing.
+ *
+ * Cached bytes are capped; blocks freed beyond the cap go back upstream.
+ * With discardBytes set, large cached blocks keep their address range but
+ * return their pages to the OS until reused.
+ * trim() releases cached blocks on demand, trimIfLowMemory() when the system
+ * runs short, and a failed upstream allocation trims everything and retries.
+ *
+ * @example
+ *   au::memory::XPoolResource pool;                       // 256 MB cap
+ *   for (;;) {
+ *       au::cv::XImage frame(&pool, 4000, 3000, au::cv::kXFormatNV12);
+ *       decode(frame);                                     // no malloc after warm-up
+ *   }
+ *   auto stats = pool.stats();
+ *   printf("hits %llu misses %llu\n", (unsigned long long)stats.hits, (unsigned long long)stats.misses);
+ */
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "sys/xplatform.h"
+#include "xmemory_resource.h"
+
+namespace au { namespace memory {
+
+struct XPoolOptions {
+    /// Most bytes kept on the free lists; frees beyond it go upstream.
+    size_t maxCachedBytes = size_t(256) << 20;
+
+    /// Where pooled blocks come from; nullptr = defaultResource().
+    XMemoryResource* upstream = nullptr;
+
+    /// Cached blocks of at least this many bytes give their pages back to
+    /// the OS (au::sys::discardPages) while on the free list; reuse then
+    /// faults in zero pages. 0 = keep cached blocks resident.
+    size_t discardBytes = 0;
+};
+
+struct XPoolStats {
+    uint64_t hits         = 0;  ///< allocations served from a free list
+    uint64_t misses       = 0;  ///< allocations that went upstream
+    uint64_t overflows    = 0;  ///< frees returned upstream because of the cap
+    uint64_t trimmedBytes = 0;  ///< bytes released by trim()
+    uint64_t discards     = 0;  ///< cached blocks whose pages were discarded
+    size_t   cachedBytes  = 0;  ///< bytes on the free lists now
+    size_t   cachedBlocks = 0;
+};
+
+class XPoolResource : public XMemoryResource {
+public:
+    /// Alignment of every pooled block; larger alignments bypass the pool.
+    static constexpr size_t kPoolAlignment = 64;
+
+    /// Largest request that is pooled (1 TiB); larger ones bypass the pool.
+    static constexpr size_t kMaxPooledBytes = size_t(1) << 40;
+
+    explicit XPoolResource(const XPoolOptions& options = XPoolOptions())
+        : mUpstream(options.upstream ? options.upstream : defaultResource()),
+          mMaxCachedBytes(options.maxCachedBytes),
+          mDiscardBytes(options.discardBytes) {}
+
+    /** @brief Releases the cached blocks; blocks still in use must not be freed afterwards. */
+    ~XPoolResource() override { trim(0); }
+
+    XPoolResource(const XPoolResource&) = delete;
+    XPoolResource& operator=(const XPoolResource&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (!pooled(bytes, alignment)) return mUpstream->allocate(bytes, alignment);
+
+        size_t       classBytes = 0;
+        const size_t index      = classIndex(bytes, &classBytes);
+        Bin&         bin        = mBins[index];
+        {
+            std::lock_guard<std::mutex> lock(bin.mutex);
+            if (FreeBlock* block = bin.head) {
+                bin.head = block->next;
+                mCachedBytes.fetch_sub(classBytes, std::memory_order_relaxed);
+                mCachedBlocks.fetch_sub(1, std::memory_order_relaxed);
+                mHits.fetch_add(1, std::memory_order_relaxed);
+                return block;
+            }
+        }
+
+        mMisses.fetch_add(1, std::memory_order_relaxed);
+        void* p = mUpstream->allocate(classBytes, kPoolAlignment);
+        if (!p && mCachedBytes.load(std::memory_order_relaxed) > 0) {
+            trim(0);  // memory pressure: give everything back and retry once
+            p = mUpstream->allocate(classBytes, kPoolAlignment);
+        }
+        return p;
+    }
+
+    void deallocate(void* p, size_t bytes, size_t alignment = alignof(std::max_align_t)) override
+    {
+        if (!p) return;
+        if (!pooled(bytes, alignment)) return mUpstream->deallocate(p, bytes, alignment);
+
+        size_t       classBytes = 0;
+        const size_t index      = classIndex(bytes, &classBytes);
+        if (mCachedBytes.fetch_add(classBytes, std::memory_order_relaxed) + classBytes > mMaxCachedBytes) {
+            mCachedBytes.fetch_sub(classBytes, std::memory_order_relaxed);
+            mOverflows.fetch_add(1, std::memory_order_relaxed);
+            mUpstream->deallocate(p, classBytes, kPoolAlignment);
+            return;
+        }
+
+        if (mDiscardBytes && classBytes >= mDiscardBytes) {
+            // Keep the page holding the free-list link.
+            if (au::sys::discardPages(static_cast<uint8_t*>(p) + sizeof(FreeBlock), classBytes - sizeof(FreeBlock))) {
+                mDiscards.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        Bin&                        bin   = mBins[index];
+        auto*                       block = static_cast<FreeBlock*>(p);
+        std::lock_guard<std::mutex> lock(bin.mutex);
+        block->next = bin.head;
+        bin.head    = block;
+        mCachedBlocks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Return cached blocks upstream, largest classes first, until at
+     *        most @p targetBytes stay cached.
+     * @return Bytes released.
+     */
+    size_t trim(size_t targetBytes = 0)
+    {
+        size_t released = 0;
+        for (size_t index = kClassCount; index-- > 0;) {
+            const size_t classBytes = classSize(index);
+            Bin&         bin        = mBins[index];
+            while (mCachedBytes.load(std::memory_order_relaxed) > targetBytes) {
+                FreeBlock* block = nullptr;
+                {
+                    std::lock_guard<std::mutex> lock(bin.mutex);
+                    if (!(block = bin.head)) break;
+                    bin.head = block->next;
+                }
+                mCachedBytes.fetch_sub(classBytes, std::memory_order_relaxed);
+                mCachedBlocks.fetch_sub(1, std::memory_order_relaxed);
+                mUpstream->deallocate(block, classBytes, kPoolAlignment);
+                released += classBytes;
+            }
+        }
+        mTrimmedBytes.fetch_add(released, std::memory_order_relaxed);
+        return released;
+    }
+
+    /**
+     * @brief trim(0) if the system has less than @p minAvailableBytes available
+     *        (au::sys::getMemoryInfo()); call it from a memory-pressure callback
+     *        or a periodic housekeeping task.
+     * @return Bytes released.
+     */
+    size_t trimIfLowMemory(uint64_t minAvailableBytes)
+    {
+        const auto info = au::sys::getMemoryInfo();
+        if (info.totalBytes == 0 || info.availableBytes >= minAvailableBytes) return 0;
+        return trim(0);
+    }
+
+    XPoolStats stats() const
+    {
+        XPoolStats s;
+        s.hits         = mHits.load(std::memory_order_relaxed);
+        s.misses       = mMisses.load(std::memory_order_relaxed);
+        s.overflows    = mOverflows.load(std::memory_order_relaxed);
+        s.trimmedBytes = mTrimmedBytes.load(std::memory_order_relaxed);
+        s.discards     = mDiscards.load(std::memory_order_relaxed);
+        s.cachedBytes  = mCachedBytes.load(std::memory_order_relaxed);
+        s.cachedBlocks = mCachedBlocks.load(std::memory_order_relaxed);
+        return s;
+    }
+
+    size_t maxCachedBytes() const { return mMaxCachedBytes; }
+    XMemoryResource* upstream() const { return mUpstream; }
+
+    /** @brief Bytes actually reserved for a pooled request of @p bytes. */
+    static size_t roundUp(size_t bytes)
+    {
+        size_t classBytes = 0;
+        classIndex(bytes, &classBytes);
+        return classBytes;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    struct Bin {
+        std::mutex mutex;
+        FreeBlock* head = nullptr;
+    };
+
+    static constexpr size_t kMinClassBytes = 64;
+    static constexpr size_t kMinClassBits  = 6;
+    static constexpr size_t kMaxClassBits  = 40;
+    // Class 0 is kMinClassBytes; then 4 classes per (2^k, 2^(k+1)].
+    static constexpr size_t kClassCount = (kMaxClassBits - kMinClassBits) * 4 + 1;
+
+    static bool pooled(size_t bytes, size_t alignment)
+    {
+        return alignment <= kPoolAlignment && bytes <= kMaxPooledBytes;
+    }
+
+    static size_t floorLog2(size_t v)
+    {
+        size_t bits = 0;
+        while (v >>= 1) ++bits;
+        return bits;
+    }
+
+    static size_t classIndex(size_t bytes, size_t* classBytes)
+    {
+        if (bytes <= kMinClassBytes) {
+            *classBytes = kMinClassBytes;
+            return 0;
+        }
+        const size_t k    = floorLog2(bytes - 1);  // 2^k < bytes <= 2^(k+1)
+        const size_t step = size_t(1) << (k - 2);
+        const size_t j    = (bytes - 1 - (size_t(1) << k)) / step + 1;  // 1..4
+        *classBytes       = (size_t(1) << k) + j * step;
+        return (k - kMinClassBits) * 4 + j;
+    }
+
+    static size_t classSize(size_t index)
+    {
+        if (index == 0) return kMinClassBytes;
+        const size_t k = (index - 1) / 4 + kMinClassBits;
+        const size_t j = (index - 1) % 4 + 1;
+        return (size_t(1) << k) + j * (size_t(1) << (k - 2));
+    }
+
+    XMemoryResource* const       mUpstream;
+    const size_t                 mMaxCachedBytes;
+    const size_t                 mDiscardBytes;
+    std::array<Bin, kClassCount> mBins;
+    std::atomic<size_t>          mCachedBytes{0};
+    std::atomic<size_t>          mCachedBlocks{0};
+    std::atomic<uint64_t>        mHits{0};
+    std::atomic<uint64_t>        mMisses{0};
+    std::atomic<uint64_t>        mOverflows{0};
+    std::atomic<uint64_t>        mTrimmedBytes{0};
+    std::atomic<uint64_t>        mDiscards{0};
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XPOOL_RESOURCE_H_
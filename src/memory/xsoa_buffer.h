@@ -0,0 +1,276 @@
+#ifndef AURA_MEMORY_XSOA_BUFFER_H_
+#define AURA_MEMORY_XSOA_BUFFER_H_
+
+/**
+ * @file xsoa_buffer.h
+ * @brief Structure-of-arrays container: one aligned column per field in a single block.
+ *
+ * XBuffer<Keypoint> interleaves the fields (AoS), so a kernel that only
+ * reads the scores strides over everything else. XSoABuffer<float, float,
+ * float, int> stores each field as its own contiguous column, each column
+ * starting on a cache line, so column<I>() can be streamed with unit-stride
+ * SIMD loads. Rows are still reachable through a lightweight proxy.
+ *
+ * Fields must be trivially copyable and destructible (columns move with
+ * memcpy). Unlike XBuffer, copies are deep: each copy has its own size and
+ * may append independently.
+ *
+ * @example
+ *   enum { X, Y, Score, Desc };
+ *   au::memory::XSoABuffer<float, float, float, int> kps;
+ *   kps.reserve(4096);
+ *   kps.append(10.f, 20.f, 0.9f, 0);
+ *
+ *   float* score = kps.data<Score>();                 // unit stride
+ *   for (size_t i = 0; i < kps.size(); ++i) score[i] *= 2.0f;
+ *
+ *   auto row = kps[0];
+ *   row.get<X>() += 0.5f;
+ *   auto [x, y, s, d] = row.tie();
+ */
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "xbuffer.h"
+
+namespace au { namespace memory {
+
+template <typename... Fields>
+class XSoABuffer {
+    static_assert(sizeof...(Fields) > 0, "XSoABuffer needs at least one field");
+    static_assert((std::is_trivially_copyable_v<Fields> && ...), "columns are moved with memcpy");
+    static_assert((std::is_trivially_destructible_v<Fields> && ...), "rows are dropped without destructors");
+
+public:
+    static constexpr size_t kFieldCount = sizeof...(Fields);
+
+    template <size_t I>
+    using Field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+    /// Proxy for one row; Const selects read-only access.
+    template <bool Const>
+    class RowRef {
+    public:
+        template <size_t I>
+        using Ref = std::conditional_t<Const, const Field<I>&, Field<I>&>;
+
+        template <size_t I>
+        Ref<I> get() const { return std::get<I>(mFields); }
+
+        /** @brief References to every field, for structured bindings. */
+        auto tie() const { return mFields; }
+
+        /** @brief The row by value. */
+        std::tuple<Fields...> value() const {
+            return std::apply([](auto&... f) { return std::tuple<Fields...>(f...); }, mFields);
+        }
+
+        template <bool C = Const, typename = std::enable_if_t<!C>>
+        void set(const Fields&... values) const {
+            assign(std::index_sequence_for<Fields...>(), values...);
+        }
+
+    private:
+        friend class XSoABuffer;
+        using Tuple = std::conditional_t<Const, std::tuple<const Fields&...>, std::tuple<Fields&...>>;
+
+        explicit RowRef(Tuple fields) : mFields(fields) {}
+
+        template <size_t... I>
+        void assign(std::index_sequence<I...>, const Fields&... values) const {
+            ((std::get<I>(mFields) = values), ...);
+        }
+
+        Tuple mFields;
+    };
+
+    using Row      = RowRef<false>;
+    using ConstRow = RowRef<true>;
+
+    XSoABuffer() = default;
+
+    /**
+     * @brief @p count rows allocated as @p options describe. Columns are
+     *        aligned to max(options.alignment, kCacheLineAlignment); new rows
+     *        are zeroed unless options.zeroFill is false.
+     */
+    explicit XSoABuffer(size_t count, const XBufferOptions& options = XBufferOptions()) : mOptions(options) {
+        mOptions.alignment = std::max(options.alignment, kCacheLineAlignment);
+        resize(count);
+    }
+
+    XSoABuffer(const XSoABuffer& other) : mOptions(other.mOptions) {
+        reallocate(other.mSize);
+        copyRows(other, other.mSize);
+        mSize = other.mSize;
+    }
+
+    XSoABuffer& operator=(const XSoABuffer& other) {
+        if (this != &other) {
+            XSoABuffer copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    XSoABuffer(XSoABuffer&& other) noexcept { swap(other); }
+
+    XSoABuffer& operator=(XSoABuffer&& other) noexcept {
+        if (this != &other) {
+            XSoABuffer moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    void swap(XSoABuffer& other) noexcept {
+        std::swap(mBlock, other.mBlock);
+        std::swap(mColumns, other.mColumns);
+        std::swap(mSize, other.mSize);
+        std::swap(mCapacity, other.mCapacity);
+        std::swap(mOptions, other.mOptions);
+    }
+
+    // -- Columns --
+
+    template <size_t I>
+    Field<I>* data() { return static_cast<Field<I>*>(mColumns[I]); }
+
+    template <size_t I>
+    const Field<I>* data() const { return static_cast<const Field<I>*>(mColumns[I]); }
+
+    template <size_t I>
+    XSpan<Field<I>> column() { return {data<I>(), mSize}; }
+
+    template <size_t I>
+    XSpan<const Field<I>> column() const { return {data<I>(), mSize}; }
+
+    // -- Rows --
+
+    Row operator[](size_t i) {
+        assert(i < mSize);
+        return rowAt(i, std::index_sequence_for<Fields...>());
+    }
+
+    ConstRow operator[](size_t i) const {
+        assert(i < mSize);
+        return rowAt(i, std::index_sequence_for<Fields...>());
+    }
+
+    Row row(size_t i) { return (*this)[i]; }
+    ConstRow row(size_t i) const { return (*this)[i]; }
+
+    // -- Size --
+
+    size_t size() const { return mSize; }
+    size_t capacity() const { return mCapacity; }
+    bool empty() const { return mSize == 0; }
+
+    /** @brief Bytes of the block holding all columns (alignment padding included). */
+    size_t blockBytes() const { return mBlock.size(); }
+
+    const XBufferOptions& options() const { return mOptions; }
+
+    // -- Mutation --
+
+    /** @brief Grow the capacity to at least @p count rows; rows are kept. */
+    void reserve(size_t count) {
+        if (count <= mCapacity) return;
+        XSoABuffer grown;
+        grown.mOptions = mOptions;
+        grown.reallocate(count);
+        grown.copyRows(*this, mSize);
+        grown.mSize = mSize;
+        swap(grown);
+    }
+
+    /** @brief Change the row count; new rows are zeroed unless options().zeroFill is false. */
+    void resize(size_t count) {
+        if (count > mCapacity) reserve(count);
+        if (count > mSize && mOptions.zeroFill) zeroRows(mSize, count, std::index_sequence_for<Fields...>());
+        mSize = count;
+    }
+
+    /** @brief Append one row, growing the capacity geometrically. Values may alias existing rows. */
+    void append(Fields... values) {
+        if (mSize == mCapacity) reserve(std::max<size_t>(16, mCapacity * 2));
+        ++mSize;
+        (*this)[mSize - 1].set(values...);
+    }
+
+    /** @brief Drop every row; the capacity is kept. */
+    void clear() { mSize = 0; }
+
+    /** @brief Shrink the capacity to the row count. */
+    void shrinkToFit() {
+        if (mCapacity == mSize) return;
+        XSoABuffer copy(*this);
+        swap(copy);
+    }
+
+private:
+    static constexpr size_t alignUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+
+    template <size_t... I>
+    Row rowAt(size_t i, std::index_sequence<I...>) {
+        return Row(std::tie(data<I>()[i]...));
+    }
+
+    template <size_t... I>
+    ConstRow rowAt(size_t i, std::index_sequence<I...>) const {
+        return ConstRow(std::tie(data<I>()[i]...));
+    }
+
+    template <size_t... I>
+    void zeroRows(size_t from, size_t to, std::index_sequence<I...>) {
+        (std::memset(static_cast<void*>(data<I>() + from), 0, (to - from) * sizeof(Field<I>)), ...);
+    }
+
+    /// Allocate a block for @p capacity rows and lay the columns out in it; rows are not copied.
+    void reallocate(size_t capacity) {
+        constexpr size_t sizes[] = {sizeof(Fields)...};
+        const size_t     align   = std::max(mOptions.alignment, kCacheLineAlignment);
+
+        std::array<size_t, kFieldCount> offsets{};
+        size_t                          total = 0;
+        for (size_t i = 0; i < kFieldCount; ++i) {
+            offsets[i] = alignUp(total, align);
+            total      = offsets[i] + capacity * sizes[i];
+        }
+
+        XBufferOptions blockOptions = mOptions;
+        blockOptions.alignment      = align;
+        blockOptions.zeroFill       = false;  // rows are zeroed by resize() as needed
+        mBlock                      = capacity ? XBuffer<uint8_t>(total, blockOptions) : XBuffer<uint8_t>();
+        for (size_t i = 0; i < kFieldCount; ++i) mColumns[i] = capacity ? mBlock.data() + offsets[i] : nullptr;
+        mCapacity = capacity;
+        mSize     = 0;
+    }
+
+    void copyRows(const XSoABuffer& from, size_t rows) {
+        copyRows(from, rows, std::index_sequence_for<Fields...>());
+    }
+
+    template <size_t... I>
+    void copyRows(const XSoABuffer& from, size_t rows, std::index_sequence<I...>) {
+        if (rows == 0) return;
+        (std::memcpy(static_cast<void*>(data<I>()), from.data<I>(), rows * sizeof(Field<I>)), ...);
+    }
+
+    XBuffer<uint8_t>               mBlock;
+    std::array<void*, kFieldCount> mColumns{};
+    size_t                         mSize     = 0;
+    size_t                         mCapacity = 0;
+    XBufferOptions                 mOptions{kCacheLineAlignment, true, nullptr};
+};
+
+}}  // namespace au::memory
+
+#endif // AURA_MEMORY_XSOA_BUFFER_H_
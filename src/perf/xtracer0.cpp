@@ -1,6 +1,7 @@
 #include "perf/xtracer0.h"
 
 #include <cstdio>
+#include <cstring>
 
 #include "log/xlogger.h"
 #include "sys/xplatform.h"
@@ -1,7 +1,13 @@
 #include "sys/xplatform.h"
 #include "log/xlogger.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
 #include <thread>
 #include <fstream>
 #include <sstream>
@@ -11,9 +17,15 @@
 #elif defined(AU_OS_APPLE)
 #include <sys/sysctl.h>
 #include <mach/mach.h>
+#include <pthread.h>
 #include <unistd.h>
 #elif defined(AU_OS_LINUX)
 #include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
 #include <sys/sysinfo.h>
 #endif
 
@@ -109,6 +121,7 @@ CpuInfo getCpuInfo() {
     info.modelName = model;
 
 #elif defined(AU_OS_LINUX)
+    info.cores = getCpuTopology();
     info.coreCount = static_cast<int>(sysconf(_SC_NPROCESSORS_CONF));
     info.onlineCoreCount = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
 
@@ -129,6 +142,404 @@ CpuInfo getCpuInfo() {
     return info;
 }
 
+// ============================================================================
+// CPU Topology (sysfs)
+// ============================================================================
+
+namespace {
+
+/// First line of a sysfs attribute, or empty if it cannot be read.
+std::string readSysfsLine(const std::filesystem::path& path) {
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+long long readSysfsInt(const std::filesystem::path& path, long long fallback) {
+    std::string line = readSysfsLine(path);
+    if (line.empty()) return fallback;
+    char* end = nullptr;
+    long long v = std::strtoll(line.c_str(), &end, 10);
+    return end == line.c_str() ? fallback : v;
+}
+
+int highestSharedCacheLevel(const std::filesystem::path& cpuDir) {
+    std::error_code ec;
+    int level = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(cpuDir / "cache", ec)) {
+        if (entry.path().filename().string().rfind("index", 0) != 0) continue;
+        if (parseCpuList(readSysfsLine(entry.path() / "shared_cpu_list")).size() > 1) {
+            level = std::max(level, static_cast<int>(readSysfsInt(entry.path() / "level", 0)));
+        }
+    }
+    return level;
+}
+
+}  // namespace
+
+std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string part;
+    while (std::getline(ss, part, ',')) {
+        int lo = 0, hi = 0;
+        if (std::sscanf(part.c_str(), "%d-%d", &lo, &hi) == 2) {
+            for (int c = lo; c <= hi; ++c) cpus.push_back(c);
+        } else if (std::sscanf(part.c_str(), "%d", &lo) == 1) {
+            cpus.push_back(lo);
+        }
+    }
+    return cpus;
+}
+
+std::vector<CpuCoreInfo> getCpuTopology(const std::string& sysfsRoot) {
+    namespace fs = std::filesystem;
+    std::vector<CpuCoreInfo> cores;
+    std::vector<int> policyKey;   // lowest cpu in the cpufreq domain, -1 if none
+    std::vector<int> clusterKey;  // topology/cluster_id (falls back to the package)
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(sysfsRoot, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() < 4 || name.compare(0, 3, "cpu") != 0 ||
+            name.find_first_not_of("0123456789", 3) != std::string::npos) {
+            continue;
+        }
+        const fs::path dir = entry.path();
+        CpuCoreInfo core;
+        core.id = std::atoi(name.c_str() + 3);
+        core.online = readSysfsInt(dir / "online", 1) != 0;
+        core.maxFreqKHz = static_cast<uint64_t>(std::max(0LL, readSysfsInt(dir / "cpufreq" / "cpuinfo_max_freq", 0)));
+        core.capacity = static_cast<int>(readSysfsInt(dir / "cpu_capacity", 0));
+        core.sharedCacheLevel = highestSharedCacheLevel(dir);
+
+        std::vector<int> related = parseCpuList(readSysfsLine(dir / "cpufreq" / "related_cpus"));
+        policyKey.push_back(related.empty() ? -1 : *std::min_element(related.begin(), related.end()));
+        long long cluster = readSysfsInt(dir / "topology" / "cluster_id", -1);
+        if (cluster < 0) cluster = readSysfsInt(dir / "topology" / "physical_package_id", 0);
+        clusterKey.push_back(static_cast<int>(cluster));
+        cores.push_back(core);
+    }
+
+    // cpufreq domains are the big.LITTLE clusters (DynamIQ parts report a
+    // single cluster_id for all cores). When every core has its own policy,
+    // as with intel_pstate, they carry no grouping, so use cluster_id.
+    std::map<int, int> domainSize;
+    for (int key : policyKey) {
+        if (key >= 0) ++domainSize[key];
+    }
+    bool useDomains = false;
+    for (const auto& kv : domainSize) {
+        useDomains = useDomains || kv.second > 1;
+    }
+
+    std::vector<size_t> order(cores.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return cores[a].id < cores[b].id; });
+
+    std::vector<CpuCoreInfo> sorted;
+    std::map<int, int> dense;
+    for (size_t i : order) {
+        const int key = useDomains && policyKey[i] >= 0 ? policyKey[i] : clusterKey[i];
+        auto it = dense.emplace(key, static_cast<int>(dense.size())).first;
+        cores[i].clusterId = it->second;
+        sorted.push_back(cores[i]);
+    }
+    return sorted;
+}
+
+std::vector<int> getPerformanceCores(const std::vector<CpuCoreInfo>& cores) {
+    uint64_t bestFreq = 0;
+    int bestCapacity = 0;
+    for (const auto& c : cores) {
+        if (!c.online) continue;
+        bestFreq = std::max(bestFreq, c.maxFreqKHz);
+        bestCapacity = std::max(bestCapacity, c.capacity);
+    }
+    std::vector<int> ids;
+    for (const auto& c : cores) {
+        if (!c.online) continue;
+        if (bestFreq > 0 ? c.maxFreqKHz == bestFreq : bestCapacity == 0 || c.capacity == bestCapacity) {
+            ids.push_back(c.id);
+        }
+    }
+    return ids;
+}
+
+// ============================================================================
+// Thread control
+// ============================================================================
+
+bool setThreadAffinity(const std::vector<int>& cpus) {
+#if defined(AU_OS_LINUX)
+    if (cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int c : cpus) {
+        if (c < 0 || c >= CPU_SETSIZE) return false;
+        CPU_SET(c, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+std::vector<int> getThreadAffinity() {
+    std::vector<int> cpus;
+#if defined(AU_OS_LINUX)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) cpus.push_back(c);
+        }
+    }
+#endif
+    return cpus;
+}
+
+bool setThreadName(const std::string& name) {
+#if defined(AU_OS_LINUX)
+    return pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+#elif defined(AU_OS_APPLE)
+    return pthread_setname_np(name.c_str()) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
+
+bool setThreadScheduling(SchedPolicy policy, int priority) {
+#if defined(AU_OS_LINUX)
+    int native = SCHED_OTHER;
+    switch (policy) {
+        case SchedPolicy::Batch:      native = SCHED_BATCH; break;
+        case SchedPolicy::Idle:       native = SCHED_IDLE;  break;
+        case SchedPolicy::Fifo:       native = SCHED_FIFO;  break;
+        case SchedPolicy::RoundRobin: native = SCHED_RR;    break;
+        default:                      break;
+    }
+    const bool realtime = native == SCHED_FIFO || native == SCHED_RR;
+    sched_param param{};
+    param.sched_priority = realtime ? priority : 0;
+    if (sched_setscheduler(0, native, &param) != 0) return false;
+    if (realtime || native == SCHED_IDLE) return true;
+    // Nice values are per thread on Linux when addressed by tid.
+    return setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), priority) == 0;
+#else
+    (void)policy;
+    (void)priority;
+    return false;
+#endif
+}
+
+// ============================================================================
+// NUMA (sysfs and raw syscalls; no libnuma)
+// ============================================================================
+
+std::vector<NumaNodeInfo> getNumaTopology(const std::string& sysfsRoot) {
+    namespace fs = std::filesystem;
+    std::vector<NumaNodeInfo> nodes;
+
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(sysfsRoot, ec)) {
+        const std::string name = entry.path().filename().string();
+        if (name.size() < 5 || name.compare(0, 4, "node") != 0 ||
+            name.find_first_not_of("0123456789", 4) != std::string::npos) {
+            continue;
+        }
+        NumaNodeInfo node;
+        node.id = std::atoi(name.c_str() + 4);
+        node.cpus = parseCpuList(readSysfsLine(entry.path() / "cpulist"));
+
+        std::stringstream distances(readSysfsLine(entry.path() / "distance"));
+        int d = 0;
+        while (distances >> d) node.distances.push_back(d);
+
+        // "Node 0 MemTotal:       32795224 kB"
+        std::ifstream meminfo(entry.path() / "meminfo");
+        std::string line;
+        while (std::getline(meminfo, line)) {
+            auto pos = line.find("MemTotal:");
+            if (pos != std::string::npos) {
+                node.totalBytes = std::strtoull(line.c_str() + pos + 9, nullptr, 10) * 1024;
+                break;
+            }
+        }
+        nodes.push_back(std::move(node));
+    }
+    std::sort(nodes.begin(), nodes.end(), [](const NumaNodeInfo& a, const NumaNodeInfo& b) { return a.id < b.id; });
+    return nodes;
+}
+
+int getCurrentCpu() {
+#if defined(AU_OS_LINUX)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+void* allocOnNode(size_t bytes, int node) {
+    if (bytes == 0) return nullptr;
+#if defined(AU_OS_LINUX)
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+#if defined(SYS_mbind)
+    // Pages are not faulted in yet, so the policy decides where they land.
+    constexpr int kMpolPreferred = 1;
+    constexpr int kMaskBits      = 8 * sizeof(unsigned long);
+    if (node >= 0 && node < kMaskBits) {
+        unsigned long mask = 1UL << node;
+        static std::atomic<bool> warned{false};
+        if (syscall(SYS_mbind, p, bytes, kMpolPreferred, &mask, kMaskBits + 1, 0) != 0 && !warned.exchange(true)) {
+            XLOG_W("mbind to node %d refused; memory is placed by first touch\n", node);
+        }
+    }
+#else
+    (void)node;
+#endif
+    return p;
+#else
+    (void)node;
+    return std::calloc(1, bytes);
+#endif
+}
+
+void freeOnNode(void* ptr, size_t bytes) {
+    if (!ptr) return;
+#if defined(AU_OS_LINUX)
+    munmap(ptr, bytes);
+#else
+    (void)bytes;
+    std::free(ptr);
+#endif
+}
+
+// ============================================================================
+// Pages
+// ============================================================================
+
+size_t getPageSize() {
+#if defined(AU_OS_LINUX) || defined(AU_OS_APPLE)
+    static const size_t size = [] {
+        const long n = sysconf(_SC_PAGESIZE);
+        return n > 0 ? static_cast<size_t>(n) : size_t(4096);
+    }();
+    return size;
+#else
+    return 4096;
+#endif
+}
+
+size_t getHugePageSize() {
+#if defined(AU_OS_LINUX)
+    static const size_t size = [] {
+        std::ifstream meminfo("/proc/meminfo");
+        std::string   line;
+        while (std::getline(meminfo, line)) {
+            unsigned long long kb = 0;
+            if (std::sscanf(line.c_str(), "Hugepagesize: %llu kB", &kb) == 1) return static_cast<size_t>(kb) * 1024;
+        }
+        return size_t(0);
+    }();
+    return size;
+#else
+    return 0;
+#endif
+}
+
+namespace {
+
+size_t roundUpTo(size_t value, size_t unit) { return (value + unit - 1) / unit * unit; }
+
+/// Length actually mapped for a request; freePages() must unmap the same.
+size_t mappedLength(size_t bytes, const PageAllocOptions& options) {
+    size_t unit = getPageSize();
+    if (options.hugePages == HugePages::Explicit && getHugePageSize() > 0) unit = getHugePageSize();
+    return roundUpTo(bytes, unit);
+}
+
+}  // namespace
+
+void* allocPages(size_t bytes, const PageAllocOptions& options) {
+    if (bytes == 0) return nullptr;
+#if defined(AU_OS_LINUX)
+    const size_t length = mappedLength(bytes, options);
+    const int    flags  = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_POPULATE)
+    const int populate = options.populate ? MAP_POPULATE : 0;
+#else
+    const int populate = 0;
+#endif
+
+    if (options.hugePages == HugePages::Explicit) {
+#if defined(MAP_HUGETLB)
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags | populate | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return p;
+#endif
+        static std::atomic<bool> warned{false};
+        if (!warned.exchange(true)) XLOG_W("no free hugetlb pages (vm.nr_hugepages); using transparent huge pages\n");
+    }
+    if (options.hugePages == HugePages::None) {
+        void* p = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags | populate, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    // THP only backs huge-page-aligned ranges: over-map, then trim both ends.
+    const size_t huge = getHugePageSize() > 0 ? getHugePageSize() : size_t(2) << 20;
+    void*        raw  = mmap(nullptr, length + huge, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    const uintptr_t start   = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = roundUpTo(start, huge);
+    if (aligned > start) munmap(raw, aligned - start);
+    if (start + huge > aligned) munmap(reinterpret_cast<void*>(aligned + length), start + huge - aligned);
+    auto* p = reinterpret_cast<uint8_t*>(aligned);
+#if defined(MADV_HUGEPAGE)
+    madvise(p, length, MADV_HUGEPAGE);
+#endif
+    if (options.populate) {
+        // After the advice, so the faults are served with huge pages.
+#if defined(MADV_POPULATE_WRITE)
+        if (madvise(p, length, MADV_POPULATE_WRITE) == 0) return p;
+#endif
+        for (size_t i = 0; i < length; i += getPageSize()) reinterpret_cast<volatile uint8_t*>(p)[i] = 0;
+    }
+    return p;
+#else
+    (void)options;
+    return std::calloc(1, bytes);
+#endif
+}
+
+void freePages(void* ptr, size_t bytes, const PageAllocOptions& options) {
+    if (!ptr) return;
+#if defined(AU_OS_LINUX)
+    munmap(ptr, mappedLength(bytes, options));
+#else
+    (void)bytes;
+    (void)options;
+    std::free(ptr);
+#endif
+}
+
+bool discardPages(void* ptr, size_t bytes) {
+#if defined(AU_OS_LINUX)
+    const size_t    page  = getPageSize();
+    const uintptr_t begin = roundUpTo(reinterpret_cast<uintptr_t>(ptr), page);
+    const uintptr_t end   = (reinterpret_cast<uintptr_t>(ptr) + bytes) / page * page;
+    if (end <= begin) return false;
+    return madvise(reinterpret_cast<void*>(begin), end - begin, MADV_DONTNEED) == 0;
+#else
+    (void)ptr;
+    (void)bytes;
+    return false;
+#endif
+}
+
 // ============================================================================
 // Memory Info
 // ============================================================================
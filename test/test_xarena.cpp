@@ -0,0 +1,122 @@
+#if ENABLE_TEST_XARENA
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include "gtest/gtest.h"
+#include "memory/xarena.h"
+#include "memory/xbuffer.h"
+#include "memory/xmemory_resource.h"
+
+using au::memory::XBuffer;
+
+namespace {
+
+struct CountingResource : au::memory::XMemoryResource {
+    int    allocs = 0, frees = 0;
+    size_t live   = 0;
+
+    void* allocate(size_t bytes, size_t alignment) override {
+        ++allocs;
+        live += bytes;
+        return au::memory::defaultResource()->allocate(bytes, alignment);
+    }
+    void deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++frees;
+        live -= bytes;
+        au::memory::defaultResource()->deallocate(p, bytes, alignment);
+    }
+};
+
+}  // namespace
+
+using au::memory::XArena;
+using au::memory::XArenaOptions;
+using au::memory::XArenaScope;
+
+TEST(XArena, BumpsAndAligns) {
+    CountingResource upstream;
+    XArenaOptions    opt;
+    opt.blockBytes = 4096;
+    opt.upstream   = &upstream;
+    XArena arena(opt);
+
+    auto* a = static_cast<uint8_t*>(arena.allocate(10, 1));
+    auto* b = static_cast<uint8_t*>(arena.allocate(8, 8));
+    EXPECT_EQ(b, a + 16);  // padded to 8
+    void* c = arena.allocate(100, 64);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(c) % 64, 0u);
+    void* page = arena.allocate(100, au::memory::kPageAlignment);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(page) % 4096, 0u);
+    void* big = arena.allocate(10000);  // a block of its own
+    ASSERT_NE(big, nullptr);
+    std::memset(big, 1, 10000);
+    EXPECT_EQ(upstream.allocs, int(arena.blockCount()));
+    arena.deallocate(a, 10, 1);  // no-op
+    EXPECT_GE(arena.used(), 10000u);
+}
+
+TEST(XArena, MarkerRewindAndReset) {
+    CountingResource upstream;
+    XArenaOptions    opt;
+    opt.blockBytes = 1024;
+    opt.upstream   = &upstream;
+    XArena arena(opt);
+
+    arena.allocate(100);
+    const auto mark  = arena.mark();
+    void*      first = arena.allocate(200);
+    for (int i = 0; i < 10; ++i) arena.allocate(500);  // spills into more blocks
+    const int blocks = upstream.allocs;
+    EXPECT_GT(blocks, 1);
+
+    arena.rewind(mark);
+    EXPECT_EQ(arena.used(), mark.offset);
+    EXPECT_EQ(arena.allocate(200), first);
+
+    // Steady state: the next frames reuse the same blocks.
+    for (int frame = 0; frame < 5; ++frame) {
+        arena.reset();
+        EXPECT_EQ(arena.used(), 0u);
+        arena.allocate(100);
+        arena.allocate(200);
+        for (int i = 0; i < 10; ++i) arena.allocate(500);
+    }
+    EXPECT_EQ(upstream.allocs, blocks);
+    EXPECT_EQ(arena.capacity(), upstream.live);
+
+    arena.release();
+    EXPECT_EQ(upstream.live, 0u);
+    EXPECT_EQ(arena.blockCount(), 0u);
+}
+
+TEST(XArena, ScopedBuffers) {
+    XArena& arena = XArena::local();
+    arena.reset();
+    const size_t before = arena.used();
+    {
+        XArenaScope frame(arena);
+        XBuffer<float> tmp(1000, au::memory::XBufferOptions{64, false, &arena});
+        XBuffer<int>   zeroed(100, arena);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(tmp.data()) % 64, 0u);
+        EXPECT_EQ(zeroed[99], 0);
+        EXPECT_GT(arena.used(), 1000 * sizeof(float));
+        tmp.resize(2000);  // bumps again, the old storage is not reclaimed
+    }
+    EXPECT_EQ(arena.used(), before);
+}
+
+TEST(XArena, LocalIsPerThread) {
+    XArena* mine = &XArena::local();
+    XArena* other = nullptr;
+    std::thread([&] {
+        other = &XArena::local();
+        XArenaScope frame;
+        EXPECT_NE(frame.arena().allocate(64), nullptr);
+    }).join();
+    EXPECT_NE(mine, other);
+    EXPECT_EQ(mine, &XArena::local());
+}
+
+#endif  // ENABLE_TEST_XARENA
@@ -0,0 +1,248 @@
+#if ENABLE_TEST_XCORO
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "flow/xcoro.h"
+#include "flow/xthread_flow.h"
+#include "log/xerror.h"
+
+using namespace au::flow;
+
+namespace {
+
+XCoTask<int> answer()
+{
+    co_return 42;
+}
+
+XCoTask<int> addOne(XCoTask<int> inner)
+{
+    int v = co_await inner;
+    co_return v + 1;
+}
+
+XCoTask<int> failing()
+{
+    throw std::runtime_error("boom");
+    co_return 0;
+}
+
+XCoTask<std::thread::id> threadAfterSchedule(XThreadpool& pool)
+{
+    co_await pool.schedule();
+    co_return std::this_thread::get_id();
+}
+
+XCoTask<int> squareOn(XThreadpool& pool, int v)
+{
+    co_await pool.schedule();
+    co_return v * v;
+}
+
+XCoTask<void> bump(XThreadpool& pool, std::atomic<int>& counter)
+{
+    co_await pool.schedule();
+    counter.fetch_add(1);
+}
+
+XCoTask<int> sleepThen(XThreadpool& pool, int ms, int v)
+{
+    co_await pool.schedule();
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    co_return v;
+}
+
+template <class Pred>
+void waitFor(Pred pred)
+{
+    while (!pred()) std::this_thread::yield();
+}
+
+}  // anonymous namespace
+
+// ============================================================================
+// XCoTask
+// ============================================================================
+
+TEST(XCoro, Task_is_lazy_and_chains)
+{
+    bool started = false;
+    // Named so the closure outlives the lazy frame that refers to its captures.
+    auto body = [&]() -> XCoTask<int> {
+        started = true;
+        co_return 7;
+    };
+    auto task = body();
+    EXPECT_FALSE(started);
+    EXPECT_EQ(syncWait(addOne(std::move(task))), 8);
+    EXPECT_TRUE(started);
+    EXPECT_EQ(syncWait(addOne(answer())), 43);
+}
+
+TEST(XCoro, Task_exception_reaches_awaiter)
+{
+    EXPECT_THROW(syncWait(addOne(failing())), std::runtime_error);
+}
+
+TEST(XCoro, Task_nested_chain)
+{
+    struct Chain {
+        static XCoTask<int> depth(int n)
+        {
+            if (n == 0) co_return 0;
+            co_return 1 + co_await depth(n - 1);
+        }
+    };
+    EXPECT_EQ(syncWait(Chain::depth(1000)), 1000);
+}
+
+// ============================================================================
+// schedule
+// ============================================================================
+
+TEST(XCoro, Schedule_resumes_on_a_worker)
+{
+    XThreadpool pool(2);
+    auto        id = syncWait(threadAfterSchedule(pool));
+    EXPECT_NE(id, std::this_thread::get_id());
+}
+
+TEST(XCoro, Flow_schedule_resumes_on_a_flow_worker)
+{
+    auto& flow = XFlow::get();
+    flow.init(2, 1);  // may already be initialised by another test
+
+    auto task = [&]() -> XCoTask<std::thread::id> {
+        co_await flow.schedule(kPriorityHigh);
+        co_return std::this_thread::get_id();
+    };
+    EXPECT_NE(syncWait(task()), std::this_thread::get_id());
+}
+
+// ============================================================================
+// whenAll / whenAny
+// ============================================================================
+
+TEST(XCoro, WhenAll_keeps_order)
+{
+    XThreadpool               pool(3);
+    std::vector<XCoTask<int>> tasks;
+    for (int i = 0; i < 64; ++i) tasks.push_back(squareOn(pool, i));
+    auto out = syncWait(whenAll(std::move(tasks)));
+    ASSERT_EQ(out.size(), 64u);
+    for (int i = 0; i < 64; ++i) EXPECT_EQ(out[i], i * i);
+}
+
+TEST(XCoro, WhenAll_void_and_empty)
+{
+    XThreadpool                pool(2);
+    std::atomic<int>           counter{0};
+    std::vector<XCoTask<void>> tasks;
+    for (int i = 0; i < 32; ++i) tasks.push_back(bump(pool, counter));
+    syncWait(whenAll(std::move(tasks)));
+    EXPECT_EQ(counter.load(), 32);
+
+    EXPECT_TRUE(syncWait(whenAll(std::vector<XCoTask<int>>{})).empty());
+}
+
+TEST(XCoro, WhenAll_rethrows_after_every_task_finished)
+{
+    XThreadpool               pool(2);
+    std::vector<XCoTask<int>> tasks;
+    tasks.push_back(sleepThen(pool, 20, 1));
+    tasks.push_back(failing());
+    tasks.push_back(squareOn(pool, 3));
+    EXPECT_THROW(syncWait(whenAll(std::move(tasks))), std::runtime_error);
+}
+
+TEST(XCoro, WhenAny_returns_first_finisher)
+{
+    XThreadpool               pool(3);
+    std::vector<XCoTask<int>> tasks;
+    tasks.push_back(sleepThen(pool, 300, 1));
+    tasks.push_back(sleepThen(pool, 0, 2));
+    auto first = syncWait(whenAny(std::move(tasks)));
+    EXPECT_EQ(first.index, 1u);
+    EXPECT_EQ(first.value, 2);
+
+    EXPECT_THROW(syncWait(whenAny(std::vector<XCoTask<int>>{})), std::invalid_argument);
+    // pool destructor drains the straggler
+}
+
+// ============================================================================
+// loadAsync
+// ============================================================================
+
+TEST(XCoro, LoadAsync_reads_file_and_reports_errors)
+{
+    XThreadpool io(1);
+    std::string path = "/tmp/aura_xcoro_test_single";
+    FILE*       fp   = std::fopen(path.c_str(), "wb");
+    ASSERT_NE(fp, nullptr);
+    std::fputs("hello", fp);
+    std::fclose(fp);
+
+    auto load = syncWait(loadAsync(io, path));
+    EXPECT_EQ(load.status, err::kSuccess);
+    EXPECT_EQ(std::string(load.data.data()), "hello");
+
+    EXPECT_NE(syncWait(loadAsync(io, "/tmp/__aura_nonexistent_xyz__")).status, err::kSuccess);
+    std::remove(path.c_str());
+}
+
+TEST(XCoro, LoadAsync_hundreds_in_flight_on_two_threads)
+{
+    constexpr int kFiles = 256;
+    std::vector<std::string> paths;
+    for (int i = 0; i < kFiles; ++i) {
+        paths.push_back("/tmp/aura_xcoro_test_" + std::to_string(i));
+        FILE* fp = std::fopen(paths.back().c_str(), "wb");
+        ASSERT_NE(fp, nullptr);
+        std::fprintf(fp, "%d", i);
+        std::fclose(fp);
+    }
+
+    XThreadpoolOptions ioOpt;
+    ioOpt.threads = 2;
+    ioOpt.name    = "io";
+    XThreadpool io(ioOpt);
+
+    // Hold both I/O threads until every load is suspended on them.
+    std::atomic<int> launched{0}, inFlight{0}, peak{0};
+    for (int i = 0; i < 2; ++i) io.submit([&] { waitFor([&] { return launched.load() == kFiles; }); });
+
+    auto tracked = [&](std::string path) -> XCoTask<XFileLoad> {
+        int now = inFlight.fetch_add(1) + 1;
+        int old = peak.load();
+        while (old < now && !peak.compare_exchange_weak(old, now)) {}
+        launched.fetch_add(1);
+        auto load = co_await loadAsync(io, std::move(path));
+        inFlight.fetch_sub(1);
+        co_return load;
+    };
+
+    std::vector<XCoTask<XFileLoad>> loads;
+    for (auto& p : paths) loads.push_back(tracked(p));
+    auto files = syncWait(whenAll(std::move(loads)));
+
+    ASSERT_EQ(files.size(), size_t(kFiles));
+    for (int i = 0; i < kFiles; ++i) {
+        EXPECT_EQ(files[i].status, err::kSuccess);
+        EXPECT_EQ(std::stoi(files[i].data.data()), i);
+    }
+    EXPECT_EQ(peak.load(), kFiles);
+    EXPECT_EQ(inFlight.load(), 0);
+    EXPECT_LE(io.liveThreads(), 2u);
+
+    for (auto& p : paths) std::remove(p.c_str());
+}
+
+#endif  // ENABLE_TEST_XCORO
@@ -0,0 +1,103 @@
+#if ENABLE_TEST_XCOW_BUFFER
+
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "memory/xbuffer.h"
+#include "memory/xcow_buffer.h"
+#include "memory/xmemory_resource.h"
+
+using au::memory::XBuffer;
+
+namespace {
+
+struct CountingResource : au::memory::XMemoryResource {
+    int    allocs = 0, frees = 0;
+    size_t live   = 0;
+
+    void* allocate(size_t bytes, size_t alignment) override {
+        ++allocs;
+        live += bytes;
+        return au::memory::defaultResource()->allocate(bytes, alignment);
+    }
+    void deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++frees;
+        live -= bytes;
+        au::memory::defaultResource()->deallocate(p, bytes, alignment);
+    }
+};
+
+}  // namespace
+
+using au::memory::XCowBuffer;
+
+TEST(XCowBuffer, CopiesShareUntilWrite) {
+    XCowBuffer<int> a(100, 1);
+    const int*      storage = a.cdata();
+    EXPECT_TRUE(a.isUnique());
+
+    XCowBuffer<int> b = a;
+    XCowBuffer<int> c = a;
+    EXPECT_FALSE(a.isUnique());
+    EXPECT_EQ(std::as_const(b).data(), storage);  // reads do not copy
+    EXPECT_EQ(std::as_const(c)[50], 1);
+    EXPECT_EQ(c.cdata(), storage);
+
+    b[0] = 7;  // detaches b only
+    EXPECT_NE(b.cdata(), storage);
+    EXPECT_TRUE(b.isUnique());
+    EXPECT_EQ(std::as_const(b)[99], 1);
+    EXPECT_EQ(std::as_const(a)[0], 1);
+    EXPECT_EQ(std::as_const(c)[0], 1);
+
+    c.clear();
+    EXPECT_TRUE(a.isUnique());
+    a.fill(2);  // unique: in place
+    EXPECT_EQ(a.cdata(), storage);
+    EXPECT_EQ(std::as_const(a)[0], 2);
+}
+
+TEST(XCowBuffer, ViewsKeepSnapshot) {
+    CountingResource res;
+    {
+        XCowBuffer<float> frame(16, au::memory::XBufferOptions{64, false, &res});
+        frame.fill(1.0f);
+        auto snapshot = frame.view();
+        EXPECT_FALSE(frame.isUnique());
+
+        float* p = frame.data();  // detaches from the view
+        p[0]     = 9.0f;
+        EXPECT_EQ(snapshot[0], 1.0f);
+        EXPECT_EQ(frame.options().resource, &res);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0u);
+        EXPECT_EQ(frame.span().size(), 16u);
+    }
+    EXPECT_EQ(res.live, 0u);
+
+    XBuffer<int>    plain(4, 5);
+    XCowBuffer<int> adopted(plain);
+    adopted[1] = 6;  // plain still holds it, so this copies
+    EXPECT_EQ(plain[1], 5);
+}
+
+TEST(XCowBuffer, ConcurrentWritersDetach) {
+    XCowBuffer<int>          shared(1000, 0);
+    std::vector<std::thread> writers;
+    std::vector<long>        sums(4);
+    for (int t = 0; t < 4; ++t) {
+        writers.emplace_back([copy = shared, &sums, t]() mutable {
+            int* p = copy.data();
+            for (size_t i = 0; i < copy.size(); ++i) p[i] = t;
+            long s = 0;
+            for (int v : std::as_const(copy)) s += v;
+            sums[t] = s;
+        });
+    }
+    for (auto& w : writers) w.join();
+    for (int t = 0; t < 4; ++t) EXPECT_EQ(sums[t], 1000L * t);
+    EXPECT_EQ(std::as_const(shared)[0], 0);
+}
+
+#endif  // ENABLE_TEST_XCOW_BUFFER
@@ -1,3 +1,5 @@
+#include <climits>
+
 #include "gtest/gtest.h"
 #include "log/xerror.h"
 
@@ -1,13 +1,38 @@
 #if ENABLE_TEST_XFLOW
 
+#include <algorithm>
+#include <array>
 #include <atomic>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
 #include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "flow/xcancel.h"
+#include "flow/xparallel_algorithm.h"
+#include "flow/xparallel_for.h"
+#include "flow/xpipeline.h"
+#include "flow/xring_queue.h"
+#include "flow/xtask.h"
+#include "flow/xtask_graph.h"
 #include "flow/xthreadpool.h"
 #include "flow/xthread_flow.h"
+#include "flow/xtimer_wheel.h"
+#include "perf/xtimer4.h"
+#include "sys/xplatform.h"
 
 // ============================================================================
 // XThreadpool
@@ -94,6 +119,2242 @@ TEST(XFlow, Threadpool_enqueue_after_destruction_throws)
     SUCCEED();  // XThreadpool destructor joins workers gracefully
 }
 
+TEST(XFlow, Threadpool_tasks_spawned_from_workers)
+{
+    // Outer tasks push inner tasks onto their own deque; other workers steal them.
+    au::flow::XThreadpool pool(4);
+    std::atomic<int>      counter{0};
+    std::vector<std::future<void>> outer;
+    for (int i = 0; i < 16; ++i) {
+        outer.push_back(pool.enqueue([&pool, &counter]() {
+            for (int j = 0; j < 64; ++j) {
+                pool.enqueue([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); });
+            }
+        }));
+    }
+    for (auto& f : outer) f.get();
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (counter.load() < 16 * 64 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::yield();
+    }
+    EXPECT_EQ(counter.load(), 16 * 64);
+}
+
+TEST(XFlow, Threadpool_many_external_producers)
+{
+    au::flow::XThreadpool    pool(4);
+    std::atomic<int>         counter{0};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < 4; ++p) {
+        producers.emplace_back([&pool, &counter]() {
+            std::vector<std::future<void>> futures;
+            for (int i = 0; i < 500; ++i) {
+                futures.push_back(pool.enqueue([&counter]() { counter.fetch_add(1, std::memory_order_relaxed); }));
+            }
+            for (auto& f : futures) f.get();
+        });
+    }
+    for (auto& t : producers) t.join();
+    EXPECT_EQ(counter.load(), 4 * 500);
+}
+
+TEST(XFlow, Threadpool_zero_threads_destructs_cleanly)
+{
+    au::flow::XThreadpool pool(0);
+    EXPECT_EQ(pool.size(), 0u);
+    auto f = pool.enqueue([]() { return 1; });
+    EXPECT_EQ(f.wait_for(std::chrono::milliseconds(1)), std::future_status::timeout);
+}
+
+// ----------------------------------------------------------------------------
+// Contention benchmark: work-stealing pool vs. the former single-queue pool
+// ----------------------------------------------------------------------------
+
+namespace {
+
+/// The pre-work-stealing XThreadpool: one std::queue behind one mutex + cv.
+class SharedQueuePool {
+public:
+    explicit SharedQueuePool(size_t threads)
+    {
+        for (size_t i = 0; i < threads; ++i) {
+            mWorkers.emplace_back([this] {
+                for (;;) {
+                    std::function<void()> task;
+                    {
+                        std::unique_lock<std::mutex> lock(mMutex);
+                        mCondition.wait(lock, [this] { return mStopped || !mTasks.empty(); });
+                        if (mStopped && mTasks.empty()) return;
+                        task = std::move(mTasks.front());
+                        mTasks.pop();
+                    }
+                    task();
+                }
+            });
+        }
+    }
+
+    ~SharedQueuePool()
+    {
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mStopped = true;
+        }
+        mCondition.notify_all();
+        for (auto& w : mWorkers) w.join();
+    }
+
+    template <class F>
+    std::future<void> enqueue(F&& f)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::forward<F>(f));
+        auto res  = task->get_future();
+        {
+            std::unique_lock<std::mutex> lock(mMutex);
+            mTasks.emplace([task]() { (*task)(); });
+        }
+        mCondition.notify_one();
+        return res;
+    }
+
+private:
+    std::vector<std::thread>          mWorkers;
+    std::queue<std::function<void()>> mTasks;
+    std::mutex                        mMutex;
+    std::condition_variable           mCondition;
+    bool                              mStopped = false;
+};
+
+/// Fan-out from @p producers threads of @p perProducer tiny tasks; returns ns per task.
+template <class Pool>
+double benchTinyTasks(Pool& pool, int producers, int perProducer)
+{
+    std::atomic<int> done{0};
+    auto             begin = std::chrono::steady_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&pool, &done, perProducer]() {
+            std::vector<std::future<void>> futures;
+            futures.reserve(perProducer);
+            for (int i = 0; i < perProducer; ++i) {
+                futures.push_back(pool.enqueue([&done]() { done.fetch_add(1, std::memory_order_relaxed); }));
+            }
+            for (auto& f : futures) f.get();
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / (producers * perProducer);
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Bench_threadpool_contention)
+{
+    const int    kProducers   = 4;
+    const int    kPerProducer = 5000;
+    const size_t threadCounts[] = {2, 4, 16};
+
+    for (size_t threads : threadCounts) {
+        double legacyNs = 0.0;
+        double stealNs  = 0.0;
+        {
+            SharedQueuePool pool(threads);
+            legacyNs = benchTinyTasks(pool, kProducers, kPerProducer);
+        }
+        {
+            au::flow::XThreadpool pool(threads);
+            stealNs = benchTinyTasks(pool, kProducers, kPerProducer);
+        }
+        printf("[  BENCH   ] threads=%2zu shared-queue %8.1f ns/task | work-stealing %8.1f ns/task\n", threads,
+               legacyNs, stealNs);
+        EXPECT_GT(stealNs, 0.0);
+    }
+}
+
+// ============================================================================
+// XTask / submit / XTaskGroup
+// ============================================================================
+
+TEST(XFlow, Task_inline_and_pooled_storage)
+{
+    int   hits = 0;
+    char  big[200] = {};
+    big[0]         = 1;
+    au::flow::XTask small([&hits] { ++hits; });
+    au::flow::XTask large([&hits, big] { hits += big[0]; });
+
+    au::flow::XTask moved = std::move(large);
+    EXPECT_FALSE(static_cast<bool>(large));
+    small();
+    moved();
+    EXPECT_EQ(hits, 2);
+}
+
+TEST(XFlow, Task_over_aligned_capture)
+{
+    struct alignas(128) Aligned {
+        int value = 5;
+    };
+    Aligned         a;
+    uintptr_t       addr = 0;
+    int             out  = 0;
+    au::flow::XTask t([a, &addr, &out]() mutable {
+        addr = reinterpret_cast<uintptr_t>(&a);
+        out  = a.value;
+    });
+    au::flow::XTask moved = std::move(t);
+    moved();
+    EXPECT_EQ(out, 5);
+    EXPECT_EQ(addr % 128, 0u);
+}
+
+TEST(XFlow, Task_move_only_capture)
+{
+    auto            ptr = std::make_unique<int>(7);
+    int             out = 0;
+    au::flow::XTask t([p = std::move(ptr), &out] { out = *p; });
+    t();
+    EXPECT_EQ(out, 7);
+}
+
+TEST(XFlow, Threadpool_submit_with_args)
+{
+    au::flow::XThreadpool pool(2);
+    std::atomic<int>      sum{0};
+    {
+        au::flow::XTaskGroup group(pool);
+        for (int i = 1; i <= 100; ++i) {
+            group.run([&sum, i] { sum.fetch_add(i, std::memory_order_relaxed); });
+        }
+        group.wait();
+    }
+    EXPECT_EQ(sum.load(), 5050);
+
+    std::atomic<int> seen{0};
+    pool.submit([&seen](int v) { seen.store(v); }, 9);
+    while (seen.load() != 9) std::this_thread::yield();
+}
+
+TEST(XFlow, Threadpool_submit_exception_is_contained)
+{
+    au::flow::XThreadpool pool(1);
+    au::flow::XTaskGroup  group(pool);
+    std::atomic<int>      after{0};
+    group.run([] { throw std::runtime_error("boom"); });
+    group.run([&after] { after = 1; });
+    group.wait();
+    EXPECT_EQ(after.load(), 1);
+}
+
+TEST(XFlow, Bench_submit_allocations)
+{
+    // Frame-shaped load: kTilesPerFrame tiny tasks per frame, wait, repeat.
+    const int             kTilesPerFrame = 1000;
+    const int             kFrames        = 20;
+    const int             kTasks         = kTilesPerFrame * kFrames;
+    au::flow::XThreadpool pool(4);
+    std::atomic<int>      done{0};
+    int                   payload[8] = {1, 2, 3, 4, 5, 6, 7, 8};  // 32-byte capture stays inline
+
+    auto submitFrames = [&](int frames) {
+        for (int f = 0; f < frames; ++f) {
+            done.store(0);
+            for (int i = 0; i < kTilesPerFrame; ++i) {
+                pool.submit([&done, payload] { done.fetch_add(payload[0], std::memory_order_relaxed); });
+            }
+            while (done.load(std::memory_order_relaxed) < kTilesPerFrame) std::this_thread::yield();
+        }
+    };
+    auto enqueueFrames = [&](int frames) {
+        std::vector<std::future<void>> futures;
+        futures.reserve(kTilesPerFrame);
+        for (int f = 0; f < frames; ++f) {
+            for (int i = 0; i < kTilesPerFrame; ++i) futures.push_back(pool.enqueue([] {}));
+            for (auto& fut : futures) fut.get();
+            futures.clear();
+        }
+    };
+
+    submitFrames(5);  // warm the block pools and inbox rings
+    size_t allocsBefore = au::flow::detail::poolHeapFallbacks().load();
+    auto   begin        = std::chrono::steady_clock::now();
+    submitFrames(kFrames);
+    auto   end          = std::chrono::steady_clock::now();
+    size_t submitAllocs = au::flow::detail::poolHeapFallbacks().load() - allocsBefore;
+    double submitNs     = std::chrono::duration<double, std::nano>(end - begin).count() / kTasks;
+
+    enqueueFrames(5);
+    allocsBefore = au::flow::detail::poolHeapFallbacks().load();
+    begin        = std::chrono::steady_clock::now();
+    enqueueFrames(kFrames);
+    end                  = std::chrono::steady_clock::now();
+    size_t enqueueAllocs = au::flow::detail::poolHeapFallbacks().load() - allocsBefore;
+    double enqueueNs     = std::chrono::duration<double, std::nano>(end - begin).count() / kTasks;
+
+    printf("[  BENCH   ] submit : %.4f heap fallbacks/task %8.1f ns/task\n", double(submitAllocs) / kTasks, submitNs);
+    printf("[  BENCH   ] enqueue: %.4f heap fallbacks/task %8.1f ns/task\n", double(enqueueAllocs) / kTasks, enqueueNs);
+    EXPECT_LT(double(submitAllocs) / kTasks, 0.01);
+}
+
+// ============================================================================
+// parallelFor
+// ============================================================================
+
+namespace {
+
+/// Busy work whose cost grows with @p units (kept opaque to the optimiser).
+inline uint64_t spinWork(size_t units)
+{
+    volatile uint64_t acc = 0;
+    for (size_t i = 0; i < units * 64; ++i) acc = acc + i;
+    return acc;
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, ParallelFor_visits_every_index_once)
+{
+    au::flow::XThreadpool          pool(4);
+    const size_t                   N = 10000;
+    std::vector<std::atomic<int>>  hits(N);
+    int ret = au::flow::parallelFor(pool, 0, N, [&hits](size_t start, size_t count) {
+        for (size_t i = start; i < start + count; ++i) hits[i].fetch_add(1, std::memory_order_relaxed);
+    });
+    EXPECT_EQ(ret, 0);
+    for (size_t i = 0; i < N; ++i) ASSERT_EQ(hits[i].load(), 1) << "index " << i;
+}
+
+TEST(XFlow, ParallelFor_subrange_and_empty)
+{
+    au::flow::XThreadpool pool(2);
+    std::atomic<size_t>   sum{0};
+    EXPECT_EQ(au::flow::parallelFor(pool, 10, 20, [&sum](size_t s, size_t c) {
+        for (size_t i = s; i < s + c; ++i) sum.fetch_add(i);
+    }), 0);
+    EXPECT_EQ(sum.load(), 145u);
+    EXPECT_EQ(au::flow::parallelFor(pool, 5, 5, [](size_t, size_t) { FAIL(); }), 0);
+    EXPECT_NE(au::flow::parallelFor(pool, 6, 5, [](size_t, size_t) {}), 0);
+}
+
+TEST(XFlow, ParallelFor_caller_runs_everything_without_workers)
+{
+    au::flow::XThreadpool pool(0);
+    const auto            caller = std::this_thread::get_id();
+    std::atomic<int>      foreign{0};
+    size_t                total = 0;
+    au::flow::parallelFor(pool, 0, 1000, [&](size_t, size_t c) {
+        if (std::this_thread::get_id() != caller) foreign++;
+        total += c;
+    });
+    EXPECT_EQ(total, 1000u);
+    EXPECT_EQ(foreign.load(), 0);
+}
+
+TEST(XFlow, ParallelFor_variable_cost_rows)
+{
+    // Rows near the bottom are 50x more expensive, like a frame with a busy region.
+    au::flow::XThreadpool pool(4);
+    const size_t          kRows = 2000;
+    std::atomic<size_t>   rows{0};
+    au::flow::parallelFor(pool, 0, kRows, [&rows, kRows](size_t s, size_t c) {
+        for (size_t y = s; y < s + c; ++y) spinWork(y > kRows * 3 / 4 ? 50 : 1);
+        rows.fetch_add(c, std::memory_order_relaxed);
+    });
+    EXPECT_EQ(rows.load(), kRows);
+}
+
+TEST(XFlow, ParallelFor_exception_propagates_after_join)
+{
+    au::flow::XThreadpool         pool(4);
+    au::flow::XParallelForOptions opt;
+    opt.maxGrain = 8;
+
+    // Thrown from the far end of the range, usually inside a split-off half.
+    std::atomic<size_t> visited{0};
+    EXPECT_THROW(au::flow::parallelFor(pool, 0, 100000, [&](size_t s, size_t c) {
+        spinWork(1);
+        visited.fetch_add(c, std::memory_order_relaxed);
+        if (s + c > 90000) throw std::runtime_error("far chunk");
+    }, opt),
+                 std::runtime_error);
+    EXPECT_LT(visited.load(), 100000u);
+
+    // Thrown on the calling thread while halves may still be running: the
+    // loop must still be joined before its state goes away.
+    std::atomic<int> running{0};
+    EXPECT_THROW(au::flow::parallelFor(pool, 0, 100000, [&](size_t s, size_t) {
+        running++;
+        spinWork(5);
+        running--;
+        if (s == 0) throw std::runtime_error("first chunk");
+    }, opt),
+                 std::runtime_error);
+    EXPECT_EQ(running.load(), 0);
+
+    std::atomic<size_t> all{0};
+    EXPECT_EQ(au::flow::parallelFor(pool, 0, 1000, [&](size_t, size_t c) { all += c; }), 0);
+    EXPECT_EQ(all.load(), 1000u);
+}
+
+// ============================================================================
+// Nested parallelism (help-while-wait)
+// ============================================================================
+
+TEST(XFlow, Nested_parallelFor_three_levels_stress)
+{
+    const size_t kOuter = 8, kMid = 8, kInner = 32;
+    for (size_t threads : {size_t(1), size_t(2), size_t(4), size_t(8)}) {
+        au::flow::XThreadpool pool(threads);
+        for (int round = 0; round < 5; ++round) {
+            std::atomic<size_t> leaves{0};
+            au::flow::parallelFor(pool, 0, kOuter, [&](size_t, size_t oc) {
+                for (size_t o = 0; o < oc; ++o) {
+                    au::flow::parallelFor(pool, 0, kMid, [&](size_t, size_t mc) {
+                        for (size_t m = 0; m < mc; ++m) {
+                            au::flow::parallelFor(pool, 0, kInner, [&](size_t, size_t ic) {
+                                leaves.fetch_add(ic, std::memory_order_relaxed);
+                            });
+                        }
+                    });
+                }
+            });
+            ASSERT_EQ(leaves.load(), kOuter * kMid * kInner) << "threads=" << threads << " round=" << round;
+        }
+    }
+}
+
+TEST(XFlow, Nested_task_groups_on_single_worker)
+{
+    // One worker, outer tasks wait on inner groups: only help-while-wait can finish this.
+    au::flow::XThreadpool pool(1);
+    std::atomic<int>      inner{0};
+    au::flow::XTaskGroup  outer(pool);
+    for (int i = 0; i < 4; ++i) {
+        outer.run([&pool, &inner] {
+            au::flow::XTaskGroup group(pool);
+            for (int j = 0; j < 16; ++j) group.run([&inner] { inner.fetch_add(1); });
+            group.wait();
+        });
+    }
+    outer.wait();
+    EXPECT_EQ(inner.load(), 64);
+}
+
+// ============================================================================
+// Worker placement
+// ============================================================================
+
+TEST(XFlow, Threadpool_options_name_and_pin_workers)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads    = 2;
+    opt.pinWorkers = true;
+    opt.name       = "pinned";
+    au::flow::XThreadpool pool(opt);
+
+    auto probe = [] {
+        std::string name(32, '\0');
+#ifdef __linux__
+        pthread_getname_np(pthread_self(), &name[0], name.size());
+#endif
+        return std::make_pair(std::string(name.c_str()), au::sys::getThreadAffinity());
+    };
+    for (int i = 0; i < 8; ++i) {
+        auto [name, cpus] = pool.enqueue(probe).get();
+#ifdef __linux__
+        EXPECT_EQ(name.rfind("pinned-", 0), 0u) << name;
+        EXPECT_EQ(cpus.size(), 1u);
+#endif
+    }
+}
+
+TEST(XFlow, Threadpool_options_explicit_masks_and_policy)
+{
+    auto allowed = au::sys::getThreadAffinity();
+    au::flow::XThreadpoolOptions opt;
+    opt.threads  = 2;
+    opt.cpuMasks = {allowed};
+    opt.policy   = au::sys::SchedPolicy::Batch;
+    opt.priority = 2;
+    au::flow::XThreadpool pool(opt);
+    EXPECT_EQ(pool.enqueue([] { return au::sys::getThreadAffinity(); }).get(), allowed);
+}
+
+namespace {
+
+struct LatencyStats {
+    double meanUs, stddevUs, p99Us;
+};
+
+/// Submit-to-start latency of one task at a time on @p pool.
+LatencyStats measureDispatchLatency(au::flow::XThreadpool& pool, int samples)
+{
+    std::vector<double> us;
+    us.reserve(samples);
+    for (int i = 0; i < samples; ++i) {
+        std::atomic<int64_t> startNs{0};
+        auto                 t0 = std::chrono::steady_clock::now();
+        pool.submit([&startNs] {
+            startNs = std::chrono::steady_clock::now().time_since_epoch().count();
+        });
+        while (startNs.load() == 0) std::this_thread::yield();
+        us.push_back((startNs.load() - t0.time_since_epoch().count()) / 1000.0);
+    }
+    double mean = 0, var = 0;
+    for (double v : us) mean += v;
+    mean /= us.size();
+    for (double v : us) var += (v - mean) * (v - mean);
+    std::sort(us.begin(), us.end());
+    return {mean, std::sqrt(var / us.size()), us[us.size() * 99 / 100]};
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Bench_pinning_latency_variance)
+{
+    const int kSamples = 2000;
+    for (bool pinned : {false, true}) {
+        au::flow::XThreadpoolOptions opt;
+        opt.threads              = 2;
+        opt.pinWorkers           = pinned;
+        opt.performanceCoresOnly = pinned;
+        au::flow::XThreadpool pool(opt);
+        measureDispatchLatency(pool, 100);  // warm-up
+
+        LatencyStats s = measureDispatchLatency(pool, kSamples);
+        printf("[  BENCH   ] dispatch latency %-9s mean %8.2f us  stddev %8.2f us  p99 %8.2f us\n",
+               pinned ? "pinned" : "unpinned", s.meanUs, s.stddevUs, s.p99Us);
+        EXPECT_GT(s.meanUs, 0.0);
+    }
+}
+
+// ============================================================================
+// Priority lanes
+// ============================================================================
+
+namespace {
+
+/// Occupies the single worker of @p pool until release() is called.
+struct WorkerGate {
+    std::atomic<bool> entered{false}, open{false};
+
+    void block(au::flow::XThreadpool& pool)
+    {
+        pool.submit([this] {
+            entered = true;
+            while (!open.load()) std::this_thread::yield();
+        });
+        while (!entered.load()) std::this_thread::yield();
+    }
+    void release() { open = true; }
+};
+
+}  // anonymous namespace
+
+TEST(XFlow, Priority_lanes_run_high_then_normal_then_background)
+{
+    au::flow::XThreadpool pool(1);
+    WorkerGate            gate;
+    gate.block(pool);
+
+    std::vector<int> order;
+    std::mutex       m;
+    auto             record = [&](int id) {
+        std::lock_guard<std::mutex> lock(m);
+        order.push_back(id);
+    };
+    pool.submit(au::flow::kPriorityBackground, record, 2);
+    pool.submit(record, 1);
+    auto high = pool.enqueue(au::flow::kPriorityHigh, [&] { record(0); return 42; });
+    gate.release();
+
+    EXPECT_EQ(high.get(), 42);
+    while (pool.laneStats(au::flow::kPriorityBackground).tasks == 0) std::this_thread::yield();
+    std::lock_guard<std::mutex> lock(m);
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2}));
+}
+
+TEST(XFlow, Priority_high_burst_yields_to_normal)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads   = 1;
+    opt.highBurst = 4;
+    au::flow::XThreadpool pool(opt);
+    WorkerGate            gate;
+    gate.block(pool);
+
+    std::vector<int>    order;
+    std::atomic<size_t> done{0};
+    for (int i = 0; i < 10; ++i) pool.submit(au::flow::kPriorityHigh, [&, i] { order.push_back(i); done++; });
+    pool.submit([&] { order.push_back(-1); done++; });
+    gate.release();
+    while (done.load() < 11) std::this_thread::yield();
+
+    ASSERT_EQ(order.size(), 11u);
+    EXPECT_EQ(order[4], -1);  // one normal task after four high ones
+}
+
+TEST(XFlow, Priority_background_ages_ahead_of_normal_flood)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads           = 1;
+    opt.backgroundAgingNs = 2000000;  // 2 ms
+    au::flow::XThreadpool pool(opt);
+
+    // A normal-lane flood that keeps re-submitting itself for 200 ms.
+    std::atomic<bool>      backgroundRan{false}, stop{false};
+    std::function<void()>  flood;
+    const auto             deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    std::atomic<int>       live{0};
+    flood = [&] {
+        spinWork(20);
+        if (!stop.load() && std::chrono::steady_clock::now() < deadline) {
+            live++;
+            pool.submit(flood);
+        }
+        live--;
+    };
+    live = 4;
+    for (int i = 0; i < 4; ++i) pool.submit(flood);
+    pool.submit(au::flow::kPriorityBackground, [&] { backgroundRan = true; });
+
+    while (!backgroundRan.load() && std::chrono::steady_clock::now() < deadline) std::this_thread::yield();
+    EXPECT_TRUE(backgroundRan.load());
+    stop = true;
+    while (live.load() > 0) std::this_thread::yield();
+}
+
+TEST(XFlow, Priority_lane_stats_count_and_reset)
+{
+    au::flow::XThreadpool pool(2);
+    std::vector<std::future<void>> fs;
+    for (int i = 0; i < 20; ++i) fs.push_back(pool.enqueue(au::flow::kPriorityHigh, [] {}));
+    for (int i = 0; i < 30; ++i) fs.push_back(pool.enqueue([] {}));
+    for (auto& f : fs) f.get();
+
+    auto high = pool.laneStats(au::flow::kPriorityHigh);
+    EXPECT_EQ(high.tasks, 20u);
+    EXPECT_GE(high.totalDelayNs, high.maxDelayNs);
+    EXPECT_GE(high.meanDelayUs(), 0.0);
+    EXPECT_EQ(pool.laneStats(au::flow::kPriorityNormal).tasks, 30u);
+    EXPECT_EQ(pool.laneStats(au::flow::kPriorityBackground).tasks, 0u);
+
+    pool.resetLaneStats();
+    EXPECT_EQ(pool.laneStats(au::flow::kPriorityHigh).tasks, 0u);
+    EXPECT_EQ(pool.laneStats(au::flow::kPriorityHigh).maxDelayNs, 0u);
+}
+
+TEST(XFlow, Bench_priority_preview_latency_under_analytics_burst)
+{
+    for (auto previewLane : {au::flow::kPriorityNormal, au::flow::kPriorityHigh}) {
+        au::flow::XThreadpool pool(2);
+        std::atomic<int>      analytics{0};
+        for (int i = 0; i < 2000; ++i) {
+            pool.submit(au::flow::kPriorityBackground, [&] {
+                spinWork(100);
+                analytics++;
+            });
+            pool.submit([&] {  // normal-lane analytics as well
+                spinWork(100);
+                analytics++;
+            });
+        }
+        std::vector<std::future<void>> previews;
+        for (int i = 0; i < 20; ++i) {
+            previews.push_back(pool.enqueue(previewLane, [] { spinWork(10); }));
+            std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        for (auto& f : previews) f.get();
+
+        auto s = pool.laneStats(previewLane);
+        printf("[  BENCH   ] preview on %-6s lane: mean delay %9.1f us  max %9.1f us (analytics done %d/4000)\n",
+               previewLane == au::flow::kPriorityHigh ? "high" : "normal", s.meanDelayUs(), s.maxDelayNs / 1e3,
+               analytics.load());
+        if (previewLane == au::flow::kPriorityHigh) {
+            EXPECT_EQ(s.tasks, 20u);
+        }
+        while (analytics.load() < 4000) std::this_thread::yield();
+    }
+}
+
+// ============================================================================
+// XTaskGraph
+// ============================================================================
+
+TEST(XFlow, Graph_linear_chain_runs_in_order)
+{
+    au::flow::XThreadpool pool(4);
+    au::flow::XTaskGraph  graph("camera");
+    std::vector<int>      order;
+    std::mutex            m;
+    auto                  stage = [&](int id) {
+        return [&, id] {
+            std::lock_guard<std::mutex> lock(m);
+            order.push_back(id);
+        };
+    };
+    auto& decode  = graph.emplace("decode", stage(0));
+    auto& denoise = graph.emplace("denoise", stage(1));
+    auto& tonemap = graph.emplace("tonemap", stage(2));
+    auto& encode  = graph.emplace("encode", stage(3));
+    decode.precede(denoise);
+    denoise.precede(tonemap);
+    encode.succeed(tonemap);
+
+    EXPECT_EQ(graph.size(), 4u);
+    EXPECT_EQ(graph.find("tonemap"), &tonemap);
+    EXPECT_EQ(graph.find("missing"), nullptr);
+    EXPECT_EQ(graph.run(pool), 0);
+    EXPECT_EQ(order, (std::vector<int>{0, 1, 2, 3}));
+}
+
+TEST(XFlow, Graph_diamond_joins_after_both_branches)
+{
+    au::flow::XThreadpool pool(4);
+    au::flow::XTaskGraph  graph;
+    std::atomic<int>      left{0}, right{0};
+    std::atomic<bool>     joinSawBoth{false};
+    auto& a = graph.emplace("a", [] {});
+    auto& b = graph.emplace("b", [&] { left = 1; });
+    auto& c = graph.emplace("c", [&] { right = 1; });
+    auto& d = graph.emplace("d", [&] { joinSawBoth = left.load() == 1 && right.load() == 1; });
+    a.precede(b).precede(c);
+    d.succeed(b).succeed(c);
+
+    for (int i = 0; i < 50; ++i) {
+        left = right = 0;
+        joinSawBoth  = false;
+        ASSERT_EQ(graph.run(pool), 0);
+        ASSERT_TRUE(joinSawBoth.load());
+    }
+}
+
+TEST(XFlow, Graph_cycle_is_rejected)
+{
+    au::flow::XThreadpool pool(2);
+    au::flow::XTaskGraph  graph("cyclic");
+    auto& a = graph.emplace("a", [] {});
+    auto& b = graph.emplace("b", [] {});
+    a.precede(b);
+    b.precede(a);
+    EXPECT_EQ(graph.run(pool), err::kErrorStateInvalid);
+    EXPECT_FALSE(graph.isRunning());
+}
+
+TEST(XFlow, Graph_node_exception_aborts_run_and_graph_is_reusable)
+{
+    au::flow::XThreadpool pool(2);
+    au::flow::XTaskGraph  graph;
+    bool                  shouldThrow = true;
+    std::atomic<int>      tail{0};
+    graph.emplace("head", [&] {
+        if (shouldThrow) throw std::runtime_error("bad frame");
+    }).precede(graph.emplace("tail", [&] { tail++; }));
+
+    EXPECT_EQ(graph.run(pool), err::kErrorAborted);
+    EXPECT_EQ(tail.load(), 0);
+    shouldThrow = false;
+    EXPECT_EQ(graph.run(pool), 0);
+    EXPECT_EQ(tail.load(), 1);
+}
+
+TEST(XFlow, Graph_async_run_signals_completion)
+{
+    au::flow::XThreadpool pool(2);
+    au::flow::XTaskGraph  graph;
+    std::atomic<int>      work{0};
+    for (int i = 0; i < 8; ++i) graph.emplace("n" + std::to_string(i), [&] { work++; });
+
+    std::atomic<bool> finished{false};
+    EXPECT_EQ(graph.runAsync(pool, [&] { finished = true; }), 0);
+    while (!finished.load()) std::this_thread::yield();
+    EXPECT_EQ(work.load(), 8);
+    EXPECT_EQ(graph.status(), 0);
+}
+
+TEST(XFlow, Graph_prebuilt_rerun_does_not_allocate)
+{
+    au::flow::XThreadpool pool(4);
+    au::flow::XTaskGraph  graph;
+    std::atomic<int>      hits{0};
+    auto&                 src  = graph.emplace("src", [&] { hits++; });
+    auto&                 sink = graph.emplace("sink", [&] { hits++; });
+    for (int i = 0; i < 16; ++i) {
+        graph.emplace("mid" + std::to_string(i), [&] { hits++; }).succeed(src).precede(sink);
+    }
+
+    for (int i = 0; i < 20; ++i) graph.run(pool);  // warm-up
+    size_t before = au::flow::detail::poolHeapFallbacks().load();
+    for (int i = 0; i < 100; ++i) graph.run(pool);
+    size_t allocs = au::flow::detail::poolHeapFallbacks().load() - before;
+    printf("[  BENCH   ] graph rerun: %.3f heap fallbacks/run\n", allocs / 100.0);
+    EXPECT_EQ(hits.load(), 120 * 18);
+    EXPECT_LT(allocs, 10u);
+}
+
+// ============================================================================
+// Ring queues
+// ============================================================================
+
+namespace {
+
+/// Element without a default constructor that counts live instances.
+struct Tracked {
+    static std::atomic<int> live;
+    int                     value;
+    explicit Tracked(int v) : value(v) { live++; }
+    Tracked(Tracked&& o) noexcept : value(o.value) { live++; }
+    Tracked& operator=(Tracked&& o) noexcept { value = o.value; return *this; }
+    ~Tracked() { live--; }
+};
+std::atomic<int> Tracked::live{0};
+
+}  // anonymous namespace
+
+TEST(XFlow, RingQueue_spsc_fifo_and_full)
+{
+    au::flow::XSpscQueue<int> q(3);
+    EXPECT_EQ(q.capacity(), 4u);
+    for (int i = 0; i < 4; ++i) EXPECT_TRUE(q.tryPush(i));
+    EXPECT_FALSE(q.tryPush(99));
+    EXPECT_EQ(q.sizeApprox(), 4u);
+
+    int v = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(q.tryPop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(q.tryPop(v));
+    EXPECT_TRUE(q.emptyApprox());
+}
+
+TEST(XFlow, RingQueue_mpmc_fifo_and_full)
+{
+    au::flow::XMpmcQueue<int> q(8);
+    for (int i = 0; i < 8; ++i) EXPECT_TRUE(q.tryPush(i));
+    EXPECT_FALSE(q.tryPush(99));
+    int v = -1;
+    for (int i = 0; i < 8; ++i) {
+        ASSERT_TRUE(q.tryPop(v));
+        EXPECT_EQ(v, i);
+    }
+    EXPECT_FALSE(q.tryPop(v));
+}
+
+TEST(XFlow, RingQueue_destroys_leftover_elements)
+{
+    {
+        au::flow::XSpscQueue<Tracked> spsc(4);
+        au::flow::XMpmcQueue<Tracked> mpmc(4);
+        spsc.tryPush(Tracked(1));
+        spsc.tryPush(Tracked(2));
+        mpmc.tryPush(Tracked(3));
+        EXPECT_EQ(Tracked::live.load(), 3);
+    }
+    EXPECT_EQ(Tracked::live.load(), 0);
+}
+
+TEST(XFlow, RingQueue_spsc_concurrent_transfer)
+{
+    au::flow::XSpscQueue<uint64_t> q(64);
+    const uint64_t                 kItems = 200000;
+    std::thread                    producer([&] {
+        for (uint64_t i = 1; i <= kItems; ++i) {
+            while (!q.tryPush(i)) std::this_thread::yield();
+        }
+    });
+    uint64_t expected = 1, v = 0;
+    while (expected <= kItems) {
+        if (q.tryPop(v)) {
+            ASSERT_EQ(v, expected);
+            ++expected;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+}
+
+TEST(XFlow, RingQueue_mpmc_concurrent_sum)
+{
+    au::flow::XMpmcQueue<uint64_t> q(128);
+    const int                      kProducers = 4, kConsumers = 4;
+    const uint64_t                 kPerProducer = 20000;
+    std::atomic<uint64_t>          sum{0}, popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&] {
+            for (uint64_t i = 1; i <= kPerProducer; ++i) {
+                while (!q.tryPush(i)) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&] {
+            uint64_t v = 0;
+            while (popped.load() < kProducers * kPerProducer) {
+                if (q.tryPop(v)) {
+                    sum += v;
+                    popped++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sum.load(), kProducers * kPerProducer * (kPerProducer + 1) / 2);
+}
+
+TEST(XFlow, RingQueue_batch_push_pop)
+{
+    au::flow::XSpscQueue<int> spsc(8);
+    au::flow::XMpmcQueue<int> mpmc(8);
+    std::vector<int>          in(12);
+    std::iota(in.begin(), in.end(), 0);
+
+    EXPECT_EQ(spsc.tryPushBatch(in.begin(), in.size()), 8u);  // prefix up to capacity
+    EXPECT_EQ(mpmc.tryPushBatch(in.begin(), in.size()), 8u);
+    EXPECT_EQ(spsc.tryPushBatch(in.begin(), 1), 0u);
+    EXPECT_EQ(mpmc.tryPushBatch(in.begin(), 1), 0u);
+
+    int out[8] = {};
+    EXPECT_EQ(spsc.tryPopBatch(out, 5), 5u);
+    EXPECT_EQ(out[4], 4);
+    EXPECT_EQ(spsc.tryPushBatch(in.begin() + 8, 4), 4u);  // wraps around
+    std::vector<int> rest;
+    EXPECT_EQ(spsc.tryPopBatch(std::back_inserter(rest), 100), 7u);
+    EXPECT_EQ(rest, (std::vector<int>{5, 6, 7, 8, 9, 10, 11}));
+
+    EXPECT_EQ(mpmc.tryPopBatch(out, 8), 8u);
+    for (int i = 0; i < 8; ++i) EXPECT_EQ(out[i], i);
+    EXPECT_EQ(mpmc.tryPopBatch(out, 8), 0u);
+    EXPECT_EQ(mpmc.tryPushBatch(in.begin(), 0), 0u);
+}
+
+TEST(XFlow, RingQueue_batch_moves_and_destroys)
+{
+    {
+        au::flow::XMpmcQueue<Tracked> q(4);
+        std::vector<Tracked>          in;
+        for (int i = 0; i < 3; ++i) in.emplace_back(i);
+        EXPECT_EQ(q.tryPushBatch(std::make_move_iterator(in.begin()), in.size()), 3u);
+        in.clear();
+        EXPECT_EQ(Tracked::live.load(), 3);
+
+        std::vector<Tracked> out;
+        out.reserve(4);
+        auto sink = std::back_inserter(out);
+        EXPECT_EQ(q.tryPopBatch(sink, 2), 2u);
+        EXPECT_EQ(out[1].value, 1);
+        EXPECT_EQ(Tracked::live.load(), 3);  // two in `out`, one queued
+    }
+    EXPECT_EQ(Tracked::live.load(), 0);
+}
+
+TEST(XFlow, RingQueue_blocking_and_timed)
+{
+    au::flow::XMpmcQueue<int> q(2);
+    int                       v = 0;
+    EXPECT_FALSE(q.popFor(v, std::chrono::milliseconds(2)));
+    q.push(1);
+    q.push(2);
+    EXPECT_FALSE(q.pushFor(3, std::chrono::milliseconds(2)));
+
+    std::thread consumer([&] {
+        int x = 0;
+        q.pop(x);
+        EXPECT_EQ(x, 1);
+        q.spinPop(x);
+        EXPECT_EQ(x, 2);
+    });
+    q.push(3);  // blocks until the consumer frees a cell
+    consumer.join();
+    EXPECT_TRUE(q.popFor(v, std::chrono::milliseconds(100)));
+    EXPECT_EQ(v, 3);
+
+    au::flow::XSpscQueue<int> spsc(2);
+    std::thread               producer([&] {
+        for (int i = 0; i < 1000; ++i) spsc.push(i);
+    });
+    for (int i = 0; i < 1000; ++i) {
+        spsc.pop(v);
+        ASSERT_EQ(v, i);
+    }
+    producer.join();
+}
+
+TEST(XFlow, RingQueue_mpmc_concurrent_batches)
+{
+    au::flow::XMpmcQueue<uint64_t> q(64);
+    const int                      kProducers = 3, kConsumers = 3;
+    const uint64_t                 kPerProducer = 30000;
+    std::atomic<uint64_t>          sum{0}, popped{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; ++p) {
+        threads.emplace_back([&] {
+            uint64_t batch[7];
+            for (uint64_t next = 1; next <= kPerProducer;) {
+                size_t n = 0;
+                for (; n < 7 && next + n <= kPerProducer; ++n) batch[n] = next + n;
+                size_t pushed = q.tryPushBatch(batch, n);
+                next += pushed;
+                if (pushed == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (int c = 0; c < kConsumers; ++c) {
+        threads.emplace_back([&] {
+            uint64_t batch[5];
+            while (popped.load() < kProducers * kPerProducer) {
+                size_t n = q.tryPopBatch(batch, 5);
+                for (size_t i = 0; i < n; ++i) sum += batch[i];
+                popped += n;
+                if (n == 0) std::this_thread::yield();
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(sum.load(), kProducers * kPerProducer * (kPerProducer + 1) / 2);
+}
+
+namespace {
+
+/// std::queue + mutex + condition variable: the pattern the rings replace.
+class LockedQueue {
+public:
+    void push(uint64_t v)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mQueue.push(v);
+        }
+        mReady.notify_one();
+    }
+    void pop(uint64_t& v)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        mReady.wait(lock, [this] { return !mQueue.empty(); });
+        v = mQueue.front();
+        mQueue.pop();
+    }
+
+private:
+    std::mutex              mMutex;
+    std::condition_variable mReady;
+    std::queue<uint64_t>    mQueue;
+};
+
+/// Millions of items per second moved by @p producers threads calling
+/// produce(count) and @p consumers threads calling consume(count).
+template <class Produce, class Consume>
+double ringThroughput(int producers, int consumers, size_t items, Produce produce, Consume consume)
+{
+    std::vector<std::thread> threads;
+    auto                     t0 = std::chrono::steady_clock::now();
+    for (int p = 0; p < producers; ++p) threads.emplace_back([&] { produce(items / producers); });
+    for (int c = 0; c < consumers; ++c) threads.emplace_back([&] { consume(items / consumers); });
+    for (auto& t : threads) t.join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return items / s / 1e6;
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Bench_ring_queue_throughput)
+{
+    constexpr size_t kItems = 1 << 18;
+    constexpr size_t kBatch = 32;
+    struct Shape {
+        const char* name;
+        int         producers, consumers;
+    };
+    for (Shape shape : {Shape{"1P1C", 1, 1}, Shape{"4P4C", 4, 4}, Shape{"8P1C", 8, 1}}) {
+        const int P = shape.producers, C = shape.consumers;
+        std::atomic<uint64_t> checksum{0};
+        auto                  keep = [&](uint64_t local) { checksum += local; };
+
+        LockedQueue locked;
+        double      lockedRate = ringThroughput(
+            P, C, kItems, [&](size_t n) { for (size_t i = 0; i < n; ++i) locked.push(i); },
+            [&](size_t n) {
+                uint64_t v = 0, local = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    locked.pop(v);
+                    local += v;
+                }
+                keep(local);
+            });
+
+        au::flow::XMpmcQueue<uint64_t> mpmc(1024);
+        double                         mpmcRate = ringThroughput(
+            P, C, kItems, [&](size_t n) { for (size_t i = 0; i < n; ++i) mpmc.push(i); },
+            [&](size_t n) {
+                uint64_t v = 0, local = 0;
+                for (size_t i = 0; i < n; ++i) {
+                    mpmc.pop(v);
+                    local += v;
+                }
+                keep(local);
+            });
+
+        au::flow::XMpmcQueue<uint64_t> batched(1024);
+        double                         batchRate = ringThroughput(
+            P, C, kItems,
+            [&](size_t n) {
+                uint64_t buf[kBatch];
+                for (size_t done = 0; done < n;) {
+                    size_t k = std::min(kBatch, n - done);
+                    for (size_t i = 0; i < k; ++i) buf[i] = done + i;
+                    au::flow::detail::XBackoff backoff;
+                    for (size_t sent = 0; sent < k;) {
+                        size_t m = batched.tryPushBatch(buf + sent, k - sent);
+                        if (m == 0) backoff.pause();
+                        sent += m;
+                    }
+                    done += k;
+                }
+            },
+            [&](size_t n) {
+                uint64_t buf[kBatch], local = 0;
+                au::flow::detail::XBackoff backoff;
+                for (size_t got = 0; got < n;) {
+                    size_t m = batched.tryPopBatch(buf, std::min(kBatch, n - got));
+                    if (m == 0) {
+                        backoff.pause();
+                        continue;
+                    }
+                    for (size_t i = 0; i < m; ++i) local += buf[i];
+                    got += m;
+                    backoff = {};
+                }
+                keep(local);
+            });
+
+        printf("[  BENCH   ] ring %s  mutex+queue %7.2f  mpmc %7.2f  mpmc batch%zu %7.2f Mitems/s\n", shape.name,
+               lockedRate, mpmcRate, kBatch, batchRate);
+
+        if (P == 1 && C == 1) {
+            au::flow::XSpscQueue<uint64_t> spsc(1024);
+            double                         spscRate = ringThroughput(
+                1, 1, kItems, [&](size_t n) { for (size_t i = 0; i < n; ++i) spsc.push(i); },
+                [&](size_t n) {
+                    uint64_t v = 0, local = 0;
+                    for (size_t i = 0; i < n; ++i) {
+                        spsc.pop(v);
+                        local += v;
+                    }
+                    keep(local);
+                });
+            printf("[  BENCH   ] ring %s  spsc %7.2f Mitems/s\n", shape.name, spscRate);
+        }
+
+        const uint64_t perProducer = kItems / P;
+        const uint64_t variants    = (P == 1 && C == 1) ? 4 : 3;
+        EXPECT_EQ(checksum.load(), variants * P * (perProducer * (perProducer - 1) / 2));
+    }
+}
+
+// ============================================================================
+// Streaming pipeline
+// ============================================================================
+
+TEST(XFlow, Pipeline_typed_stages)
+{
+    au::flow::XThreadpool    pool(2);
+    std::vector<std::string> out;
+    auto pipe = au::flow::makePipeline<int>(pool)
+                    .serial("format", [](int v) { return std::to_string(v); })
+                    .parallel("suffix", [](std::string s) { return s + "!"; })
+                    .serial("collect", [&out](std::string s) { out.push_back(std::move(s)); })
+                    .build();
+    EXPECT_EQ(pipe.numStages(), 3u);
+    for (int i = 0; i < 5; ++i) EXPECT_EQ(pipe.push(i), 0);
+    pipe.wait();
+    EXPECT_EQ(out, (std::vector<std::string>{"0!", "1!", "2!", "3!", "4!"}));
+}
+
+TEST(XFlow, Pipeline_serial_stage_restores_order_after_parallel)
+{
+    au::flow::XThreadpool pool(4);
+    std::vector<int>      order;
+    auto pipe = au::flow::makePipeline<int>(pool, {8})
+                    .serial("decode", [](int v) { return v; })
+                    .parallel("denoise", [](int v) {
+                        spinWork(size_t((v * 7919) % 13) * 20);  // uneven per-frame cost
+                        return v;
+                    })
+                    .serial("encode", [&order](int v) { order.push_back(v); })
+                    .build();
+
+    const int kFrames = 500;
+    for (int i = 0; i < kFrames; ++i) pipe.push(i);
+    pipe.wait();
+    ASSERT_EQ(order.size(), size_t(kFrames));
+    for (int i = 0; i < kFrames; ++i) ASSERT_EQ(order[i], i);
+}
+
+TEST(XFlow, Pipeline_backpressure_bounds_frames_in_flight)
+{
+    au::flow::XThreadpool pool(4);
+    std::atomic<int>      live{0}, peak{0};
+    auto pipe = au::flow::makePipeline<int>(pool, {3})
+                    .parallel("source", [&](int v) {
+                        int now = ++live;
+                        int p   = peak.load();
+                        while (now > p && !peak.compare_exchange_weak(p, now)) {}
+                        return v;
+                    })
+                    .serial("slow_sink", [&](int) {
+                        std::this_thread::sleep_for(std::chrono::microseconds(200));
+                        live--;
+                    })
+                    .build();
+
+    for (int i = 0; i < 100; ++i) pipe.push(i);
+    EXPECT_LE(pipe.inFlight(), 3u);
+    pipe.wait();
+    EXPECT_LE(peak.load(), 3);
+    EXPECT_EQ(pipe.inFlight(), 0u);
+
+    auto stats = pipe.stats();
+    EXPECT_EQ(stats.pushed, 100u);
+    EXPECT_EQ(stats.completed, 100u);
+    ASSERT_EQ(stats.stages.size(), 2u);
+    EXPECT_EQ(stats.stages[0].name, "source");
+    EXPECT_EQ(stats.stages[0].mode, au::flow::kStageParallel);
+    EXPECT_EQ(stats.stages[1].processed, 100u);
+    EXPECT_EQ(stats.stages[1].queueDepth, 0u);
+    EXPECT_LE(stats.stages[1].peakQueueDepth, 3u);
+    EXPECT_GT(stats.stages[1].busyNs, 100u * 200000u / 2);
+    EXPECT_GT(stats.stages[1].throughput, 0.0);
+}
+
+TEST(XFlow, Pipeline_tryPush_reports_busy_when_full)
+{
+    au::flow::XThreadpool pool(2);
+    std::atomic<bool>     release{false};
+    auto pipe = au::flow::makePipeline<int>(pool, {1})
+                    .serial("gate", [&](int) {
+                        while (!release.load()) std::this_thread::yield();
+                    })
+                    .build();
+
+    int frame = 7;
+    EXPECT_EQ(pipe.tryPush(frame), 0);
+    EXPECT_EQ(pipe.tryPush(frame), err::kErrorBusy);
+    release = true;
+    pipe.wait();
+    EXPECT_EQ(pipe.tryPush(frame), 0);
+}
+
+TEST(XFlow, Pipeline_stage_exception_drops_only_that_frame)
+{
+    au::flow::XThreadpool pool(2);
+    std::vector<int>      seen;
+    auto pipe = au::flow::makePipeline<int>(pool, {4})
+                    .parallel("check", [](int v) {
+                        if (v == 3) throw std::runtime_error("corrupt frame");
+                        return v;
+                    })
+                    .serial("sink", [&seen](int v) { seen.push_back(v); })
+                    .build();
+
+    for (int i = 0; i < 8; ++i) pipe.push(i);
+    pipe.wait();
+    EXPECT_EQ(seen, (std::vector<int>{0, 1, 2, 4, 5, 6, 7}));
+    auto stats = pipe.stats();
+    EXPECT_EQ(stats.completed, 8u);
+    EXPECT_EQ(stats.stages[0].failed, 1u);
+    EXPECT_EQ(stats.stages[1].processed, 7u);
+}
+
+TEST(XFlow, Pipeline_concurrent_producers)
+{
+    au::flow::XThreadpool pool(2);
+    std::atomic<int>      sum{0};
+    {
+        auto pipe = au::flow::makePipeline<int>(pool, {4})
+                        .serial("sum", [&sum](int v) { sum += v; })
+                        .build();
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; ++p) {
+            producers.emplace_back([&pipe] {
+                for (int i = 1; i <= 250; ++i) pipe.push(i);
+            });
+        }
+        for (auto& t : producers) t.join();
+    }  // destructor drains
+    EXPECT_EQ(sum.load(), 4 * 250 * 251 / 2);
+}
+
+TEST(XFlow, Bench_pipeline_overlap)
+{
+    const int    kFrames = 200;
+    const size_t kCost   = 200;  // per stage
+    auto         stage   = [kCost](int v) {
+        spinWork(kCost);
+        return v;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kFrames; ++i) stage(stage(stage(i)));
+    auto sequentialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    au::flow::XThreadpool pool(3);
+    std::atomic<int>      done{0};
+    auto pipe = au::flow::makePipeline<int>(pool, {6})
+                    .serial("decode", stage)
+                    .parallel("filter", stage)
+                    .serial("encode", [&](int v) {
+                        stage(v);
+                        done++;
+                    })
+                    .build();
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kFrames; ++i) pipe.push(i);
+    pipe.wait();
+    auto pipelineMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    printf("[  BENCH   ] %d frames x 3 stages: sequential %.3f ms, pipeline %.3f ms\n", kFrames, sequentialMs,
+           pipelineMs);
+    for (const auto& s : pipe.stats().stages) {
+        printf("[  BENCH   ]   %-8s processed=%llu busy=%.3f ms peakDepth=%zu\n", s.name.c_str(),
+               static_cast<unsigned long long>(s.processed), s.busyNs / 1e6, s.peakQueueDepth);
+    }
+    EXPECT_EQ(done.load(), kFrames);
+}
+
+// ============================================================================
+// Cancellation
+// ============================================================================
+
+TEST(XFlow, Cancel_token_states)
+{
+    au::flow::XCancelToken inert;
+    EXPECT_FALSE(inert.canBeCancelled());
+    EXPECT_FALSE(inert.isCancelled());
+
+    au::flow::XCancelSource source;
+    auto                    token = source.token();
+    EXPECT_TRUE(token.canBeCancelled());
+    EXPECT_FALSE(token.isCancelled());
+    source.cancel();
+    source.cancel();
+    EXPECT_TRUE(source.isCancelled());
+    EXPECT_TRUE(token.isCancelled());
+}
+
+TEST(XFlow, Cancel_enqueue_discards_queued_tasks)
+{
+    au::flow::XThreadpool pool(1);
+    WorkerGate            gate;
+    gate.block(pool);
+
+    au::flow::XCancelSource       frame;
+    std::atomic<int>              ran{0};
+    std::vector<std::future<int>> tiles;
+    for (int i = 0; i < 8; ++i) tiles.push_back(pool.enqueue(frame.token(), [&ran] { ran++; }));
+    auto kept = pool.enqueue(au::flow::kPriorityHigh, au::flow::XCancelToken{}, [](int x) { return x; }, 5);
+    frame.cancel();
+    gate.release();
+
+    for (auto& f : tiles) EXPECT_EQ(f.get(), err::kErrorAborted);
+    EXPECT_EQ(kept.get(), 5);
+    EXPECT_EQ(ran.load(), 0);
+}
+
+TEST(XFlow, Cancel_running_task_polls_token)
+{
+    au::flow::XThreadpool   pool(1);
+    au::flow::XCancelSource source;
+    std::atomic<bool>       started{false};
+    auto                    token = source.token();
+    auto fut = pool.enqueue(token, [&started, token] {
+        started = true;
+        while (!token.isCancelled()) std::this_thread::yield();
+        return static_cast<int>(err::kErrorAborted);
+    });
+    while (!started.load()) std::this_thread::yield();
+    source.cancel();
+    EXPECT_EQ(fut.get(), err::kErrorAborted);
+
+    au::flow::XCancelSource idle;
+    EXPECT_EQ(pool.enqueue(idle.token(), [] {}).get(), 0);
+}
+
+TEST(XFlow, Cancel_parallelFor_skips_remaining_chunks)
+{
+    au::flow::XThreadpool      pool(2);
+    au::flow::XCancelSource    source;
+    au::flow::XParallelForOptions opt;
+    opt.cancel   = source.token();
+    opt.maxGrain = 4;
+
+    std::atomic<size_t> visited{0};
+    const int           ret = au::flow::parallelFor(pool, 0, 10000, [&](size_t, size_t count) {
+        if (visited.fetch_add(count) + count >= 64) source.cancel();
+    }, opt);
+    EXPECT_EQ(ret, err::kErrorAborted);
+    EXPECT_LT(visited.load(), 10000u);
+
+    std::atomic<size_t> all{0};
+    opt.cancel = au::flow::XCancelSource().token();
+    EXPECT_EQ(au::flow::parallelFor(pool, 0, 1000, [&](size_t, size_t count) { all += count; }, opt), 0);
+    EXPECT_EQ(all.load(), 1000u);
+}
+
+TEST(XFlow, Cancel_pipeline_skips_cancelled_frames)
+{
+    au::flow::XThreadpool pool(2);
+    std::atomic<bool>     release{false};
+    std::vector<int>      seen;
+    auto pipe = au::flow::makePipeline<int>(pool, {4})
+                    .serial("gate", [&](int v) {
+                        while (!release.load()) std::this_thread::yield();
+                        return v;
+                    })
+                    .parallel("filter", [](int v) { return v * 10; })
+                    .serial("sink", [&seen](int v) { seen.push_back(v); })
+                    .build();
+
+    au::flow::XCancelSource live, dropped, stale;
+    stale.cancel();
+    EXPECT_EQ(pipe.push(0, live.token()), 0);      // already inside "gate"
+    EXPECT_EQ(pipe.push(1, dropped.token()), 0);
+    EXPECT_EQ(pipe.push(2), 0);
+    EXPECT_EQ(pipe.push(3, stale.token()), err::kErrorAborted);
+    dropped.cancel();
+    release = true;
+    pipe.wait();
+
+    EXPECT_EQ(seen, (std::vector<int>{0, 20}));
+    auto stats = pipe.stats();
+    EXPECT_EQ(stats.pushed, 3u);
+    EXPECT_EQ(stats.completed, 3u);
+    EXPECT_EQ(stats.stages[0].cancelled + stats.stages[1].cancelled, 1u);
+    EXPECT_EQ(stats.stages[2].processed, 2u);
+}
+
+TEST(XFlow, Bench_cancel_frame_drop_saves_cpu)
+{
+    // Frames of 32 tiles arrive faster than one frame takes; every frame
+    // except the newest is dropped as soon as its successor arrives.
+    const int    kFrames = 20;
+    const int    kTiles  = 32;
+    const size_t kCost   = 500;
+
+    auto run = [&](bool useCancel, double& ms) {
+        au::flow::XThreadpool pool(2);
+        std::atomic<int>      executed{0};
+        std::vector<std::unique_ptr<au::flow::XCancelSource>> frames;
+        std::vector<std::future<int>>                         futures;
+
+        const auto t0 = std::chrono::steady_clock::now();
+        for (int f = 0; f < kFrames; ++f) {
+            if (!frames.empty()) frames.back()->cancel();
+            frames.push_back(std::make_unique<au::flow::XCancelSource>());
+            const au::flow::XCancelToken token = useCancel ? frames.back()->token() : au::flow::XCancelToken{};
+            for (int t = 0; t < kTiles; ++t) {
+                futures.push_back(pool.enqueue(token, [&executed, kCost] {
+                    spinWork(kCost);
+                    executed++;
+                }));
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        for (auto& fut : futures) fut.get();
+        ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+        return executed.load();
+    };
+
+    double     plainMs = 0, cancelMs = 0;
+    const int  plain   = run(false, plainMs);
+    const int  kept    = run(true, cancelMs);
+    printf("[  BENCH   ] %d frames x %d tiles, drop on arrival: without tokens %d tiles %.3f ms, "
+           "with tokens %d tiles %.3f ms\n",
+           kFrames, kTiles, plain, plainMs, kept, cancelMs);
+    EXPECT_EQ(plain, kFrames * kTiles);
+    EXPECT_GE(kept, kTiles);  // the last frame is never dropped
+    EXPECT_LE(kept, plain);
+}
+
+// ============================================================================
+// Resizing and idle policy
+// ============================================================================
+
+namespace {
+
+/// Polls @p pred for up to two seconds.
+template <class Pred>
+bool eventually(Pred pred)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!pred()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Threadpool_resize_grow_and_shrink)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads    = 1;
+    opt.maxThreads = 4;
+    au::flow::XThreadpool pool(opt);
+    EXPECT_EQ(pool.size(), 1u);
+    EXPECT_EQ(pool.maxThreads(), 4u);
+    EXPECT_EQ(pool.resize(5), err::kErrorInvalidParam);
+
+    // Four tasks that only finish once all four run at the same time.
+    EXPECT_EQ(pool.resize(4), 0);
+    EXPECT_EQ(pool.size(), 4u);
+    std::atomic<int>              arrived{0};
+    std::vector<std::future<int>> futs;
+    for (int i = 0; i < 4; ++i) {
+        futs.push_back(pool.enqueue([&arrived, i] {
+            arrived++;
+            while (arrived.load() < 4) std::this_thread::yield();
+            return i;
+        }));
+    }
+    for (int i = 0; i < 4; ++i) EXPECT_EQ(futs[i].get(), i);
+
+    EXPECT_EQ(pool.resize(1), 0);
+    EXPECT_TRUE(eventually([&] { return pool.liveThreads() == 1; }));
+    EXPECT_EQ(pool.enqueue([] { return 7; }).get(), 7);
+}
+
+TEST(XFlow, Threadpool_resize_to_zero_and_back)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads    = 2;
+    opt.maxThreads = 2;
+    au::flow::XThreadpool pool(opt);
+    EXPECT_EQ(pool.resize(0), 0);
+    EXPECT_TRUE(eventually([&] { return pool.liveThreads() == 0; }));
+
+    std::atomic<int> ran{0};
+    for (int i = 0; i < 16; ++i) pool.submit([&ran] { ran++; });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    EXPECT_EQ(ran.load(), 0);
+
+    EXPECT_EQ(pool.resize(2), 0);
+    EXPECT_TRUE(eventually([&] { return ran.load() == 16; }));
+}
+
+TEST(XFlow, Threadpool_shrink_under_load_keeps_every_task)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads = 4;
+    au::flow::XThreadpool pool(opt);
+    std::atomic<int>      ran{0};
+    {
+        au::flow::XTaskGroup group(pool);
+        for (int i = 0; i < 2000; ++i) {
+            group.run([&ran] {
+                spinWork(20);
+                ran++;
+            });
+            if (i == 500) pool.resize(1);
+            if (i == 1500) pool.resize(3);
+        }
+    }
+    EXPECT_EQ(ran.load(), 2000);
+}
+
+TEST(XFlow, Threadpool_resize_from_pool_task)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads    = 1;
+    opt.maxThreads = 3;
+    au::flow::XThreadpool pool(opt);
+    EXPECT_EQ(pool.enqueue([&pool] { return pool.resize(3); }).get(), 0);
+    EXPECT_EQ(pool.size(), 3u);
+    EXPECT_EQ(pool.enqueue([&pool] { return pool.resize(1); }).get(), 0);
+    EXPECT_TRUE(eventually([&] { return pool.liveThreads() == 1; }));
+}
+
+TEST(XFlow, Threadpool_idle_timeout_retires_and_restarts_workers)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads       = 2;
+    opt.spinNs        = 0;
+    opt.idleTimeoutNs = 2000000;  // 2 ms
+    au::flow::XThreadpool pool(opt);
+
+    EXPECT_TRUE(eventually([&] { return pool.liveThreads() == 0; }));
+    EXPECT_EQ(pool.size(), 2u);
+    EXPECT_EQ(pool.enqueue([](int x) { return x * 2; }, 21).get(), 42);
+    EXPECT_GE(pool.liveThreads(), 1u);
+
+    std::atomic<int> ran{0};
+    {
+        au::flow::XTaskGroup group(pool);
+        for (int i = 0; i < 100; ++i) group.run([&ran] { ran++; });
+    }
+    EXPECT_EQ(ran.load(), 100);
+}
+
+TEST(XFlow, Bench_spin_then_block_burst_latency)
+{
+    // Single-task bursts separated by short gaps: with spinning the idle
+    // worker is still polling when the next burst starts.
+    const int kSamples = 300;
+    for (uint64_t spinNs : {uint64_t(0), uint64_t(1000000)}) {
+        au::flow::XThreadpoolOptions opt;
+        opt.threads = 1;
+        opt.spinNs  = spinNs;
+        au::flow::XThreadpool pool(opt);
+
+        std::vector<double> us;
+        us.reserve(kSamples);
+        for (int i = 0; i < kSamples; ++i) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+            std::atomic<int64_t> startNs{0};
+            const auto           t0 = std::chrono::steady_clock::now();
+            pool.submit([&startNs] { startNs = std::chrono::steady_clock::now().time_since_epoch().count(); });
+            while (startNs.load() == 0) std::this_thread::yield();
+            us.push_back((startNs.load() - t0.time_since_epoch().count()) / 1000.0);
+        }
+        std::sort(us.begin(), us.end());
+        printf("[  BENCH   ] burst wake-up spinNs=%-8llu median %8.2f us  p99 %8.2f us\n",
+               static_cast<unsigned long long>(spinNs), us[us.size() / 2], us[us.size() * 99 / 100]);
+        EXPECT_GT(us.back(), 0.0);
+    }
+}
+
+// ============================================================================
+// Parallel algorithms
+// ============================================================================
+
+namespace {
+
+std::vector<int> randomInts(size_t n, uint32_t seed)
+{
+    std::vector<int> v(n);
+    for (auto& x : v) {
+        seed = seed * 1664525u + 1013904223u;
+        x    = static_cast<int>(seed >> 8) % 100000 - 50000;
+    }
+    return v;
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Algorithm_reduce_matches_std)
+{
+    au::flow::XThreadpool pool(3);
+    for (size_t n : {size_t(0), size_t(1), size_t(1000), size_t(100003)}) {
+        const auto v = randomInts(n, 7);
+        EXPECT_EQ(au::flow::parallelReduce(pool, v.begin(), v.end(), int64_t(5), std::plus<>()),
+                  std::accumulate(v.begin(), v.end(), int64_t(5)));
+        EXPECT_EQ(au::flow::parallelTransformReduce(pool, v.begin(), v.end(), int64_t(0), std::plus<>(),
+                                                    [](int x) { return int64_t(x) * x; }),
+                  std::transform_reduce(v.begin(), v.end(), int64_t(0), std::plus<>(),
+                                        [](int x) { return int64_t(x) * x; }));
+    }
+}
+
+TEST(XFlow, Algorithm_reduce_non_commutative_keeps_order)
+{
+    au::flow::XThreadpool pool(4);
+    std::vector<std::string> words;
+    for (int i = 0; i < 5000; ++i) words.push_back(std::to_string(i % 10));
+    au::flow::XParallelAlgorithmOptions opt;
+    opt.minGrain = 16;
+    const std::string joined =
+        au::flow::parallelReduce(pool, words.begin(), words.end(), std::string(">"), std::plus<>(), opt);
+    EXPECT_EQ(joined, std::accumulate(words.begin(), words.end(), std::string(">")));
+}
+
+TEST(XFlow, Algorithm_index_reduce_histogram)
+{
+    au::flow::XThreadpool       pool(3);
+    std::vector<uint8_t>        px(1 << 16);
+    for (size_t i = 0; i < px.size(); ++i) px[i] = static_cast<uint8_t>(i * 31 % 251);
+    using Hist = std::array<uint32_t, 256>;
+
+    const Hist hist = au::flow::parallelReduce(
+        pool, 0, px.size(), Hist{},
+        [&](size_t start, size_t count) {
+            Hist h{};
+            for (size_t i = start; i < start + count; ++i) h[px[i]]++;
+            return h;
+        },
+        [](Hist a, const Hist& b) {
+            for (size_t i = 0; i < a.size(); ++i) a[i] += b[i];
+            return a;
+        });
+    Hist expected{};
+    for (uint8_t p : px) expected[p]++;
+    EXPECT_EQ(hist, expected);
+}
+
+TEST(XFlow, Algorithm_scans_match_std_and_work_in_place)
+{
+    au::flow::XThreadpool pool(3);
+    au::flow::XParallelAlgorithmOptions opt;
+    opt.minGrain = 100;
+    for (size_t n : {size_t(0), size_t(1), size_t(99), size_t(12345)}) {
+        const auto       v = randomInts(n, 11);
+        std::vector<int> expected(n), got(n);
+
+        std::inclusive_scan(v.begin(), v.end(), expected.begin());
+        au::flow::parallelInclusiveScan(pool, v.begin(), v.end(), got.begin(), std::plus<>(), opt);
+        EXPECT_EQ(got, expected);
+
+        std::exclusive_scan(v.begin(), v.end(), expected.begin(), 3);
+        au::flow::parallelExclusiveScan(pool, v.begin(), v.end(), got.begin(), 3, std::plus<>(), opt);
+        EXPECT_EQ(got, expected);
+
+        got = v;
+        au::flow::parallelExclusiveScan(pool, got.begin(), got.end(), got.begin(), 3, std::plus<>(), opt);
+        EXPECT_EQ(got, expected);
+    }
+}
+
+TEST(XFlow, Algorithm_sort_matches_std)
+{
+    for (size_t threads : {size_t(0), size_t(1), size_t(3), size_t(7)}) {
+        au::flow::XThreadpool pool(threads);
+        au::flow::XParallelAlgorithmOptions opt;
+        opt.minGrain = 64;
+        for (size_t n : {size_t(0), size_t(5), size_t(1000), size_t(50001)}) {
+            auto v        = randomInts(n, static_cast<uint32_t>(n + threads));
+            auto expected = v;
+            std::sort(expected.begin(), expected.end(), std::greater<>());
+            au::flow::parallelSort(pool, v.begin(), v.end(), std::greater<>(), opt);
+            EXPECT_EQ(v, expected);
+        }
+    }
+}
+
+TEST(XFlow, Algorithm_sort_move_only_elements)
+{
+    au::flow::XThreadpool pool(2);
+    au::flow::XParallelAlgorithmOptions opt;
+    opt.minGrain = 8;
+    std::vector<std::unique_ptr<int>> v;
+    for (int x : randomInts(1000, 3)) v.push_back(std::make_unique<int>(x));
+    au::flow::parallelSort(pool, v.begin(), v.end(), [](const auto& a, const auto& b) { return *a < *b; }, opt);
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), [](const auto& a, const auto& b) { return *a < *b; }));
+}
+
+namespace {
+
+/// Times @p seq once and @p par on pools of 1..32 threads; prints one BENCH line each.
+template <class Seq, class Par>
+void benchAlgorithm(const char* name, size_t n, Seq&& seq, Par&& par)
+{
+    auto timeMs = [](auto&& fn) {
+        double best = 1e30;
+        for (int rep = 0; rep < 3; ++rep) {
+            const auto t0 = std::chrono::steady_clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        }
+        return best;
+    };
+    const double seqMs = timeMs(seq);
+    printf("[  BENCH   ] %-16s n=%zu std %8.3f ms\n", name, n, seqMs);
+    for (size_t threads : {1, 2, 4, 8, 16, 32}) {
+        au::flow::XThreadpool pool(threads);
+        const double          parMs = timeMs([&] { par(pool); });
+        printf("[  BENCH   ] %-16s n=%zu %2zu threads %8.3f ms (%.2fx)\n", name, n, threads, parMs, seqMs / parMs);
+    }
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Bench_parallelReduce_vs_std)
+{
+    const auto v   = randomInts(1 << 20, 1);
+    int64_t    ref = 0, got = 0;
+    benchAlgorithm(
+        "reduce", v.size(), [&] { ref = std::reduce(v.begin(), v.end(), int64_t(0)); },
+        [&](au::flow::XThreadpool& pool) { got = au::flow::parallelReduce(pool, v.begin(), v.end(), int64_t(0), std::plus<>()); });
+    EXPECT_EQ(got, ref);
+}
+
+TEST(XFlow, Bench_parallelTransformReduce_vs_std)
+{
+    const auto v   = randomInts(1 << 20, 2);
+    auto       sq  = [](int x) { return int64_t(x) * x; };
+    int64_t    ref = 0, got = 0;
+    benchAlgorithm(
+        "transform_reduce", v.size(),
+        [&] { ref = std::transform_reduce(v.begin(), v.end(), int64_t(0), std::plus<>(), sq); },
+        [&](au::flow::XThreadpool& pool) {
+            got = au::flow::parallelTransformReduce(pool, v.begin(), v.end(), int64_t(0), std::plus<>(), sq);
+        });
+    EXPECT_EQ(got, ref);
+}
+
+TEST(XFlow, Bench_parallelScan_vs_std)
+{
+    const auto           v = randomInts(1 << 20, 3);
+    std::vector<int64_t> ref(v.size()), got(v.size());
+    benchAlgorithm(
+        "inclusive_scan", v.size(), [&] { std::inclusive_scan(v.begin(), v.end(), ref.begin(), std::plus<int64_t>()); },
+        [&](au::flow::XThreadpool& pool) {
+            au::flow::parallelInclusiveScan(pool, v.begin(), v.end(), got.begin(), std::plus<int64_t>());
+        });
+    EXPECT_EQ(got, ref);
+    benchAlgorithm(
+        "exclusive_scan", v.size(),
+        [&] { std::exclusive_scan(v.begin(), v.end(), ref.begin(), int64_t(0)); },
+        [&](au::flow::XThreadpool& pool) {
+            au::flow::parallelExclusiveScan(pool, v.begin(), v.end(), got.begin(), int64_t(0));
+        });
+    EXPECT_EQ(got, ref);
+}
+
+TEST(XFlow, Bench_parallelSort_vs_std)
+{
+    const auto       input = randomInts(1 << 18, 4);
+    std::vector<int> ref, got;
+    benchAlgorithm(
+        "sort", input.size(),
+        [&] {
+            ref = input;
+            std::sort(ref.begin(), ref.end());
+        },
+        [&](au::flow::XThreadpool& pool) {
+            got = input;
+            au::flow::parallelSort(pool, got.begin(), got.end());
+        });
+    EXPECT_EQ(got, ref);
+}
+
+// ============================================================================
+// Instrumentation
+// ============================================================================
+
+namespace {
+
+struct CapturingWriter : au::perf::IPerfWriter4 {
+    std::mutex  mutex;
+    std::string text;
+
+    void write(const char* data, size_t size) noexcept override
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        text.append(data, size);
+    }
+};
+
+}  // anonymous namespace
+
+TEST(XFlow, Stats_per_worker_tasks_and_time)
+{
+    au::flow::XThreadpool pool(2);
+    std::vector<std::future<void>> fs;
+    for (int i = 0; i < 200; ++i) fs.push_back(pool.enqueue([] { spinWork(200); }));
+    for (auto& f : fs) f.get();
+
+    auto     stats = pool.stats();
+    uint64_t tasks = 0, busy = 0;
+    ASSERT_EQ(stats.workers.size(), 2u);
+    for (const auto& w : stats.workers) {
+        tasks += w.tasks;
+        busy += w.busyNs;
+        EXPECT_GE(w.totalDelayNs, w.maxDelayNs);
+        EXPECT_GE(w.utilization(), 0.0);
+        EXPECT_LE(w.utilization(), 1.0);
+    }
+    EXPECT_EQ(tasks, 200u);
+    EXPECT_EQ(stats.external.tasks, 0u);
+    EXPECT_GE(stats.peakQueued, 1u);
+    if (au::flow::kThreadpoolStats) {
+        EXPECT_GT(busy, 0u);
+    }
+}
+
+TEST(XFlow, Stats_queue_depth_high_water_mark)
+{
+    if (!au::flow::kThreadpoolStats) GTEST_SKIP() << "compiled out";
+    au::flow::XThreadpool pool(1);
+    WorkerGate            gate;
+    gate.block(pool);
+    std::atomic<int> done{0};
+    for (int i = 0; i < 50; ++i) pool.submit([&] { done++; });
+    gate.release();
+    while (done.load() < 50) std::this_thread::yield();
+
+    auto stats = pool.stats();
+    EXPECT_GE(stats.peakQueued, 50u);
+    EXPECT_GE(stats.workers[0].peakQueueDepth, 50u);
+}
+
+TEST(XFlow, Stats_count_steals)
+{
+    if (!au::flow::kThreadpoolStats) GTEST_SKIP() << "compiled out";
+    au::flow::XThreadpool pool(2);
+    std::atomic<int>      done{0};
+    // Worker A fills its own deque and then waits without helping: only
+    // worker B can run those tasks, and it has to steal each of them.
+    pool.enqueue([&] {
+            for (int i = 0; i < 20; ++i) pool.submit([&] { done++; });
+            while (done.load() < 20) std::this_thread::yield();
+        })
+        .get();
+
+    uint64_t steals = 0;
+    for (const auto& w : pool.stats().workers) steals += w.steals;
+    EXPECT_GE(steals, 20u);
+}
+
+TEST(XFlow, Stats_external_helpers_and_reset)
+{
+    au::flow::XThreadpool pool(0);
+    {
+        au::flow::XTaskGroup group(pool);
+        for (int i = 0; i < 10; ++i) group.run([] { spinWork(10); });
+    }
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.external.tasks, 10u);
+    if (au::flow::kThreadpoolStats) {
+        EXPECT_GT(stats.external.busyNs, 0u);
+    }
+
+    pool.resetStats();
+    stats = pool.stats();
+    EXPECT_EQ(stats.external.tasks, 0u);
+    EXPECT_EQ(stats.external.busyNs, 0u);
+    EXPECT_EQ(stats.peakQueued, 0u);
+}
+
+TEST(XFlow, Stats_written_through_perf_writer)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads = 3;
+    opt.name    = "stats";
+    au::flow::XThreadpool pool(opt);
+    pool.enqueue([] {}).get();
+
+    CapturingWriter writer;
+    pool.writeStats(writer);
+    EXPECT_EQ(writer.text.rfind("[stats] ", 0), 0u) << writer.text;
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_NE(writer.text.find("worker " + std::to_string(i)), std::string::npos) << writer.text;
+    }
+    EXPECT_EQ(std::count(writer.text.begin(), writer.text.end(), '\n'), 4);
+}
+
+// ============================================================================
+// Timer wheel
+// ============================================================================
+
+TEST(XFlow, TimerWheel_fires_in_deadline_order_not_early)
+{
+    au::flow::XThreadpool  pool(1);
+    au::flow::XTimerWheel  timers(pool);
+    std::mutex             mutex;
+    std::vector<int>       order;
+    std::vector<long long> lateUs;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int ms : {40, 10, 30, 20}) {
+        timers.schedule(std::chrono::milliseconds(ms), [&, ms] {
+            auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(ms);
+            lateUs.push_back(elapsed.count() - ms * 1000);
+        });
+    }
+    EXPECT_EQ(timers.pending(), 4u);
+    ASSERT_TRUE(eventually([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 4;
+    }));
+    EXPECT_EQ(order, (std::vector<int>{10, 20, 30, 40}));
+    for (long long us : lateUs) EXPECT_GE(us, 0);
+    EXPECT_EQ(timers.pending(), 0u);
+    EXPECT_EQ(timers.stats().fired, 4u);
+}
+
+TEST(XFlow, TimerWheel_cancel_is_exact)
+{
+    au::flow::XThreadpool pool(1);
+    au::flow::XTimerWheel timers(pool);
+    std::atomic<int>      fired{0};
+
+    auto keep = timers.schedule(std::chrono::milliseconds(20), [&] { fired += 1; });
+    auto drop = timers.schedule(std::chrono::milliseconds(20), [&] { fired += 100; });
+    EXPECT_TRUE(timers.cancel(drop));
+    EXPECT_FALSE(timers.cancel(drop));
+    EXPECT_FALSE(timers.cancel(au::flow::XTimerId{}));
+    ASSERT_TRUE(eventually([&] { return fired.load() != 0; }));
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(fired.load(), 1);
+
+    // A fired one-shot cannot be cancelled, nor can a recycled slot be hit by a stale id.
+    EXPECT_FALSE(timers.cancel(keep));
+    auto reuse = timers.schedule(std::chrono::seconds(10), [] {});
+    EXPECT_FALSE(timers.cancel(keep));
+    EXPECT_TRUE(timers.cancel(reuse));
+    EXPECT_EQ(timers.stats().cancelled, 2u);
+}
+
+TEST(XFlow, TimerWheel_periodic_until_cancelled)
+{
+    au::flow::XThreadpool pool(2);
+    au::flow::XTimerWheel timers(pool);
+    std::atomic<int>      ticks{0};
+
+    auto id = timers.scheduleEvery(std::chrono::milliseconds(5), [&] { ticks++; });
+    ASSERT_TRUE(eventually([&] { return ticks.load() >= 5; }));
+    EXPECT_EQ(timers.pending(), 1u);
+    EXPECT_TRUE(timers.cancel(id));
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));  // let a submitted run finish
+    const int after = ticks.load();
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(ticks.load(), after);
+    EXPECT_EQ(timers.pending(), 0u);
+}
+
+TEST(XFlow, TimerWheel_periodic_skips_overlapping_runs)
+{
+    au::flow::XThreadpool pool(2);
+    au::flow::XTimerWheel timers(pool);
+    std::atomic<int>      running{0}, overlap{0}, runs{0};
+
+    auto id = timers.scheduleEvery(std::chrono::milliseconds(2), [&] {
+        if (running.fetch_add(1) != 0) overlap++;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        running--;
+        runs++;
+    });
+    ASSERT_TRUE(eventually([&] { return runs.load() >= 3; }));
+    timers.cancel(id);
+    EXPECT_EQ(overlap.load(), 0);
+    EXPECT_GT(timers.stats().skipped, 0u);
+}
+
+TEST(XFlow, TimerWheel_cascades_across_levels)
+{
+    // 4 slots x 3 levels of 1 ms span 64 ms; 150 ms is parked beyond the span.
+    au::flow::XTimerWheelOptions opt;
+    opt.slotsPerLevel = 4;
+    opt.levels        = 3;
+    au::flow::XThreadpool pool(1);
+    au::flow::XTimerWheel timers(pool, opt);
+    std::mutex            mutex;
+    std::vector<int>      order;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<bool> early{false};
+    for (int ms : {150, 3, 70, 17, 45, 5}) {
+        timers.schedule(std::chrono::milliseconds(ms), [&, ms] {
+            if (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(ms)) early = true;
+            std::lock_guard<std::mutex> lock(mutex);
+            order.push_back(ms);
+        });
+    }
+    ASSERT_TRUE(eventually([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 6;
+    }));
+    EXPECT_EQ(order, (std::vector<int>{3, 5, 17, 45, 70, 150}));
+    EXPECT_FALSE(early.load());
+    EXPECT_GT(timers.stats().cascaded, 0u);
+}
+
+TEST(XFlow, TimerWheel_tens_of_thousands_pending)
+{
+    constexpr int         kTimers = 50000;
+    au::flow::XThreadpool pool(2);
+    au::flow::XTimerWheel timers(pool);
+    std::atomic<int>      fired{0};
+
+    // The first 1000 are due within 200 ms; the rest spread over 2 .. 12 s so
+    // every level gets work, and are cancelled before they fire.
+    constexpr int                   kKeep = 1000;
+    std::vector<au::flow::XTimerId> ids;
+    ids.reserve(kTimers);
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < kTimers; ++i) {
+        auto delay = std::chrono::microseconds((i < kKeep ? 1000 : 2000000) + int64_t(i) * 200);
+        ids.push_back(timers.schedule(delay, [&] { fired++; }));
+    }
+    auto   t1        = std::chrono::steady_clock::now();
+    size_t cancelled = 0;
+    for (int i = kKeep; i < kTimers; ++i) cancelled += timers.cancel(ids[i]);
+    auto t2 = std::chrono::steady_clock::now();
+
+    EXPECT_EQ(cancelled, size_t(kTimers - kKeep));
+    ASSERT_TRUE(eventually([&] { return fired.load() == kKeep; }));
+    EXPECT_EQ(timers.pending(), 0u);
+
+    using ns = std::chrono::nanoseconds;
+    printf("[  BENCH   ] timer wheel %d timers: schedule %6.1f ns/op  cancel %6.1f ns/op\n", kTimers,
+           double(std::chrono::duration_cast<ns>(t1 - t0).count()) / kTimers,
+           double(std::chrono::duration_cast<ns>(t2 - t1).count()) / (kTimers - kKeep));
+}
+
+TEST(XFlow, TimerWheel_destructor_drops_pending)
+{
+    au::flow::XThreadpool pool(1);
+    std::atomic<int>      fired{0};
+    {
+        au::flow::XTimerWheel timers(pool);
+        for (int i = 0; i < 100; ++i) timers.schedule(std::chrono::seconds(5), [&] { fired++; });
+        timers.scheduleEvery(std::chrono::seconds(5), [&] { fired++; });
+    }
+    pool.enqueue([] {}).get();
+    EXPECT_EQ(fired.load(), 0);
+}
+
+// ============================================================================
+// NUMA grouping
+// ============================================================================
+
+namespace {
+
+/// Two fake nodes on the CPU the test may run on, so the affinity always sticks.
+std::vector<au::sys::NumaNodeInfo> fakeNumaNodes(size_t count)
+{
+    const std::vector<int>             allowed = au::sys::getThreadAffinity();
+    std::vector<au::sys::NumaNodeInfo> nodes(count);
+    for (size_t i = 0; i < count; ++i) {
+        nodes[i].id   = static_cast<int>(i);
+        nodes[i].cpus = {allowed.empty() ? 0 : allowed.front()};
+    }
+    return nodes;
+}
+
+au::flow::XThreadpoolOptions numaOptions(size_t threads, size_t nodes)
+{
+    au::flow::XThreadpoolOptions opt;
+    opt.threads   = threads;
+    opt.numaAware = true;
+    opt.numaNodes = fakeNumaNodes(nodes);
+    return opt;
+}
+
+}  // anonymous namespace
+
+TEST(XFlow, Numa_single_node_is_a_noop)
+{
+    au::flow::XThreadpool pool(numaOptions(2, 1));
+    EXPECT_EQ(pool.numaNodes(), 1u);
+    EXPECT_EQ(pool.workerNode(0), -1);
+    EXPECT_EQ(pool.enqueue([&] { return pool.currentNode(); }).get(), -1);
+
+    std::atomic<bool> ran{false};
+    pool.submitToNode(0, [&] { ran = true; });
+    EXPECT_TRUE(eventually([&] { return ran.load(); }));
+    EXPECT_EQ(pool.stats().workers[0].node, -1);
+}
+
+TEST(XFlow, Numa_workers_interleave_over_nodes)
+{
+    au::flow::XThreadpoolOptions opt = numaOptions(4, 2);
+    opt.name                         = "numa";
+    au::flow::XThreadpool pool(opt);
+    ASSERT_EQ(pool.numaNodes(), 2u);
+    for (size_t i = 0; i < 4; ++i) EXPECT_EQ(pool.workerNode(i), int(i % 2));
+    EXPECT_EQ(pool.currentNode(), -1);
+
+    pool.enqueue([] {}).get();
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.workers[3].node, 1);
+
+    CapturingWriter writer;
+    pool.writeStats(writer);
+    EXPECT_NE(writer.text.find("worker 3@1"), std::string::npos) << writer.text;
+}
+
+TEST(XFlow, Numa_steals_from_own_node_first)
+{
+    // Workers 0 and 2 are on node 0, worker 1 on node 1. Worker 1 and one
+    // node-0 worker fill their deques and block; the free node-0 worker must
+    // drain its node-mate before touching node 1.
+    au::flow::XThreadpool pool(numaOptions(3, 2));
+    std::atomic<int>      started{0}, filled{0};
+    std::atomic<bool>     node0Filler{false}, release{false};
+    std::mutex            mutex;
+    std::vector<int>      order;
+
+    for (int b = 0; b < 3; ++b) {
+        pool.submit([&] {
+            started++;
+            while (started.load() < 3) std::this_thread::yield();
+            const int node = pool.currentNode();
+            if (node == 0 && node0Filler.exchange(true)) {
+                while (filled.load() < 2) std::this_thread::yield();
+                return;  // this worker becomes the thief
+            }
+            for (int i = 0; i < 10; ++i) {
+                pool.submit([&, node] {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    order.push_back(node);
+                });
+            }
+            filled++;
+            while (!release.load()) std::this_thread::yield();
+        });
+    }
+    const bool drained = eventually([&] {
+        std::lock_guard<std::mutex> lock(mutex);
+        return order.size() == 20;
+    });
+    release = true;
+    ASSERT_TRUE(drained);
+
+    std::vector<int> expected(10, 0);
+    expected.resize(20, 1);
+    EXPECT_EQ(order, expected);
+    if (au::flow::kThreadpoolStats) {
+        uint64_t remote = 0;
+        for (const auto& w : pool.stats().workers) remote += w.remoteSteals;
+        EXPECT_GE(remote, 10u);
+    }
+}
+
+TEST(XFlow, Numa_submitToNode_targets_node_and_falls_back_remote)
+{
+    au::flow::XThreadpool pool(numaOptions(2, 2));
+    std::atomic<int>      started{0};
+    std::atomic<bool>     release{false};
+
+    // Hold the node-0 worker; the node-1 worker is left free.
+    for (int b = 0; b < 2; ++b) {
+        pool.submit([&] {
+            started++;
+            while (started.load() < 2) std::this_thread::yield();
+            if (pool.currentNode() == 0) {
+                while (!release.load()) std::this_thread::yield();
+            }
+        });
+    }
+    ASSERT_TRUE(eventually([&] { return started.load() == 2; }));
+
+    std::atomic<int> ranOn1{-2}, ranOn0{-2}, ranOnUnknown{-2};
+    pool.submitToNode(1, [&] { ranOn1 = pool.currentNode(); });
+    EXPECT_TRUE(eventually([&] { return ranOn1.load() != -2; }));
+    EXPECT_EQ(ranOn1.load(), 1);
+
+    // Node 0 is busy: its idle neighbour steals across nodes.
+    pool.submitToNode(0, [&] { ranOn0 = pool.currentNode(); });
+    EXPECT_TRUE(eventually([&] { return ranOn0.load() != -2; }));
+    EXPECT_EQ(ranOn0.load(), 1);
+
+    pool.submitToNode(7, [&] { ranOnUnknown = pool.currentNode(); });
+    EXPECT_TRUE(eventually([&] { return ranOnUnknown.load() != -2; }));
+    release = true;
+}
+
 // ============================================================================
 // XFlow singleton
 // ============================================================================
@@ -172,6 +2433,26 @@ TEST(XFlow, Flow_parallelizeTiledTasks_zero_range)
     EXPECT_EQ(ret, 0);  // zero tiles, no work
 }
 
+TEST(XFlow, Flow_parallelizeTiledTasks_exception_propagates)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    std::atomic<int> executed{0};
+    EXPECT_THROW(flow.parallelizeTiledTasks(1000, 1,
+                                            [&executed](size_t start, size_t) {
+                                                executed.fetch_add(1, std::memory_order_relaxed);
+                                                if (start == 3) throw std::runtime_error("tile failed");
+                                            }),
+                 std::runtime_error);
+    EXPECT_LT(executed.load(), 1000);  // later tiles were skipped
+
+    // The flow is still usable afterwards.
+    std::atomic<int> sum{0};
+    EXPECT_EQ(flow.parallelizeTiledTasks(10, 2, [&sum](size_t, size_t count) { sum += int(count); }), 0);
+    EXPECT_EQ(sum.load(), 10);
+}
+
 // ============================================================================
 // XFlow: addPipeline
 // ============================================================================
@@ -196,4 +2477,153 @@ TEST(XFlow, Flow_addPipeline_multiple_calls)
     EXPECT_EQ(f2.get(), 42);
 }
 
+TEST(XFlow, Flow_parallelizeTiledTasks_nested_does_not_deadlock)
+{
+    // Four outer tiles on four workers, each opening an inner tiled region.
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    std::atomic<int> inner{0};
+    int ret = flow.parallelizeTiledTasks(4, 1, [&flow, &inner](size_t, size_t) {
+        flow.parallelizeTiledTasks(64, 4, [&inner](size_t, size_t count) {
+            inner.fetch_add(static_cast<int>(count), std::memory_order_relaxed);
+        });
+    });
+    EXPECT_EQ(ret, 0);
+    EXPECT_EQ(inner.load(), 4 * 64);
+}
+
+TEST(XFlow, Flow_runGraph_on_pipelines)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    au::flow::XTaskGraph graph("frame");
+    int                  stage = 0;
+    graph.emplace("decode", [&stage] { stage = 1; }).precede(graph.emplace("encode", [&stage] { stage *= 10; }));
+    EXPECT_EQ(flow.runGraph(graph), 0);
+    EXPECT_EQ(stage, 10);
+}
+
+TEST(XFlow, Flow_makePipeline_on_pipelines)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    std::atomic<int> total{0};
+    {
+        auto stream = flow.makePipeline<int>({2})
+                          .parallel("square", [](int v) { return v * v; })
+                          .serial("sum", [&total](int v) { total += v; })
+                          .build();
+        for (int i = 1; i <= 10; ++i) stream.push(i);
+    }
+    EXPECT_EQ(total.load(), 385);
+}
+
+TEST(XFlow, Flow_parallelizeTiledTasks_cancel_skips_stale_tiles)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    au::flow::XCancelSource frame;
+    std::atomic<size_t>     processed{0};
+    const int ret = flow.parallelizeTiledTasks(4096, 1, [&](size_t, size_t count) {
+        if (processed.fetch_add(count) + count >= 16) frame.cancel();
+    }, frame.token());
+    EXPECT_EQ(ret, err::kErrorAborted);
+    EXPECT_LT(processed.load(), 4096u);
+
+    au::flow::XCancelSource live;
+    processed = 0;
+    EXPECT_EQ(flow.parallelizeTiledTasks(100, 10, [&](size_t, size_t count) { processed += count; }, live.token()), 0);
+    EXPECT_EQ(processed.load(), 100u);
+}
+
+TEST(XFlow, Flow_resize_without_reinit)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    EXPECT_EQ(flow.resize(1, 1), 0);
+    std::atomic<size_t> processed{0};
+    EXPECT_EQ(flow.parallelizeTiledTasks(100, 10, [&](size_t, size_t count) { processed += count; }), 0);
+    EXPECT_EQ(processed.load(), 100u);
+    EXPECT_EQ(flow.resize(100000, 1), err::kErrorInvalidParam);
+    EXPECT_EQ(flow.resize(4, 2), 0);
+}
+
+TEST(XFlow, Flow_parallel_algorithms_on_workers)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    std::vector<int> v(10000);
+    std::iota(v.begin(), v.end(), 1);
+    EXPECT_EQ(flow.parallelReduce(v.begin(), v.end(), int64_t(0), std::plus<>()), int64_t(10000) * 10001 / 2);
+    EXPECT_EQ(flow.parallelTransformReduce(v.begin(), v.end(), 0, [](int a, int b) { return std::max(a, b); },
+                                           [](int x) { return x % 977; }),
+              976);
+
+    std::vector<int> scan(v.size());
+    flow.parallelExclusiveScan(v.begin(), v.end(), scan.begin(), 0);
+    EXPECT_EQ(scan.back(), 9999 * 10000 / 2);
+    flow.parallelInclusiveScan(v.begin(), v.end(), scan.begin());
+    EXPECT_EQ(scan.back(), 10000 * 10001 / 2);
+
+    std::reverse(v.begin(), v.end());
+    flow.parallelSort(v.begin(), v.end());
+    EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+}
+
+TEST(XFlow, Flow_addPipeline_with_priority)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    const uint64_t before = flow.laneStats(au::flow::kPriorityHigh).tasks;
+    auto           fut    = flow.addPipeline(au::flow::kPriorityHigh, [](int x) { return x + 1; }, 41);
+    EXPECT_EQ(fut.get(), 42);
+    EXPECT_EQ(flow.laneStats(au::flow::kPriorityHigh).tasks, before + 1);
+}
+
+// ============================================================================
+// XFlow: parallelFor
+// ============================================================================
+
+TEST(XFlow, Flow_parallelFor_basic)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    std::atomic<size_t> sum{0};
+    EXPECT_EQ(flow.parallelFor(100, [&sum](size_t, size_t count) { sum.fetch_add(count); }), 0);
+    EXPECT_EQ(sum.load(), 100u);
+}
+
+TEST(XFlow, Bench_parallelFor_vs_tiled)
+{
+    auto& flow = au::flow::XFlow::get();
+    flow.init(4, 2);
+
+    const size_t kRows   = 4000;
+    auto         rowCost = [kRows](size_t y) { return y > kRows * 3 / 4 ? size_t(40) : size_t(1); };
+    auto         kernel  = [&rowCost](size_t s, size_t c) {
+        for (size_t y = s; y < s + c; ++y) spinWork(rowCost(y));
+    };
+
+    for (size_t tile : {size_t(1), size_t(16), size_t(1000)}) {
+        auto begin = std::chrono::steady_clock::now();
+        flow.parallelizeTiledTasks(kRows, tile, kernel);
+        auto end = std::chrono::steady_clock::now();
+        printf("[  BENCH   ] tiled tile=%4zu   %8.3f ms\n", tile,
+               std::chrono::duration<double, std::milli>(end - begin).count());
+    }
+    auto begin = std::chrono::steady_clock::now();
+    EXPECT_EQ(flow.parallelFor(kRows, kernel), 0);
+    auto end = std::chrono::steady_clock::now();
+    printf("[  BENCH   ] parallelFor (adaptive) %8.3f ms\n",
+           std::chrono::duration<double, std::milli>(end - begin).count());
+}
+
 #endif  // ENABLE_TEST_XFLOW
@@ -1,7 +1,15 @@
 #if ENABLE_TEST_XIMAGE
 
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
 #include "gtest/gtest.h"
 #include "cv/ximage.h"
+#include "memory/xarena.h"
+#include "memory/xmemory_resource.h"
+#include "memory/xpage_resource.h"
+#include "memory/xpool_resource.h"
 
 using au::cv::XImage;
 using au::cv::Image;
@@ -279,6 +287,160 @@ TEST(XImage, alloc_ctor_enum_overload)
     EXPECT_EQ(img.format, au::cv::kXFormatRGBU8);
 }
 
+TEST(XImage, alloc_ctor_from_memory_resource)
+{
+    struct Counting : au::memory::XMemoryResource {
+        size_t live = 0;
+        void* allocate(size_t bytes, size_t alignment) override
+        {
+            live += bytes;
+            return au::memory::defaultResource()->allocate(bytes, alignment);
+        }
+        void deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            live -= bytes;
+            au::memory::defaultResource()->deallocate(p, bytes, alignment);
+        }
+    } res;
+    {
+        XImage img(&res, 64, 64, au::cv::kXFormatNV12);
+        EXPECT_TRUE(img.isValid());
+        EXPECT_EQ(res.live, 64u * 64 + 32 * 64);  // Y plane + interleaved UV plane
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(img.data[1]) % 64, 0u);
+    }
+    EXPECT_EQ(res.live, 0u);
+
+    au::memory::XNodeResource node0(0);
+    XImage local(&node0, 1920, 1080, au::cv::kXFormatRGBAU8);
+    EXPECT_TRUE(local.isValid());
+    local.dataptr<uint32_t>(XImagePlane::Plane0, 1079, 1919)[0] = 0xffffffffu;
+}
+
+TEST(XImage, alloc_ctor_from_resource_not_at_offset_zero)
+{
+    // XMemoryResource is the second base, so a void* round trip would hand
+    // imageAlloc the wrong address; the typed overload adjusts it.
+    struct Named {
+        virtual ~Named() = default;
+        const char* name = "planes";
+    };
+    struct Counting : Named, au::memory::XMemoryResource {
+        size_t allocs = 0;
+        void* allocate(size_t bytes, size_t alignment) override
+        {
+            ++allocs;
+            return au::memory::defaultResource()->allocate(bytes, alignment);
+        }
+        void deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            --allocs;
+            au::memory::defaultResource()->deallocate(p, bytes, alignment);
+        }
+    } res;
+    {
+        XImage img(&res, 64, 64, au::cv::kXFormatNV12);
+        EXPECT_TRUE(img.isValid());
+        EXPECT_EQ(res.allocs, 2u);
+    }
+    EXPECT_EQ(res.allocs, 0u);
+}
+
+TEST(XImage, alloc_ctor_releases_planes_when_one_fails)
+{
+    struct FailSecond : au::memory::XMemoryResource {
+        size_t allocs = 0;
+        size_t live   = 0;
+        void* allocate(size_t bytes, size_t alignment) override
+        {
+            if (++allocs == 2) return nullptr;
+            live += bytes;
+            return au::memory::defaultResource()->allocate(bytes, alignment);
+        }
+        void deallocate(void* p, size_t bytes, size_t alignment) override
+        {
+            live -= bytes;
+            au::memory::defaultResource()->deallocate(p, bytes, alignment);
+        }
+    } res;
+    {
+        XImage img(&res, 64, 64, au::cv::kXFormatNV12);  // the UV plane fails
+        EXPECT_FALSE(img.isValid());
+        EXPECT_EQ(img.data[0], nullptr);
+        EXPECT_EQ(img.data[1], nullptr);
+        EXPECT_EQ(res.allocs, 2u);
+        EXPECT_EQ(res.live, 0u);  // the Y plane went back
+    }
+    EXPECT_EQ(res.live, 0u);
+}
+
+TEST(XImage, alloc_ctor_from_pool)
+{
+    au::memory::XPoolResource pool;
+    uint8_t*                  y = nullptr;
+    for (int frame = 0; frame < 10; ++frame) {
+        XImage img(&pool, 1920, 1080, au::cv::kXFormatNV12);
+        ASSERT_TRUE(img.isValid());
+        if (frame == 0) y = img.data[0];
+        EXPECT_EQ(img.data[0], y);  // the same planes come back every frame
+        img.dataptr<uint8_t>(XImagePlane::Plane1, 539, 1919)[0] = 1;
+    }
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.misses, 2u);  // Y and UV, first frame only
+    EXPECT_EQ(stats.hits, 18u);
+    EXPECT_EQ(stats.cachedBlocks, 2u);
+}
+
+TEST(XImage, alloc_ctor_from_arena)
+{
+    au::memory::XArena& arena = au::memory::XArena::local();
+    uint8_t*            y     = nullptr;
+    for (int frame = 0; frame < 3; ++frame) {
+        au::memory::XArenaScope scope(arena);
+        XImage                  img(&arena, 640, 480, au::cv::kXFormatNV21);
+        ASSERT_TRUE(img.isValid());
+        if (frame == 0) y = img.data[0];
+        EXPECT_EQ(img.data[0], y);  // rewound, so the same scratch memory each frame
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(img.data[1]) % 64, 0u);
+    }
+}
+
+TEST(XImage, alloc_ctor_raw_from_page_resource)
+{
+    au::memory::XPageResource pages({au::sys::HugePages::Transparent, true});
+
+    XImage raw16(&pages, 4000, 3000, au::cv::kXFormatRawU16);
+    ASSERT_TRUE(raw16.isValid());
+    EXPECT_EQ(raw16.stride[0], 8000);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(raw16.data[0]) % au::sys::getPageSize(), 0u);
+    raw16.dataptr<uint16_t>(XImagePlane::Plane0, 2999, 3999)[0] = 0x3ff;
+
+    XImage raw10(&pages, 4000, 3000, au::cv::kXFormatRawPackedU10);
+    ASSERT_TRUE(raw10.isValid());
+    EXPECT_EQ(raw10.stride[0], 5000);
+    raw10.dataptr<uint8_t>(XImagePlane::Plane0, 2999, 4999)[0] = 1;
+    EXPECT_EQ(raw10.data[1], nullptr);
+}
+
+TEST(XImage, Bench_alloc_per_frame_malloc_vs_pool)
+{
+    // 12 MP NV12 frames, each written once as a decoder would.
+    const int reps = 20;
+    auto      time = [&](void* mempool) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int i = 0; i < reps; ++i) {
+            XImage img(mempool, 4000, 3000, au::cv::kXFormatNV12);
+            memset(img.data[0], i, size_t(img.stride[0]) * img.height);
+            memset(img.data[1], i, size_t(img.stride[1]) * img.height / 2);
+        }
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / reps;
+    };
+    au::memory::XPoolResource pool;
+    double                    heap   = time(nullptr);
+    double                    pooled = time(&pool);
+    printf("[  BENCH   ] 12 MP NV12 frame alloc+write: malloc %.2f ms  pool %.2f ms (hits %llu misses %llu)\n", heap,
+           pooled, (unsigned long long)pool.stats().hits, (unsigned long long)pool.stats().misses);
+}
+
 TEST(XImage, alloc_ctor_zero_width_returns_invalid)
 {
     XImage img(nullptr, 0, 64, au::cv::kXFormatGrayU8);
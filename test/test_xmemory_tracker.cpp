@@ -0,0 +1,116 @@
+#if ENABLE_TEST_XMEMORY_TRACKER
+
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "json/xjson.h"
+#include "memory/xbuffer.h"
+#include "memory/xmemory_tracker.h"
+
+using au::memory::XBuffer;
+using au::memory::XMemoryProbe;
+using au::memory::XTrackingResource;
+
+TEST(XMemoryTracker, TagsCountLiveAndPeak) {
+    if (!au::memory::kMemoryAccounting) GTEST_SKIP() << "compiled out";
+    auto& tag = au::memory::memoryTag("test.buffers");
+    EXPECT_EQ(&tag, &au::memory::memoryTag("test.buffers"));
+
+    XTrackingResource tracked(tag);
+    {
+        XBuffer<uint8_t> a(1000, au::memory::XBufferOptions{0, false, &tracked});
+        {
+            XBuffer<uint8_t> b(5000, au::memory::XBufferOptions{0, false, &tracked});
+            EXPECT_GE(tag.liveBytes(), 6000u);
+        }
+        auto s = tag.stats();
+        EXPECT_GE(s.liveBytes, 1000u);
+        EXPECT_LT(s.liveBytes, 6000u);
+        EXPECT_GE(s.peakBytes, 6000u);
+        EXPECT_EQ(s.allocs, 4u);  // two buffers, two control blocks
+        EXPECT_EQ(s.outstanding(), 2u);
+    }
+    auto s = tag.stats();
+    EXPECT_EQ(s.liveBytes, 0u);
+    EXPECT_EQ(s.outstanding(), 0u);
+    tag.resetPeak();
+    EXPECT_EQ(tag.stats().peakBytes, 0u);
+}
+
+TEST(XMemoryTracker, ScopedProbesNest) {
+    if (!au::memory::kMemoryAccounting) GTEST_SKIP() << "compiled out";
+    auto& tag = au::memory::memoryTag("test.probe");
+    tag.onAlloc(100);
+    {
+        XMemoryProbe frame(tag);
+        EXPECT_EQ(frame.baselineBytes(), 100u);
+        tag.onAlloc(400);
+        tag.onFree(400);
+        {
+            XMemoryProbe stage(tag);
+            tag.onAlloc(50);
+            EXPECT_EQ(stage.peakBytes(), 150u);
+            EXPECT_EQ(stage.peakGrowthBytes(), 50u);
+        }
+        EXPECT_EQ(frame.peakBytes(), 500u);  // the inner probe kept the outer peak
+        EXPECT_EQ(frame.peakGrowthBytes(), 400u);
+        tag.onFree(50);
+    }
+    tag.onFree(100);
+    EXPECT_EQ(tag.liveBytes(), 0u);
+}
+
+TEST(XMemoryTracker, ConcurrentCounting) {
+    auto&                    tag = au::memory::memoryTag("test.concurrent");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&tag] {
+            for (int i = 0; i < 10000; ++i) {
+                tag.onAlloc(64);
+                tag.onFree(64);
+            }
+        });
+    }
+    for (auto& t : threads) t.join();
+    auto s = tag.stats();
+    EXPECT_EQ(s.liveBytes, 0u);
+    EXPECT_EQ(s.allocs, au::memory::kMemoryAccounting ? 40000u : 0u);
+    EXPECT_LE(s.peakBytes, 4u * 64);
+}
+
+TEST(XMemoryTracker, DumpFlagsOutstanding) {
+    struct Capture : au::perf::IPerfWriter4 {
+        std::string text;
+        void write(const char* data, std::size_t size) noexcept override { text.append(data, size); }
+    } out;
+    auto& tag = au::memory::memoryTag("test.leaky");
+    tag.onAlloc(2048);
+    au::memory::writeMemoryStats(out);
+    au::memory::logMemoryStats();
+    tag.onFree(2048);
+    if (!au::memory::kMemoryAccounting) {
+        EXPECT_NE(out.text.find("compiled out"), std::string::npos);
+        return;
+    }
+    const auto line = out.text.substr(out.text.find("test.leaky"));
+    EXPECT_NE(line.find("live          2.0 KB"), std::string::npos) << line;
+    EXPECT_LT(line.find("(outstanding)"), line.find('\n'));
+}
+
+TEST(XMemoryTracker, JsonTreesAreCharged) {
+    if (!au::memory::kMemoryAccounting || !au::json::kJsonMemoryAccounting) GTEST_SKIP() << "not enabled";
+    auto&        tag    = au::memory::memoryTag("json");
+    const size_t before = tag.liveBytes();
+    {
+        auto obj = au::json::XJson::object();
+        for (int i = 0; i < 100; ++i) obj.set("key" + std::to_string(i), i);
+        EXPECT_GT(tag.liveBytes(), before + 100 * sizeof(void*));
+        EXPECT_FALSE(obj.dump().empty());
+    }
+    EXPECT_EQ(tag.liveBytes(), before);
+}
+
+#endif  // ENABLE_TEST_XMEMORY_TRACKER
@@ -0,0 +1,175 @@
+#if ENABLE_TEST_XOBJECT_POOL
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "memory/xobject_pool.h"
+
+using au::memory::XObjectPool;
+using au::memory::XObjectPoolOptions;
+
+namespace {
+
+struct Tracked {
+    static inline std::atomic<int> alive{0};
+    explicit Tracked(int v = 0) : value(v) { alive.fetch_add(1); }
+    ~Tracked() { alive.fetch_sub(1); }
+    int  value;
+    char payload[120];
+};
+
+}  // namespace
+
+TEST(XObjectPool, RecyclesSlots) {
+    XObjectPool<Tracked> pool;
+    Tracked*             first = nullptr;
+    {
+        auto h = pool.acquire(7);
+        ASSERT_TRUE(h);
+        EXPECT_EQ(h->value, 7);
+        EXPECT_EQ(Tracked::alive.load(), 1);
+        first = h.get();
+    }
+    EXPECT_EQ(Tracked::alive.load(), 0);
+    for (int i = 0; i < 100; ++i) {
+        auto h = pool.acquire(i);
+        EXPECT_EQ(h.get(), first);
+        EXPECT_EQ((*h).value, i);
+    }
+    const auto s = pool.stats();
+    EXPECT_EQ(s.acquires, 101u);
+    EXPECT_EQ(s.releases, 101u);
+    EXPECT_EQ(s.cacheHits, 100u);
+    EXPECT_EQ(s.created, 1u);
+    EXPECT_EQ(s.inUse(), 0u);
+}
+
+TEST(XObjectPool, HandlesMoveAndReset) {
+    XObjectPool<Tracked> pool;
+    auto                 a = pool.acquire(1);
+    auto                 b = std::move(a);
+    EXPECT_FALSE(a);
+    EXPECT_EQ(b->value, 1);
+    XObjectPool<Tracked>::Handle c;
+    c = std::move(b);
+    EXPECT_EQ(pool.stats().inUse(), 1u);
+    c.reset();
+    EXPECT_FALSE(c);
+    EXPECT_EQ(Tracked::alive.load(), 0);
+    EXPECT_EQ(pool.stats().inUse(), 0u);
+}
+
+TEST(XObjectPool, BoundedCapacity) {
+    XObjectPool<Tracked>              pool(XObjectPoolOptions{100, 8});
+    std::vector<XObjectPool<Tracked>::Handle> held;
+    for (int i = 0; i < 100; ++i) {
+        held.push_back(pool.acquire(i));
+        ASSERT_TRUE(held.back());
+    }
+    EXPECT_FALSE(pool.acquire());
+    held.pop_back();
+    EXPECT_TRUE(pool.acquire());
+
+    const auto s = pool.stats();
+    EXPECT_EQ(s.created, 100u);
+    EXPECT_EQ(s.exhausted, 1u);
+    EXPECT_EQ(s.capacity, 100u);
+    EXPECT_EQ(s.inUse(), 99u);
+}
+
+TEST(XObjectPool, ConstructorThrowRecyclesSlot) {
+    struct Throwing {
+        explicit Throwing(bool fail) {
+            if (fail) throw std::runtime_error("ctor");
+        }
+    };
+    XObjectPool<Throwing> pool(XObjectPoolOptions{1, 2});
+    EXPECT_THROW(pool.acquire(true), std::runtime_error);
+    EXPECT_TRUE(pool.acquire(false));
+    EXPECT_EQ(pool.stats().created, 1u);
+}
+
+TEST(XObjectPool, ExitingThreadsReturnTheirCaches) {
+    XObjectPool<Tracked> pool(XObjectPoolOptions{64, 16});
+    std::thread([&] {
+        std::vector<XObjectPool<Tracked>::Handle> held;
+        for (int i = 0; i < 10; ++i) held.push_back(pool.acquire(i));
+    }).join();  // 10 slots parked in that thread's cache until it exits
+
+    std::vector<XObjectPool<Tracked>::Handle> held;
+    for (int i = 0; i < 64; ++i) {
+        held.push_back(pool.acquire(i));
+        ASSERT_TRUE(held.back()) << i;
+    }
+    const auto s = pool.stats();
+    EXPECT_EQ(s.globalHits, 10u);
+    EXPECT_EQ(s.acquires, 74u);
+    EXPECT_EQ(s.releases, 10u);
+}
+
+TEST(XObjectPool, CrossThreadRelease) {
+    constexpr int        kThreads = 4;
+    constexpr int        kRounds  = 5000;
+    XObjectPool<Tracked> pool(XObjectPoolOptions{256, 16});
+
+    // Each thread acquires a batch and hands it to its neighbour to release.
+    std::vector<std::vector<XObjectPool<Tracked>::Handle>> mailbox(kThreads);
+    std::vector<std::mutex>                                locks(kThreads);
+    std::atomic<int>                                       refused{0};
+    std::vector<std::thread>                               threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t] {
+            for (int r = 0; r < kRounds; ++r) {
+                auto h = pool.acquire(r);
+                if (!h) {
+                    refused.fetch_add(1);
+                    continue;
+                }
+                h->value = r;
+                std::lock_guard<std::mutex> lock(locks[(t + 1) % kThreads]);
+                auto&                       box = mailbox[(t + 1) % kThreads];
+                box.push_back(std::move(h));
+                if (box.size() > 8) box.clear();
+            }
+            std::lock_guard<std::mutex> lock(locks[t]);
+            mailbox[t].clear();
+        });
+    }
+    for (auto& th : threads) th.join();
+    for (auto& box : mailbox) box.clear();
+
+    const auto s = pool.stats();
+    EXPECT_EQ(Tracked::alive.load(), 0);
+    EXPECT_EQ(s.inUse(), 0u);
+    EXPECT_EQ(s.acquires + refused.load(), uint64_t(kThreads * kRounds));
+    EXPECT_LE(s.created, 256u);
+}
+
+TEST(XObjectPool, Bench_acquire_release_vs_new) {
+    constexpr int        kIters = 1 << 20;
+    XObjectPool<Tracked> pool;
+    auto time = [](auto&& fn) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / kIters;
+    };
+    long   sink   = 0;
+    double heapNs = time([&] {
+        for (int i = 0; i < kIters; ++i) sink += std::make_unique<Tracked>(i)->value;
+    });
+    double poolNs = time([&] {
+        for (int i = 0; i < kIters; ++i) sink += pool.acquire(i)->value;
+    });
+    printf("[  BENCH   ] 128 B object: make_unique %.1f ns  XObjectPool %.1f ns  (%ld)\n", heapNs, poolNs, sink);
+}
+
+#endif  // ENABLE_TEST_XOBJECT_POOL
@@ -0,0 +1,69 @@
+#if ENABLE_TEST_XPAGE_RESOURCE
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "memory/xbuffer.h"
+#include "memory/xmemory_resource.h"
+#include "memory/xpage_resource.h"
+
+using au::memory::XBuffer;
+
+TEST(XPageResource, BacksBuffersInEveryMode) {
+    using au::sys::HugePages;
+    for (auto huge : {HugePages::None, HugePages::Transparent, HugePages::Explicit}) {
+        au::memory::XPageResource pages({huge, huge != HugePages::None});
+        XBuffer<uint16_t>         raw(3 << 20, au::memory::XBufferOptions{au::memory::kPageAlignment, false, &pages});
+        ASSERT_NE(raw.data(), nullptr);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(raw.data()) % 4096, 0u);
+        EXPECT_EQ(raw[raw.size() - 1], 0);  // fresh mappings are zero
+        raw.fill(7);
+        raw.resize(4 << 20);
+        EXPECT_EQ(raw[(3 << 20) - 1], 7);
+    }
+}
+
+TEST(XPageResource, Bench_first_touch_and_streaming_read) {
+    using au::sys::HugePages;
+    const size_t bytes = size_t(64) << 20;
+    using Clock        = std::chrono::steady_clock;
+    auto ms            = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+    auto run = [&](const char* name, au::memory::XMemoryResource* resource) {
+        const auto t0 = Clock::now();
+        auto*      p  = static_cast<uint64_t*>(resource ? resource->allocate(bytes, 64) : std::malloc(bytes));
+        const auto t1 = Clock::now();
+        std::memset(p, 1, bytes);  // first touch
+        const auto t2  = Clock::now();
+        uint64_t   sum = 0;
+        for (int pass = 0; pass < 4; ++pass) {
+            for (size_t i = 0; i < bytes / sizeof(uint64_t); ++i) sum += p[i];
+        }
+        const auto t3 = Clock::now();
+        printf("[  BENCH   ] 64 MB %-22s alloc %7.2f ms  first touch %7.2f ms  streaming read %7.2f ms/pass (%llu)\n",
+               name, ms(t0, t1), ms(t1, t2), ms(t2, t3) / 4, (unsigned long long)(sum & 1));
+        if (resource) {
+            resource->deallocate(p, bytes, 64);
+        } else {
+            std::free(p);
+        }
+    };
+    au::memory::XPageResource base({HugePages::None, false});
+    au::memory::XPageResource populated({HugePages::None, true});
+    au::memory::XPageResource thp({HugePages::Transparent, false});
+    au::memory::XPageResource thpPopulated({HugePages::Transparent, true});
+    au::memory::XPageResource hugetlb({HugePages::Explicit, true});
+    run("malloc", nullptr);
+    run("mmap", &base);
+    run("mmap+populate", &populated);
+    run("mmap+THP", &thp);
+    run("mmap+THP+populate", &thpPopulated);
+    run("hugetlb+populate", &hugetlb);
+}
+
+#endif  // ENABLE_TEST_XPAGE_RESOURCE
@@ -1,5 +1,12 @@
 #if ENABLE_TEST_XPLATFORM
 
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
 #include "gtest/gtest.h"
 #include "sys/xplatform.h"
 
@@ -94,4 +101,213 @@ TEST(XPlatform, GpuInfo) {
     }
 }
 
+// ============================================================================
+// CPU topology
+// ============================================================================
+
+namespace {
+
+void writeSysfs(const std::filesystem::path& path, const std::string& value) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream(path) << value << "\n";
+}
+
+/// DynamIQ-style phone: 4 little + 3 big + 1 prime core, one cluster_id for all.
+std::filesystem::path makeFakeBigLittle() {
+    auto root = std::filesystem::temp_directory_path() / "aura_xplatform_topology";
+    std::filesystem::remove_all(root);
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        auto dir = root / ("cpu" + std::to_string(cpu));
+        const char* related = cpu < 4 ? "0-3" : cpu < 7 ? "4-6" : "7";
+        const char* freq = cpu < 4 ? "1800000" : cpu < 7 ? "2400000" : "3000000";
+        writeSysfs(dir / "cpufreq" / "related_cpus", related);
+        writeSysfs(dir / "cpufreq" / "cpuinfo_max_freq", freq);
+        writeSysfs(dir / "cpu_capacity", cpu < 4 ? "400" : "1024");
+        writeSysfs(dir / "topology" / "cluster_id", "0");
+        writeSysfs(dir / "cache" / "index0" / "level", "1");
+        writeSysfs(dir / "cache" / "index0" / "shared_cpu_list", std::to_string(cpu));
+        writeSysfs(dir / "cache" / "index2" / "level", "3");
+        writeSysfs(dir / "cache" / "index2" / "shared_cpu_list", "0-7");
+    }
+    writeSysfs(root / "cpu5" / "online", "0");
+    writeSysfs(root / "cpufreq" / "boost", "0");  // not a cpuN directory
+    writeSysfs(root / "online", "0-4,6-7");
+    return root;
+}
+
+}  // namespace
+
+TEST(XPlatform, ParseCpuList) {
+    EXPECT_EQ(parseCpuList("0-3,6,8-9"), (std::vector<int>{0, 1, 2, 3, 6, 8, 9}));
+    EXPECT_EQ(parseCpuList("5"), (std::vector<int>{5}));
+    EXPECT_TRUE(parseCpuList("").empty());
+}
+
+TEST(XPlatform, CpuTopologyFromFakeSysfs) {
+    auto root = makeFakeBigLittle();
+    auto cores = getCpuTopology(root.string());
+    ASSERT_EQ(cores.size(), 8u);
+    for (int i = 0; i < 8; ++i) EXPECT_EQ(cores[i].id, i);
+
+    // cpufreq domains win over the uniform cluster_id.
+    EXPECT_EQ(cores[0].clusterId, 0);
+    EXPECT_EQ(cores[3].clusterId, 0);
+    EXPECT_EQ(cores[4].clusterId, 1);
+    EXPECT_EQ(cores[6].clusterId, 1);
+    EXPECT_EQ(cores[7].clusterId, 2);
+
+    EXPECT_EQ(cores[0].maxFreqKHz, 1800000u);
+    EXPECT_EQ(cores[7].maxFreqKHz, 3000000u);
+    EXPECT_EQ(cores[4].capacity, 1024);
+    EXPECT_EQ(cores[2].sharedCacheLevel, 3);
+    EXPECT_FALSE(cores[5].online);
+    EXPECT_TRUE(cores[0].online);
+
+    EXPECT_EQ(getPerformanceCores(cores), (std::vector<int>{7}));
+    cores[7].online = false;
+    EXPECT_EQ(getPerformanceCores(cores), (std::vector<int>{4, 6}));
+    std::filesystem::remove_all(root);
+}
+
+TEST(XPlatform, PerformanceCoresFallBackToCapacityThenAll) {
+    std::vector<CpuCoreInfo> cores(4);
+    for (int i = 0; i < 4; ++i) cores[i].id = i;
+    EXPECT_EQ(getPerformanceCores(cores), (std::vector<int>{0, 1, 2, 3}));
+    cores[2].capacity = 1024;
+    cores[3].capacity = 1024;
+    cores[0].capacity = cores[1].capacity = 512;
+    EXPECT_EQ(getPerformanceCores(cores), (std::vector<int>{2, 3}));
+}
+
+TEST(XPlatform, CpuTopologyMissingRootIsEmpty) {
+    EXPECT_TRUE(getCpuTopology("/nonexistent/aura/cpu").empty());
+}
+
+// ============================================================================
+// NUMA topology and node-local memory
+// ============================================================================
+
+namespace {
+
+/// Dual-socket server: two nodes of four cpus.
+std::filesystem::path makeFakeNuma() {
+    auto root = std::filesystem::temp_directory_path() / "aura_xplatform_numa";
+    std::filesystem::remove_all(root);
+    writeSysfs(root / "node0" / "cpulist", "0-3");
+    writeSysfs(root / "node0" / "distance", "10 21");
+    writeSysfs(root / "node0" / "meminfo", "Node 0 MemTotal:       16384 kB\nNode 0 MemFree:         1024 kB");
+    writeSysfs(root / "node1" / "cpulist", "4-7");
+    writeSysfs(root / "node1" / "distance", "21 10");
+    writeSysfs(root / "node1" / "meminfo", "Node 1 MemTotal:        8192 kB");
+    writeSysfs(root / "possible", "0-1");  // not a nodeN directory
+    return root;
+}
+
+}  // namespace
+
+TEST(XPlatform, NumaTopologyFromFakeSysfs) {
+    auto root = makeFakeNuma();
+    auto nodes = getNumaTopology(root.string());
+    ASSERT_EQ(nodes.size(), 2u);
+    EXPECT_EQ(nodes[0].id, 0);
+    EXPECT_EQ(nodes[1].id, 1);
+    EXPECT_EQ(nodes[0].cpus, (std::vector<int>{0, 1, 2, 3}));
+    EXPECT_EQ(nodes[1].cpus, (std::vector<int>{4, 5, 6, 7}));
+    EXPECT_EQ(nodes[0].distances, (std::vector<int>{10, 21}));
+    EXPECT_EQ(nodes[0].totalBytes, 16384u * 1024);
+    EXPECT_EQ(nodes[1].totalBytes, 8192u * 1024);
+    std::filesystem::remove_all(root);
+}
+
+TEST(XPlatform, NumaTopologyMissingRootIsEmpty) {
+    EXPECT_TRUE(getNumaTopology("/nonexistent/aura/node").empty());
+}
+
+TEST(XPlatform, AllocOnNodeIsZeroedAndWritable) {
+    const size_t bytes = 1 << 20;
+    for (int node : {-1, 0}) {
+        auto* p = static_cast<unsigned char*>(allocOnNode(bytes, node));
+        ASSERT_NE(p, nullptr);
+        EXPECT_EQ(p[0], 0);
+        EXPECT_EQ(p[bytes - 1], 0);
+        std::memset(p, 0xab, bytes);
+        EXPECT_EQ(p[bytes / 2], 0xab);
+        freeOnNode(p, bytes);
+    }
+    EXPECT_EQ(allocOnNode(0, 0), nullptr);
+    freeOnNode(nullptr, 0);
+}
+
+TEST(XPlatform, AllocPagesModes) {
+    const size_t bytes = (3 << 20) + 123;
+    for (auto huge : {HugePages::None, HugePages::Transparent, HugePages::Explicit}) {
+        for (bool populate : {false, true}) {
+            const PageAllocOptions opt{huge, populate};
+            auto*                  p = static_cast<unsigned char*>(allocPages(bytes, opt));
+            ASSERT_NE(p, nullptr);
+            EXPECT_EQ(p[0], 0);
+            EXPECT_EQ(p[bytes - 1], 0);
+            std::memset(p, 0x5a, bytes);
+#ifdef __linux__
+            EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % getPageSize(), 0u);
+            if (huge == HugePages::Transparent && getHugePageSize() > 0) {
+                EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % getHugePageSize(), 0u);
+            }
+#endif
+            freePages(p, bytes, opt);
+        }
+    }
+    EXPECT_EQ(allocPages(0), nullptr);
+    freePages(nullptr, 0);
+}
+
+#ifdef __linux__
+TEST(XPlatform, DiscardPagesZeroesWholePagesOnly) {
+    const size_t page = getPageSize();
+    auto*        p    = static_cast<unsigned char*>(allocPages(4 * page));
+    ASSERT_NE(p, nullptr);
+    std::memset(p, 0xee, 4 * page);
+    EXPECT_TRUE(discardPages(p + 10, 3 * page));  // only pages 1 and 2 are whole
+    EXPECT_EQ(p[page - 1], 0xee);
+    EXPECT_EQ(p[page], 0);
+    EXPECT_EQ(p[3 * page - 1], 0);
+    EXPECT_EQ(p[3 * page], 0xee);
+    EXPECT_FALSE(discardPages(p + 1, page));
+    freePages(p, 4 * page);
+    EXPECT_GT(getHugePageSize() == 0 || getHugePageSize() >= page, 0);
+}
+
+TEST(XPlatform, CpuInfoHasPerCoreTopology) {
+    auto info = getCpuInfo();
+    ASSERT_FALSE(info.cores.empty());
+    EXPECT_EQ(static_cast<int>(info.cores.size()), info.coreCount);
+    EXPECT_FALSE(getPerformanceCores(info.cores).empty());
+}
+
+TEST(XPlatform, ThreadAffinityAndName) {
+    std::thread t([] {
+        auto allowed = getThreadAffinity();
+        ASSERT_FALSE(allowed.empty());
+        EXPECT_TRUE(setThreadAffinity({allowed.front()}));
+        EXPECT_EQ(getThreadAffinity(), (std::vector<int>{allowed.front()}));
+        EXPECT_FALSE(setThreadAffinity({}));
+
+        EXPECT_TRUE(setThreadName("aura-test-thread-long-name"));
+        char name[32] = {};
+        pthread_getname_np(pthread_self(), name, sizeof(name));
+        EXPECT_STREQ(name, "aura-test-threa");
+
+        EXPECT_TRUE(setThreadScheduling(SchedPolicy::Batch, 5));
+    });
+    t.join();
+}
+
+TEST(XPlatform, CurrentCpuIsAllowed) {
+    auto allowed = getThreadAffinity();
+    int cpu = getCurrentCpu();
+    EXPECT_GE(cpu, 0);
+    EXPECT_NE(std::find(allowed.begin(), allowed.end(), cpu), allowed.end());
+}
+#endif
+
 #endif  // ENABLE_TEST_XPLATFORM
@@ -0,0 +1,175 @@
+#if ENABLE_TEST_XPOOL_RESOURCE
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "memory/xbuffer.h"
+#include "memory/xmemory_resource.h"
+#include "memory/xpage_resource.h"
+#include "memory/xpool_resource.h"
+
+using au::memory::XBuffer;
+
+namespace {
+
+struct CountingResource : au::memory::XMemoryResource {
+    int    allocs = 0, frees = 0;
+    size_t live   = 0;
+
+    void* allocate(size_t bytes, size_t alignment) override {
+        ++allocs;
+        live += bytes;
+        return au::memory::defaultResource()->allocate(bytes, alignment);
+    }
+    void deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++frees;
+        live -= bytes;
+        au::memory::defaultResource()->deallocate(p, bytes, alignment);
+    }
+};
+
+}  // namespace
+
+using au::memory::XPoolOptions;
+using au::memory::XPoolResource;
+
+TEST(XPoolResource, SizeClasses) {
+    EXPECT_EQ(XPoolResource::roundUp(1), 64u);
+    EXPECT_EQ(XPoolResource::roundUp(64), 64u);
+    EXPECT_EQ(XPoolResource::roundUp(65), 80u);
+    EXPECT_EQ(XPoolResource::roundUp(128), 128u);
+    EXPECT_EQ(XPoolResource::roundUp(129), 160u);
+    EXPECT_EQ(XPoolResource::roundUp(12000000), 12582912u);  // 12 MP luma plane
+    for (size_t n = 1; n < (1u << 20); n = n * 3 / 2 + 1) {
+        const size_t c = XPoolResource::roundUp(n);
+        EXPECT_GE(c, n);
+        EXPECT_LE(c, std::max<size_t>(64, n + n / 4));
+        EXPECT_EQ(XPoolResource::roundUp(c), c);
+    }
+}
+
+TEST(XPoolResource, ReusesFreedBlocks) {
+    CountingResource upstream;
+    XPoolOptions     opt;
+    opt.upstream = &upstream;
+    {
+        XPoolResource pool(opt);
+        void* a = pool.allocate(1000, 64);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(a) % 64, 0u);
+        pool.deallocate(a, 1000, 64);
+        EXPECT_EQ(pool.stats().cachedBlocks, 1u);
+
+        void* b = pool.allocate(990);  // same class
+        EXPECT_EQ(b, a);
+        pool.deallocate(b, 990);
+
+        auto stats = pool.stats();
+        EXPECT_EQ(stats.hits, 1u);
+        EXPECT_EQ(stats.misses, 1u);
+        EXPECT_EQ(stats.cachedBytes, XPoolResource::roundUp(1000));
+        EXPECT_EQ(upstream.allocs, 1);
+
+        // Over-aligned requests bypass the free lists.
+        void* page = pool.allocate(100, au::memory::kPageAlignment);
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(page) % 4096, 0u);
+        pool.deallocate(page, 100, au::memory::kPageAlignment);
+        EXPECT_EQ(pool.stats().cachedBlocks, 1u);
+    }
+    EXPECT_EQ(upstream.frees, upstream.allocs);  // the destructor trims
+    EXPECT_EQ(upstream.live, 0u);
+}
+
+TEST(XPoolResource, CapAndTrim) {
+    CountingResource upstream;
+    XPoolOptions     opt;
+    opt.upstream       = &upstream;
+    opt.maxCachedBytes = 3000;
+    XPoolResource pool(opt);
+
+    std::vector<void*> blocks;
+    for (int i = 0; i < 4; ++i) blocks.push_back(pool.allocate(1024));
+    for (void* p : blocks) pool.deallocate(p, 1024);
+    EXPECT_EQ(pool.stats().cachedBlocks, 2u);
+    EXPECT_EQ(pool.stats().overflows, 2u);
+    EXPECT_EQ(upstream.frees, 2);
+
+    void* live = pool.allocate(10);  // one 64-byte block stays in use
+    EXPECT_EQ(pool.trim(1024), 1024u);
+    EXPECT_EQ(pool.stats().cachedBytes, 1024u);
+    EXPECT_EQ(pool.trim(), 1024u);
+    EXPECT_EQ(pool.stats().cachedBlocks, 0u);
+    EXPECT_EQ(pool.stats().trimmedBytes, 2048u);
+    EXPECT_EQ(pool.trimIfLowMemory(0), 0u);  // never "low"
+    EXPECT_EQ(upstream.live, 64u);
+    pool.deallocate(live, 10);
+}
+
+TEST(XPoolResource, SteadyStateBuffersSkipUpstream) {
+    CountingResource upstream;
+    XPoolOptions     opt;
+    opt.upstream = &upstream;
+    XPoolResource pool(opt);
+    for (int frame = 0; frame < 100; ++frame) {
+        auto buf = XBuffer<uint8_t>(100000, au::memory::XBufferOptions{0, false, &pool});
+        buf[0] = uint8_t(frame);
+    }
+    EXPECT_EQ(upstream.allocs, 2);  // elements and control block, once
+    EXPECT_EQ(pool.stats().hits, 198u);
+}
+
+TEST(XPoolResource, ConcurrentAllocFree) {
+    XPoolResource pool;
+    const int     threads = 4, iters = 20000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&pool, t] {
+            for (int i = 0; i < iters; ++i) {
+                const size_t bytes = 64u << ((i + t) % 8);
+                auto*        p     = static_cast<uint8_t*>(pool.allocate(bytes));
+                p[0] = p[bytes - 1] = uint8_t(i);
+                pool.deallocate(p, bytes);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+    auto stats = pool.stats();
+    EXPECT_EQ(stats.hits + stats.misses, uint64_t(threads) * iters);
+    EXPECT_LE(stats.misses, uint64_t(threads) * 8);
+    EXPECT_EQ(pool.trim(), stats.cachedBytes);
+}
+
+TEST(XPoolResource, DiscardsIdleLargeBlocks) {
+    au::memory::XPageResource pages;
+    XPoolOptions              opt;
+    opt.upstream     = &pages;
+    opt.discardBytes = 64 << 10;
+    XPoolResource pool(opt);
+
+    const size_t bytes = 1 << 20;
+    auto*        p     = static_cast<uint8_t*>(pool.allocate(bytes));
+    std::memset(p, 0x11, bytes);
+    pool.deallocate(p, bytes);
+    const bool onLinux = au::sys::kBuildPlatform == au::sys::Platform::Linux;
+    if (onLinux) {
+        ASSERT_GT(pool.stats().discards, 0u);
+    } else {
+        EXPECT_EQ(pool.stats().discards, 0u);
+    }
+
+    auto* q = static_cast<uint8_t*>(pool.allocate(bytes));
+    EXPECT_EQ(q, p);  // same address range, reused
+    if (onLinux) {
+        EXPECT_EQ(q[bytes / 2], 0);  // discarded pages fault back in zeroed
+    }
+    q[bytes - 1] = 1;
+    pool.deallocate(q, bytes);
+
+    void* small = pool.allocate(1000);  // below the threshold: kept resident
+    pool.deallocate(small, 1000);
+    EXPECT_LE(pool.stats().discards, 2u);
+}
+
+#endif  // ENABLE_TEST_XPOOL_RESOURCE
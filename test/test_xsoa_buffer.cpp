@@ -0,0 +1,147 @@
+#if ENABLE_TEST_XSOA_BUFFER
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "memory/xbuffer.h"
+#include "memory/xmemory_resource.h"
+#include "memory/xsoa_buffer.h"
+
+using au::memory::XBuffer;
+
+namespace {
+
+struct CountingResource : au::memory::XMemoryResource {
+    int    allocs = 0, frees = 0;
+    size_t live   = 0;
+
+    void* allocate(size_t bytes, size_t alignment) override {
+        ++allocs;
+        live += bytes;
+        return au::memory::defaultResource()->allocate(bytes, alignment);
+    }
+    void deallocate(void* p, size_t bytes, size_t alignment) override {
+        ++frees;
+        live -= bytes;
+        au::memory::defaultResource()->deallocate(p, bytes, alignment);
+    }
+};
+
+}  // namespace
+
+namespace {
+enum { kX, kY, kScore, kDesc };
+using Keypoints = au::memory::XSoABuffer<float, float, float, int32_t>;
+}  // namespace
+
+TEST(XSoABuffer, ColumnsAreAlignedInOneBlock) {
+    Keypoints kps(100);
+    EXPECT_EQ(kps.size(), 100u);
+    for (auto* column : {static_cast<const void*>(kps.data<kX>()), static_cast<const void*>(kps.data<kY>()),
+                         static_cast<const void*>(kps.data<kScore>()), static_cast<const void*>(kps.data<kDesc>())}) {
+        EXPECT_EQ(reinterpret_cast<uintptr_t>(column) % 64, 0u);
+    }
+    // Columns are laid out back to back inside one allocation.
+    EXPECT_EQ(reinterpret_cast<const uint8_t*>(kps.data<kY>()) - reinterpret_cast<const uint8_t*>(kps.data<kX>()),
+              448);  // 400 bytes rounded up to a cache line
+    EXPECT_EQ(kps.blockBytes(), 3 * 448u + 400u);
+    EXPECT_EQ(kps.data<kScore>()[99], 0.0f);
+    EXPECT_EQ(kps.column<kDesc>().size(), 100u);
+}
+
+TEST(XSoABuffer, RowsAndAppend) {
+    Keypoints kps;
+    for (int i = 0; i < 100; ++i) kps.append(float(i), float(2 * i), 0.5f, i);
+    EXPECT_EQ(kps.size(), 100u);
+    kps.shrinkToFit();
+    kps.append(kps[1].get<kX>(), 0.f, 0.f, kps[99].get<kDesc>());  // aliases rows across a reallocation
+    EXPECT_EQ(kps[100].get<kX>(), 1.f);
+    EXPECT_EQ(kps[100].get<kDesc>(), 99);
+    kps.resize(100);
+    EXPECT_GE(kps.capacity(), 100u);
+
+    auto row = kps[10];
+    EXPECT_EQ(row.get<kY>(), 20.0f);
+    row.get<kScore>() = 0.75f;
+    EXPECT_EQ(kps.data<kScore>()[10], 0.75f);
+    row.set(1.f, 2.f, 3.f, 4);
+    auto [x, y, score, desc] = kps.row(10).tie();
+    EXPECT_EQ(x, 1.f);
+    EXPECT_EQ(desc, 4);
+    x = 9.f;  // references into the columns
+    EXPECT_EQ(kps.data<kX>()[10], 9.f);
+
+    const Keypoints& cref = kps;
+    EXPECT_EQ(std::get<kDesc>(cref[99].value()), 99);
+    float sum = 0;
+    for (float s : cref.column<kScore>()) sum += s;
+    EXPECT_FLOAT_EQ(sum, 99 * 0.5f + 3.f);
+}
+
+TEST(XSoABuffer, ReserveResizeAndCopies) {
+    CountingResource res;
+    {
+        Keypoints kps(0, au::memory::XBufferOptions{0, true, &res});
+        kps.reserve(1000);
+        EXPECT_EQ(kps.capacity(), 1000u);
+        EXPECT_TRUE(kps.empty());
+        const int allocs = res.allocs;
+        for (int i = 0; i < 1000; ++i) kps.append(1.f, 2.f, 3.f, i);
+        EXPECT_EQ(res.allocs, allocs);  // no reallocation within the reservation
+
+        kps.resize(1500);
+        EXPECT_EQ(kps.data<kDesc>()[999], 999);
+        EXPECT_EQ(kps.data<kDesc>()[1499], 0);
+        kps.resize(10);
+        EXPECT_EQ(kps.size(), 10u);
+
+        Keypoints copy = kps;  // deep
+        copy.data<kX>()[0] = -1.f;
+        EXPECT_EQ(kps.data<kX>()[0], 1.f);
+        EXPECT_EQ(copy.capacity(), 10u);
+        EXPECT_EQ(copy.options().resource, &res);
+
+        Keypoints moved = std::move(copy);
+        EXPECT_EQ(moved.data<kX>()[0], -1.f);
+        EXPECT_TRUE(copy.empty());
+
+        kps.shrinkToFit();
+        EXPECT_EQ(kps.capacity(), 10u);
+        kps.clear();
+        EXPECT_TRUE(kps.empty());
+        EXPECT_EQ(kps.capacity(), 10u);
+    }
+    EXPECT_EQ(res.live, 0u);
+}
+
+TEST(XSoABuffer, Bench_column_scan_vs_aos) {
+    struct Keypoint {
+        float   x, y, score;
+        int32_t desc;
+    };
+    const size_t      n = 1 << 20;
+    XBuffer<Keypoint> aos(n);
+    Keypoints         soa(n);
+    for (size_t i = 0; i < n; ++i) {
+        aos[i].score          = float(i & 7);
+        soa.data<kScore>()[i] = float(i & 7);
+    }
+    auto time = [](auto&& fn) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < 20; ++r) fn();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count() / 20;
+    };
+    double aosMs = time([&] {
+        for (size_t i = 0; i < n; ++i) aos[i].score *= 0.5f;
+    });
+    double soaMs = time([&] {
+        float* score = soa.data<kScore>();
+        for (size_t i = 0; i < n; ++i) score[i] *= 0.5f;
+    });
+    printf("[  BENCH   ] scale 1M scores: AoS %.3f ms  SoA %.3f ms\n", aosMs, soaMs);
+}
+
+#endif  // ENABLE_TEST_XSOA_BUFFER